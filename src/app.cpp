@@ -49,11 +49,13 @@
 #include "gfx/spritemanager.h"
 #include "gfx/screen.h"
 #include "sound/audio.h"
+#include "utils/assetcache.h"
 #include "utils/ccrc32.h"
 #include "utils/file.h"
 #include "utils/log.h"
 #include "utils/configfile.h"
 #include "utils/portablefile.h"
+#include "utils/profiler.h"
 #include "agent.h"
 #include "menus/gamemenufactory.h"
 #include "menus/gamemenuid.h"
@@ -79,6 +81,66 @@ session_(new GameSession()), game_ctlr_(new GameController),
 App::~App() {
 }
 
+/*!
+ * A loading task calling methods of an object.
+ */
+template <class T>
+class MethodTask : public AssetTask {
+public:
+    typedef bool (T::*Method)();
+
+    MethodTask(T *pObject, Method decodeMethod, Method finishMethod = NULL) {
+        p_object_ = pObject;
+        decode_ = decodeMethod;
+        finish_ = finishMethod;
+    }
+
+    bool decode() { return (p_object_->*decode_)(); }
+    bool finish() { return finish_ == NULL || (p_object_->*finish_)(); }
+
+protected:
+    T *p_object_;
+    Method decode_;
+    Method finish_;
+};
+
+/*!
+ * Loads the game sprites and animations.
+ */
+class GameSpritesTask : public AssetTask {
+public:
+    GameSpritesTask(GameSpriteManager *pSprites) { p_sprites_ = pSprites; }
+
+    bool decode() {
+        if (!p_sprites_->loaded()) {
+            p_sprites_->load();
+        }
+        return p_sprites_->loaded();
+    }
+
+protected:
+    GameSpriteManager *p_sprites_;
+};
+
+/*!
+ * Reads a set of samples then creates the sounds on the main thread,
+ * as the audio device is not used by workers.
+ */
+class SoundsTask : public AssetTask {
+public:
+    SoundsTask(SoundManager *pSounds, SoundManager::SampleSet set) {
+        p_sounds_ = pSounds;
+        set_ = set;
+    }
+
+    bool decode() { return p_sounds_->readSounds(set_); }
+    bool finish() { return p_sounds_->createSounds(); }
+
+protected:
+    SoundManager *p_sounds_;
+    SoundManager::SampleSet set_;
+};
+
 static void addMissingSlash(string& str) {
     if (str[str.length() - 1] != '/') str.push_back('/');
 }
@@ -169,6 +231,16 @@ bool App::readConfiguration() {
         context_->setFullScreen(conf.read("fullscreen", false));
         context_->setPlayIntro(conf.read("play_intro", true));
         context_->setTimeForClick(conf.read("time_for_click", 80));
+        context_->setTickRate(conf.read("tick_rate", AppContext::kDefaultTickRate));
+        context_->setMaxFps(conf.read("max_fps", 0));
+        context_->setPathFinderAlgorithm(conf.read("pathfinder", AppContext::kDefaultPathFinder));
+        context_->setPathThreads(conf.read("path_threads", 2));
+        context_->setLoaderThreads(conf.read("loader_threads", 2));
+        context_->setPresentThread(conf.read("present_thread", true));
+        context_->setScale(conf.read("scale", 1));
+        int mapCacheSize = conf.read("map_cache_size", 8);
+        maps_.setCacheSize((mapCacheSize < 0 ? 0 : mapCacheSize) * 1024 * 1024);
+        AssetCache::setEnabled(conf.read("asset_cache", true));
         bool origDataDirFound = conf.readInto(origDataDir, "data_dir");
         bool ourDataDirFound = conf.readInto(ourDataDir, "freesynd_data_dir");
 
@@ -226,8 +298,11 @@ bool App::testOriginalData() {
     bool test_files = true;
     ConfigFile conf(iniPath_);
     conf.readInto(test_files, "test_data", true);
-    if (test_files == false)
+    if (test_files == false) {
+        // files passed the test on a previous run
+        File::setDataVerified(true);
         return true;
+    }
 
     std::string crcflname = File::dataFullPath("ref/original_data.crc");
     std::ifstream od(crcflname.c_str());
@@ -299,6 +374,7 @@ bool App::testOriginalData() {
         } catch (...) {
             LOG(Log::k_FLG_GFX, "App", "testOriginalData", ("Could not update configuration file!"))
         }
+        File::setDataVerified(true);
         printf("Test passed. crc32 for data is correct.\n");
         LOG(Log::k_FLG_GFX, "App", "testOriginalData", ("Test passed. CRC32 for data is correct."));
     }
@@ -344,40 +420,103 @@ bool App::initialize(const std::string& iniPath) {
     }
 
     LOG(Log::k_FLG_INFO, "App", "initialize", ("initializing system..."))
-    if (!system_->initialize(context_->isFullScreen())) {
+    if (!system_->initialize(context_->isFullScreen(), context_->isPresentThread(),
+            context_->scale())) {
         return false;
     }
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("initializing menus..."))
-    if (!menus_.initialize(context_->isPlayIntro())) {
+    LOG(Log::k_FLG_INFO, "App", "initialize", ("starting to load data..."))
+    addLoadingTasks();
+    loader_.start(context_->loaderThreads());
+
+    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading game data..."))
+    g_gameCtrl.agents().loadAgents();
+    if (!reset()) {
         return false;
     }
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("loading game sprites..."))
-    if (!gameSprites().loaded())
-        gameSprites().load();
+    // Only the data of the first menu is waited for : the rest is
+    // loaded while it is displayed
+    LOG(Log::k_FLG_INFO, "App", "initialize", ("initializing menus..."))
+    return waitForAssets(fs_game_assets::kAssetFonts);
+}
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("loading game tileset..."))
-    if (!maps().initialize()) {
-        return false;
+/*!
+ * Groups are decoded in the order they are added here, as soon as
+ * the groups they depend on are decoded : data of the first menu comes
+ * first.
+ */
+void App::addLoadingTasks() {
+    using namespace fs_game_assets;
+
+    uint32 fontSprites = kAssetMenuSprites;
+    loader_.addTask(kAssetMenuSprites, "menu sprites",
+        new MethodTask<MenuManager>(&menus_, &MenuManager::loadMenuSprites));
+    if (context_->isPlayIntro()) {
+        loader_.addTask(kAssetIntroFont, "intro font", new MethodTask<MenuManager>(
+            &menus_, &MenuManager::loadIntroFontSprites));
+        fontSprites |= kAssetIntroFont;
     }
+    loader_.addTask(kAssetFonts, "fonts",
+        new MethodTask<MenuManager>(&menus_, &MenuManager::loadFonts), fontSprites);
 
+    loader_.addTask(kAssetMusic, "music", new MethodTask<MusicManager>(
+        &music_, &MusicManager::convertMusic, &MusicManager::createTracks));
+    loader_.addTask(kAssetGameSounds, "game sounds",
+        new SoundsTask(&game_sounds_, SoundManager::SAMPLES_GAME));
     if (context_->isPlayIntro()) {
-        LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading intro sounds..."))
-        if (!intro_sounds_.loadSounds(SoundManager::SAMPLES_INTRO)) {
-            return false;
-        }
+        loader_.addTask(kAssetIntroSounds, "intro sounds",
+            new SoundsTask(&intro_sounds_, SoundManager::SAMPLES_INTRO));
     }
+    loader_.addTask(kAssetGameSprites, "game sprites",
+        new GameSpritesTask(&game_sprites_));
+    loader_.addTask(kAssetTiles, "tiles",
+        new MethodTask<MapManager>(&maps_, &MapManager::initialize));
+}
+
+/*!
+ * Data not used by the first menu is loaded in the background : code
+ * using it calls this method first, which returns at once when the data
+ * is already there.
+ * \param assets Mask of fs_game_assets values
+ * \return False if some data could not be loaded : the game stops then,
+ * as it would have at startup.
+ */
+bool App::waitForAssets(uint32 assets) {
+    if (!loader_.waitFor(assets)) {
+        FSERR(Log::k_FLG_IO, "App", "waitForAssets", ("Failed loading game data\n"));
+        running_ = false;
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * Initialize the application without video, sound nor menus.
+ * Only the data used by the game simulation is loaded : used by tools
+ * that run missions without a player.
+ * \param iniPath The path to the config file.
+ * \return True if initialization is ok.
+ */
+bool App::initializeHeadless(const std::string& iniPath) {
+    iniPath_ = iniPath;
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading game sounds..."))
-    if (!game_sounds_.loadSounds(SoundManager::SAMPLES_GAME)) {
+    LOG(Log::k_FLG_INFO, "App", "initializeHeadless", ("reading configuration..."))
+    if (!readConfiguration()) {
+        LOG(Log::k_FLG_GFX, "App", "initializeHeadless", ("failed to read configuration..."))
         return false;
     }
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading music..."))
-    music_.loadMusic();
+    LOG(Log::k_FLG_INFO, "App", "initializeHeadless", ("loading game sprites..."))
+    if (!gameSprites().loaded())
+        gameSprites().load();
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading game data..."))
+    LOG(Log::k_FLG_INFO, "App", "initializeHeadless", ("loading game tileset..."))
+    if (!maps().initialize()) {
+        return false;
+    }
+
+    LOG(Log::k_FLG_INFO, "App", "initializeHeadless", ("Loading game data..."))
     g_gameCtrl.agents().loadAgents();
     return reset();
 }
@@ -551,6 +690,7 @@ bool App::reset() {
  * Destroy the application.
  */
 void App::destroy() {
+    loader_.stop();
     game_ctlr_->clearAllListeners();
     menus_.destroy();
 
@@ -624,22 +764,61 @@ void App::run(int start_mission) {
         menus_.gotoMenu(fs_game_menus::kMenuIdBrief);
     }
 
+    // The simulation advances by fixed steps whatever the frame rate is :
+    // real time is accumulated and consumed step by step, so a slow frame
+    // results in several steps and a fast one in none.
+    const int tickStep = context_->tickStep();
+    const int minFrameTime = context_->maxFps() > 0 ? 1000 / context_->maxFps() : 0;
     int lasttick = SDL_GetTicks();
+    int lastframe = lasttick;
+    int accumulator = 0;
     while (running_) {
         int curtick = SDL_GetTicks();
         int diff_ticks = curtick - lasttick;
+        lasttick = curtick;
         menus_.updtSinceMouseDown(diff_ticks);
-        menus_.handleEvents();
-        if (diff_ticks < 30) {
-            SDL_Delay(30 - diff_ticks);
-            continue;
+        {
+            ProfileScope scope(Profiler::kSectionEvents);
+            menus_.handleEvents();
+        }
+        // data loaded in the background is made available, a group a frame
+        loader_.update();
+
+        accumulator += diff_ticks;
+        if (accumulator > kMaxStepsPerFrame * tickStep) {
+            // Machine is too slow : drop time instead of trying to catch up
+            // forever.
+            accumulator = kMaxStepsPerFrame * tickStep;
+        }
+        while (accumulator >= tickStep && running_) {
+            ProfileScope scope(Profiler::kSectionTick);
+            menus_.handleTick(tickStep);
+            accumulator -= tickStep;
+        }
+
+        if (curtick - lastframe >= minFrameTime) {
+            {
+                ProfileScope scope(Profiler::kSectionUiRender);
+                menus_.renderMenu();
+            }
+            {
+                ProfileScope scope(Profiler::kSectionPresent);
+                system_->updateScreen();
+            }
+            lastframe = curtick;
+            Profiler::endFrame();
+        }
+
+        // Sleep until the next step is due, but keep polling input
+        // at least every kMaxIdleDelay ms
+        int wait = tickStep - accumulator - (SDL_GetTicks() - curtick);
+        if (wait > 0) {
+            SDL_Delay(wait < kMaxIdleDelay ? wait : kMaxIdleDelay);
         }
-        menus_.handleTick(diff_ticks);
-        menus_.renderMenu();
-        lasttick = curtick;
-        system_->updateScreen();
     }
 
+    Profiler::stopTrace();
+
 #ifdef GP2X
 #ifndef WIN32
     // return to the menu
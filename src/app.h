@@ -49,6 +49,8 @@
 #include "sound/soundmanager.h"
 #include "sound/musicmanager.h"
 #include "appcontext.h"
+#include "gameassetid.h"
+#include "utils/assetloader.h"
 #include "core/gamesession.h"
 #include "core/gamecontroller.h"
 
@@ -63,6 +65,8 @@ class App : public Singleton < App > {
 
     //! Initialize application
     bool initialize(const std::string& iniPath);
+    //! Initialize only what is needed to run the simulation
+    bool initializeHeadless(const std::string& iniPath);
 
     void setCheatCode(const char *name);
 
@@ -90,6 +94,9 @@ class App : public Singleton < App > {
         return music_;
     }
 
+    //! Waits until the given groups of data are loaded
+    bool waitForAssets(uint32 assets);
+
     //! Main application method
     void run(int start_mission);
     //! Reset the application data
@@ -130,6 +137,9 @@ private:
     //! Sets the intro flag to false in the config file
     void updateIntroFlag();
 
+    //! Adds the startup loading tasks to the loader
+    void addLoadingTasks();
+
     void cheatFunds() {
         g_Session.setMoney(100000000);
     }
@@ -145,6 +155,11 @@ private:
     void cheatEquipFancyWeapons();
 
 private:
+    /*! Maximum number of simulation steps run between two frames.*/
+    static const int kMaxStepsPerFrame = 5;
+    /*! Maximum time in ms the main loop sleeps without polling events.*/
+    static const int kMaxIdleDelay = 10;
+
     bool running_;
     /*! A structure to hold general application informations.*/
     std::auto_ptr<AppContext> context_;
@@ -163,6 +178,11 @@ private:
     SoundManager intro_sounds_;
     SoundManager game_sounds_;
     MusicManager music_;
+    /*!
+     * Loads data in the background at startup. It is declared last so its
+     * threads are stopped before the data is destroyed.
+     */
+    AssetLoader loader_;
 };
 
 #define g_App   App::singleton()
@@ -32,6 +32,13 @@ AppContext::AppContext() {
     fullscreen_ = false;
     playIntro_ = true;
     language_ = NULL;
+    tick_step_ = 1000 / kDefaultTickRate;
+    max_fps_ = 0;
+    pathfinder_algo_ = kDefaultPathFinder;
+    path_threads_ = 2;
+    loader_threads_ = 2;
+    present_thread_ = true;
+    scale_ = 1;
 }
 
 AppContext::~AppContext() { 
@@ -41,6 +48,21 @@ AppContext::~AppContext() {
     }
 }
 
+/*!
+ * The rate is clamped between kMinTickRate and kMaxTickRate so that
+ * the game logic, which works with integer milliseconds, keeps a
+ * meaningful precision.
+ * \param rate Number of simulation steps per second
+ */
+void AppContext::setTickRate(int rate) {
+    if (rate < kMinTickRate) {
+        rate = kMinTickRate;
+    } else if (rate > kMaxTickRate) {
+        rate = kMaxTickRate;
+    }
+    tick_step_ = 1000 / rate;
+}
+
 void AppContext::setLanguage(FS_Lang lang) {
     std::string filename(File::dataFullPath("lang/"));
     switch (lang) {
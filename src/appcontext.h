@@ -46,6 +46,15 @@ public:
         GERMAN = 3
     };
 
+    /*! Default number of simulation steps per second.*/
+    static const int kDefaultTickRate = 30;
+    /*! Default path finding algorithm (see PathFinder::Algorithm) : A*.*/
+    static const int kDefaultPathFinder = 1;
+    /*! Minimum number of simulation steps per second.*/
+    static const int kMinTickRate = 10;
+    /*! Maximum number of simulation steps per second.*/
+    static const int kMaxTickRate = 100;
+
     AppContext();
     ~AppContext();
 
@@ -58,6 +67,35 @@ public:
     void setTimeForClick(int32 time) { time_for_click_ = time; }
     int32 getTimeForClick() { return time_for_click_; }
 
+    //! Sets the number of simulation steps per second
+    void setTickRate(int rate);
+    //! Returns the duration of a simulation step in milliseconds
+    int tickStep() { return tick_step_; }
+
+    //! Sets the maximum number of frames rendered per second (0 means no limit)
+    void setMaxFps(int fps) { max_fps_ = fps < 0 ? 0 : fps; }
+    int maxFps() { return max_fps_; }
+
+    //! Sets the path finding algorithm (see PathFinder::Algorithm)
+    void setPathFinderAlgorithm(int algo) { pathfinder_algo_ = algo; }
+    int pathFinderAlgorithm() { return pathfinder_algo_; }
+
+    //! Sets the number of threads searching paths (0 means no thread)
+    void setPathThreads(int nb) { path_threads_ = nb < 0 ? 0 : nb; }
+    int pathThreads() { return path_threads_; }
+
+    //! Sets the number of threads loading data at startup (0 means no thread)
+    void setLoaderThreads(int nb) { loader_threads_ = nb < 0 ? 0 : nb; }
+    int loaderThreads() { return loader_threads_; }
+
+    //! Sets whether frames are converted to the display by a thread
+    void setPresentThread(bool thread) { present_thread_ = thread; }
+    bool isPresentThread() { return present_thread_; }
+
+    //! Sets the size of the game pixels on the display (1 to 4)
+    void setScale(int scale) { scale_ = scale < 1 ? 1 : (scale > 4 ? 4 : scale); }
+    int scale() { return scale_; }
+
     void setLanguage(FS_Lang lang);
     FS_Lang currLanguage(void) {return curr_language_; }
     std::string getMessage(const std::string & id);
@@ -72,6 +110,20 @@ private:
      * if it will be longer it will be treated as dragging
     */
     int32 time_for_click_;
+    /*! Duration in milliseconds of a fixed simulation step.*/
+    int tick_step_;
+    /*! Maximum number of frames per second. 0 means rendering is not throttled.*/
+    int max_fps_;
+    /*! Path finding algorithm used by missions.*/
+    int pathfinder_algo_;
+    /*! Number of worker threads for path searches.*/
+    int path_threads_;
+    /*! Number of worker threads loading data at startup.*/
+    int loader_threads_;
+    /*! True if frames are converted to the display by a thread.*/
+    bool present_thread_;
+    /*! Size of the game pixels on the display.*/
+    int scale_;
     /*! Language file. */
     ConfigFile  *language_;
     FS_Lang curr_language_;
@@ -0,0 +1,270 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+/*
+ * Compares the blit kernels on the game sprites and tiles.
+ * Each kernel set available on the CPU draws the same images at the same
+ * positions, some of them clipped by the screen borders. The time of each
+ * pass and a checksum of the screen are printed : all sets must give the
+ * same checksum as the scalar one.
+ * The images are also drawn with their runs of opaque pixels, as the game
+ * draws sprites and tiles : these rows must give the checksum of the
+ * plain blit. Only flipped runs go through the kernels.
+ */
+
+#include <memory>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "app.h"
+#include "gfx/blitkernels.h"
+#include "gfx/pixelspans.h"
+#include "gfx/screen.h"
+#include "gfx/sprite.h"
+#include "gfx/tile.h"
+#include "gfx/tilemanager.h"
+
+#ifdef SYSTEM_SDL
+#ifdef _WIN32
+#undef main
+#else
+#include <SDL_main.h>           //This is required on OSX for remapping of main()
+#endif
+#endif
+
+/*!
+ * An image to draw.
+ */
+struct Image {
+    int width;
+    int height;
+    std::vector<uint8> pixels;
+    /*! Runs of opaque pixels, built by buildSpans().*/
+    PixelSpans *pSpans;
+};
+
+/*!
+ * The kind of blit measured.
+ */
+enum BlitMode {
+    kBlitNormal,
+    kBlitFlipped,
+    kBlitScaled,
+    kBlitSpans,
+    kBlitSpansFlipped
+};
+
+void print_usage() {
+    printf("usage: blitbench [options...]\n");
+    printf("    -h, --help            display this help and exit.\n");
+    printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
+    printf("    -p, --passes <num>    number of passes for each measure (default: 50).\n");
+}
+
+uint32 checksum(const uint8 *pixels, int size) {
+    uint32 sum = 0;
+    for (int i = 0; i < size; i++) {
+        sum = sum * 31 + pixels[i];
+    }
+    return sum;
+}
+
+/*!
+ * Draws all images nbPasses times.
+ * \return Time in milliseconds for one pass
+ */
+double runPasses(const std::vector<Image> &images, BlitMode mode, int nbPasses) {
+    int screenW = g_Screen.gameScreenWidth();
+    int screenH = g_Screen.gameScreenHeight();
+    clock_t start = clock();
+    for (int pass = 0; pass < nbPasses; pass++) {
+        for (size_t i = 0; i < images.size(); i++) {
+            const Image &img = images[i];
+            // spreads images over the screen and a bit out of it
+            int x = (int) ((i * 37 + pass * 13) % (screenW + 64)) - 32;
+            int y = (int) ((i * 53 + pass * 7) % (screenH + 64)) - 32;
+            if (mode == kBlitScaled) {
+                // scale2x does not clip
+                if (img.width * 2 > screenW || img.height * 2 > screenH) {
+                    continue;
+                }
+                x = (x < 0 ? 0 : x) % (screenW - img.width * 2 + 1);
+                y = (y < 0 ? 0 : y) % (screenH - img.height * 2 + 1);
+                g_Screen.scale2x(x, y, img.width, img.height, &img.pixels[0]);
+            } else if (mode == kBlitSpans || mode == kBlitSpansFlipped) {
+                g_Screen.blitSpans(x, y, img.width, img.height, *img.pSpans,
+                    &img.pixels[0], mode == kBlitSpansFlipped);
+            } else {
+                g_Screen.blit(x, y, img.width, img.height, &img.pixels[0],
+                    mode == kBlitFlipped);
+            }
+        }
+    }
+    return (double) (clock() - start) * 1000.0 / CLOCKS_PER_SEC / nbPasses;
+}
+
+void benchmark(const char *name, const std::vector<Image> &images, BlitMode mode,
+        int nbPasses) {
+    const BlitKernels *pDefault = g_Screen.blitKernels();
+    for (int k = 0; k < BlitKernels::numAvailable(); k++) {
+        const BlitKernels *pKernels = BlitKernels::available(k);
+        g_Screen.setBlitKernels(pKernels);
+        g_Screen.clear(0);
+        double time = runPasses(images, mode, nbPasses);
+        printf("%-16s %-8s %9.3f ms/pass   checksum %08x\n", name, pKernels->name,
+            time, checksum(g_Screen.pixels(),
+                g_Screen.gameScreenWidth() * g_Screen.gameScreenHeight()));
+    }
+    g_Screen.setBlitKernels(pDefault);
+}
+
+void buildSpans(std::vector<Image> &images) {
+    for (size_t i = 0; i < images.size(); i++) {
+        Image &img = images[i];
+        img.pSpans = new PixelSpans();
+        img.pSpans->build(&img.pixels[0], img.width, img.height, img.width);
+    }
+}
+
+void freeSpans(std::vector<Image> &images) {
+    for (size_t i = 0; i < images.size(); i++) {
+        delete images[i].pSpans;
+        images[i].pSpans = NULL;
+    }
+}
+
+/*!
+ * Converts the screen to 32-bit pixels, as the display thread does.
+ */
+void benchmarkExpand(int nbPasses) {
+    int size = g_Screen.gameScreenWidth() * g_Screen.gameScreenHeight();
+    std::vector<uint32> display(size);
+    uint32 palette[256];
+    for (int i = 0; i < 256; i++) {
+        palette[i] = i * 0x010203;
+    }
+    for (int k = 0; k < BlitKernels::numAvailable(); k++) {
+        const BlitKernels *pKernels = BlitKernels::available(k);
+        clock_t start = clock();
+        for (int pass = 0; pass < nbPasses; pass++) {
+            pKernels->expandPalette(&display[0], g_Screen.pixels(), size, palette);
+        }
+        double time = (double) (clock() - start) * 1000.0 / CLOCKS_PER_SEC / nbPasses;
+        printf("%-16s %-8s %9.3f ms/pass   checksum %08x\n", "palette", pKernels->name,
+            time, checksum((const uint8 *) &display[0], size * 4));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string iniPath;
+    int nbPasses = 50;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-h", argv[i]) || 0 == strcmp("--help", argv[i])) {
+            print_usage();
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        if (0 == strcmp("-i", argv[i]) || 0 == strcmp("--ini", argv[i])) {
+            iniPath = argv[++i];
+        } else if (0 == strcmp("-p", argv[i]) || 0 == strcmp("--passes", argv[i])) {
+            nbPasses = atoi(argv[++i]);
+            if (nbPasses <= 0) {
+                print_usage();
+                return 1;
+            }
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (iniPath.size() == 0) {
+        iniPath.assign(App::defaultIniFolder());
+        iniPath.append("/freesynd.ini");
+    }
+
+    std::auto_ptr<App> app(new App(true));
+    if (!app->initializeHeadless(iniPath)) {
+        printf("Failed to initialize application with %s\n", iniPath.c_str());
+        return 1;
+    }
+
+    std::vector<Image> sprites;
+    for (int i = 0; i < app->gameSprites().spriteCount(); i++) {
+        Sprite *pSprite = app->gameSprites().sprite(i);
+        if (pSprite->width() == 0 || pSprite->height() == 0) {
+            continue;
+        }
+        Image img;
+        img.width = pSprite->width();
+        img.height = pSprite->height();
+        img.pixels.resize(img.width * img.height);
+        pSprite->data(&img.pixels[0]);
+        img.pSpans = NULL;
+        sprites.push_back(img);
+    }
+
+    std::vector<Image> tiles;
+    for (int i = 0; i < TileManager::kNumOfTiles; i++) {
+        Tile *pTile = app->maps().tiles().getTile(i);
+        Image img;
+        img.width = TILE_WIDTH;
+        img.height = TILE_HEIGHT;
+        img.pixels.assign(pTile->pixels(), pTile->pixels() + TILE_WIDTH * TILE_HEIGHT);
+        img.pSpans = NULL;
+        tiles.push_back(img);
+    }
+
+    buildSpans(sprites);
+    buildSpans(tiles);
+
+    printf("%d sprites, %d tiles, %d passes, default kernels : %s\n",
+        (int) sprites.size(), (int) tiles.size(), nbPasses,
+        g_Screen.blitKernels()->name);
+
+    benchmark("sprites", sprites, kBlitNormal, nbPasses);
+    benchmark("sprites flipped", sprites, kBlitFlipped, nbPasses);
+    benchmark("sprites scaled", sprites, kBlitScaled, nbPasses);
+    benchmark("sprites spans", sprites, kBlitSpans, nbPasses);
+    benchmark("sprites spans fl", sprites, kBlitSpansFlipped, nbPasses);
+    benchmark("tiles", tiles, kBlitNormal, nbPasses);
+    benchmark("tiles flipped", tiles, kBlitFlipped, nbPasses);
+    benchmark("tiles spans", tiles, kBlitSpans, nbPasses);
+    benchmark("tiles spans fl", tiles, kBlitSpansFlipped, nbPasses);
+    benchmarkExpand(nbPasses);
+
+    freeSpans(sprites);
+    freeSpans(tiles);
+
+    app->destroy();
+
+    return 0;
+}
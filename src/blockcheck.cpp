@@ -0,0 +1,676 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+/*
+ * Compares Mission::checkBlockedByTile() with the walk it replaced.
+ * The old walk sampled the line every 8 units, the current one visits
+ * every tile crossed by the line. Random lines are checked on the map of
+ * every mission of the original data, or on seeded random surfaces when
+ * the data is not found or with -r.
+ *
+ * Both walks must give the same result. When they don't, the line is
+ * sampled again every 1/64 unit : the current walk must agree with this
+ * fine walk, and the difference is accepted only if it is one of the
+ * known cases where the old walk was wrong :
+ * - corner : the line crosses less than 8 units of a solid tile, between
+ *   two samples of the old walk
+ * - end : the blocker is after the last sample of the old walk, which
+ *   stopped 8 to 16 units before the target
+ * - stairs : the line goes under the slope of stairs between two samples,
+ *   or the old walk rounded the sample to a unit under the slope
+ * - touch : the line only touches a solid part, going through the edge
+ *   of a solid tile or along the slope of stairs. The current walk counts
+ *   it as blocked, as the old one did for a sample on the slope. A line
+ *   that ends on the face of a solid tile is not blocked for it.
+ * Any other difference is printed and makes the program fail.
+ */
+
+#include <memory>
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "common.h"
+#include "app.h"
+#include "mission.h"
+#include "missionmanager.h"
+
+#ifdef SYSTEM_SDL
+#ifdef _WIN32
+#undef main
+#else
+#include <SDL_main.h>           //This is required on OSX for remapping of main()
+#endif
+#endif
+
+/*!
+ * The walk freesynd used before : samples every 8 units.
+ */
+namespace reference {
+
+    uint8 checkBlockedByTile(Mission *m, const WorldPoint & originPosW, WorldPoint *pTargetPosW,
+            bool updateLoc, double distanceMax) {
+        // TODO: some objects mid point is higher then map z
+        assert(distanceMax >= 0);
+
+        int cx = originPosW.x;
+        int cy = originPosW.y;
+        int cz = originPosW.z;
+        if (cz > (m->mmax_z_ - 1) * 128)
+            return Mission::kBMaskBlockerTargetOutOfMap;
+
+        // This variable will store the target location as it may moves if
+        // a tile blocks the path.
+        WorldPoint tmpTargetWLoc = *pTargetPosW;
+
+        if (tmpTargetWLoc.z > (m->mmax_z_ - 1) * 128)
+            return Mission::kBMaskBlockerTargetOutOfMap;
+
+        // This is the distance between the origin and the target
+        double distanceToTarget = 0;
+        distanceToTarget = sqrt((double)((tmpTargetWLoc.x - cx) * (tmpTargetWLoc.x - cx) + (tmpTargetWLoc.y - cy) * (tmpTargetWLoc.y - cy)
+            + (tmpTargetWLoc.z - cz) * (tmpTargetWLoc.z - cz)));
+        uint8 block_mask = 1;
+
+        if (distanceToTarget == 0)
+            return block_mask;
+
+        double sx = (double) cx;
+        double sy = (double) cy;
+        double sz = (double) cz;
+
+        if (distanceToTarget >= distanceMax) {
+            // the distance we have to cross (distanceToTarget) is higher than the maximum
+            // distance we are allowed to cross (distanceMax)
+
+            // update target position according to distanceMax
+            double dist_k = (double)distanceMax / distanceToTarget;
+            tmpTargetWLoc.x = cx + (int)((tmpTargetWLoc.x - cx) * dist_k);
+            tmpTargetWLoc.y = cy + (int)((tmpTargetWLoc.y - cy) * dist_k);
+            tmpTargetWLoc.z = cz + (int)((tmpTargetWLoc.z - cz) * dist_k);
+            // set mask to indicate distanceMax is reached
+            block_mask = 8;
+            if (updateLoc) {
+                *pTargetPosW = tmpTargetWLoc;
+            }
+            distanceToTarget = distanceMax;
+        }
+
+        // NOTE: these values are less then 1.
+        // If they are incremented, time required to check range will be shorter but less precise check,
+        // If decremented longer but more precise.
+        // Increment is (n * 8)
+        double incrX = ((tmpTargetWLoc.x - cx) * 8) / distanceToTarget;
+        double incrY = ((tmpTargetWLoc.y - cy) * 8) / distanceToTarget;
+        double incrZ = ((tmpTargetWLoc.z - cz) * 8) / distanceToTarget;
+
+        int oldx = cx / 256;
+        int oldy = cy / 256;
+        int oldz = cz / 128;
+        double dist_close = distanceToTarget;
+        // look note before, should be same increment
+        double dist_dec = 1.0 * 8;
+
+        while (dist_close > dist_dec) {
+            int nx = (int)sx / 256;
+            int ny = (int)sy / 256;
+            int nz = (int)sz / 128;
+            unsigned char twd = m->mtsurfaces_[nx + ny * m->mmax_x_
+                + nz * m->mmax_m_xy];
+            if (oldx != nx || oldy != ny || oldz != nz
+                || (twd >= 0x01 && twd <= 0x04))
+            {
+                if (!(twd == 0x00 || twd == 0x0C || twd == 0x10)) {
+                    bool is_blocked = false;
+                    int offz = (int)sz % 128;
+                    switch (twd) {
+                        case 0x01:
+                            if (offz <= (127 - (((int)sy % 256) >> 1)))
+                                is_blocked = true;
+                            break;
+                        case 0x02:
+                            if (offz <= (((int)sy % 256) >> 1))
+                                is_blocked = true;
+                            break;
+                        case 0x03:
+                            if (offz <= (((int)sx % 256) >> 1))
+                                is_blocked = true;
+                            break;
+                        case 0x04:
+                            if (offz <= (127 - (((int)sx % 256) >> 1)))
+                                is_blocked = true;
+                            break;
+                        default:
+                            is_blocked = true;
+                    }
+                    if (is_blocked) {
+                        sx -= incrX;
+                        sy -= incrY;
+                        sz -= incrZ;
+                        double dsx = sx - (double)cx;
+                        double dsy = sy - (double)cy;
+                        double dsz = sz - (double)cz;
+                        tmpTargetWLoc.x = (int)sx;
+                        tmpTargetWLoc.y = (int)sy;
+                        tmpTargetWLoc.z = (int)sz;
+                        dist_close = sqrt(dsx * dsx + dsy * dsy + dsz * dsz);
+                        // set mask to indicate path is blocked by a tile
+                        if (block_mask == 1)
+                            block_mask = 16;
+                        else
+                            block_mask |= 16;
+                        if (updateLoc) {
+                            pTargetPosW->x = (int)sx;
+                            pTargetPosW->y = (int)sy;
+                            pTargetPosW->z = (int)sz;
+                        }
+                        break;
+                    }
+                }
+                oldx = nx;
+                oldy = ny;
+                oldz = nz;
+            }
+            sx += incrX;
+            sy += incrY;
+            sz += incrZ;
+            dist_close -= dist_dec;
+        } // end while
+
+        return block_mask;
+    }
+}
+
+/*!
+ * Reason of a difference between the two walks.
+ */
+enum Difference {
+    kDiffNone,
+    kDiffCorner,
+    kDiffEnd,
+    kDiffStairs,
+    kDiffTouch,
+    kDiffUnknown,
+    kNbDiffs
+};
+
+const char *kDiffNames[kNbDiffs] = {
+    "same", "corner", "end", "stairs", "touch", "unknown"
+};
+
+/*! Number of samples per unit of the fine walk.*/
+const int kFineSamples = 64;
+/*! Distance between two samples of the old walk.*/
+const double kOldStep = 8.0;
+/*!
+ * When both walks are blocked by the same tile, the old one reports a
+ * point up to one step further, and both round it to units.
+ */
+const double kPositionTolerance = kOldStep + 4.0;
+/*! The current walk and the fine walk round the position differently.*/
+const double kStopTolerance = 2.0;
+/*! Distance under which a line touches a solid part.*/
+const double kTouchDistance = 2.0;
+/*! Size of the random maps.*/
+const int kRandomMapX = 32;
+const int kRandomMapY = 32;
+const int kRandomMapZ = 8;
+const int kNbRandomMaps = 20;
+
+/*!
+ * Result of the fine walk.
+ */
+struct FineWalk {
+    uint8 mask;
+    /*! Distance of the first point in a blocker from the origin.*/
+    double hitDistance;
+    /*! Length of the line after clipping by the maximum distance.*/
+    double length;
+    /*! Point where the current walk should stop, 8 units before the blocker.*/
+    double stopX, stopY, stopZ;
+    /*! Surface of the blocking tile.*/
+    uint8 surface;
+    /*! Length of the line inside the blocking tile.*/
+    double chord;
+};
+
+/*!
+ * Returns true if the point is in the solid part of its tile.
+ */
+bool isSolid(Mission *m, double x, double y, double z, bool originTile, uint8 *pSurface) {
+    int tx = (int) x / 256;
+    int ty = (int) y / 256;
+    int tz = (int) z / 128;
+    uint8 twd = m->mtsurfaces_[tx + ty * m->mmax_x_ + tz * m->mmax_m_xy];
+    *pSurface = twd;
+    double offx = x - tx * 256;
+    double offy = y - ty * 256;
+    double offz = z - tz * 128;
+    switch (twd) {
+        case 0x01:
+            return 2 * offz + offy <= 254;
+        case 0x02:
+            return 2 * offz - offy <= 0;
+        case 0x03:
+            return 2 * offz - offx <= 0;
+        case 0x04:
+            return 2 * offz + offx <= 254;
+        case 0x00:
+        case 0x0C:
+        case 0x10:
+            return false;
+        default:
+            return !originTile;
+    }
+}
+
+bool isInMap(Mission *m, double x, double y, double z) {
+    return x >= 0 && y >= 0 && z >= 0 && x < m->mmax_x_ * 256
+        && y < m->mmax_y_ * 256 && z < m->mmax_z_ * 128;
+}
+
+/*!
+ * Samples the line every 1/kFineSamples unit, with the same clipping
+ * by the maximum distance as both walks.
+ */
+FineWalk walkFine(Mission *m, const WorldPoint &origin, WorldPoint target,
+        double distanceMax) {
+    FineWalk walk;
+    walk.mask = 1;
+    walk.hitDistance = -1;
+    walk.surface = 0;
+    walk.chord = 0;
+
+    double dx = target.x - origin.x;
+    double dy = target.y - origin.y;
+    double dz = target.z - origin.z;
+    double length = sqrt(dx * dx + dy * dy + dz * dz);
+    if (length >= distanceMax) {
+        double k = distanceMax / length;
+        target.x = origin.x + (int) (dx * k);
+        target.y = origin.y + (int) (dy * k);
+        target.z = origin.z + (int) (dz * k);
+        dx = target.x - origin.x;
+        dy = target.y - origin.y;
+        dz = target.z - origin.z;
+        length = distanceMax;
+        walk.mask = 8;
+    }
+    walk.length = length;
+
+    int nbSamples = (int) (length * kFineSamples) + 1;
+    int originTile = (origin.x / 256) + (origin.y / 256) * m->mmax_x_
+        + (origin.z / 128) * m->mmax_m_xy;
+    for (int i = 0; i <= nbSamples; i++) {
+        double f = (double) i / nbSamples;
+        double x = origin.x + dx * f;
+        double y = origin.y + dy * f;
+        double z = origin.z + dz * f;
+        if (!isInMap(m, x, y, z)) {
+            break;
+        }
+        int tile = ((int) x / 256) + ((int) y / 256) * m->mmax_x_
+            + ((int) z / 128) * m->mmax_m_xy;
+        uint8 surface;
+        if (!isSolid(m, x, y, z, tile == originTile, &surface)) {
+            continue;
+        }
+
+        walk.mask = walk.mask == 1 ? 16 : (walk.mask | 16);
+        walk.surface = surface;
+        walk.hitDistance = length * f;
+        double back = length > 0 ? kOldStep / length : 0;
+        double fs = f - back < 0 ? 0 : f - back;
+        walk.stopX = origin.x + dx * fs;
+        walk.stopY = origin.y + dy * fs;
+        walk.stopZ = origin.z + dz * fs;
+        // length of the line in the tile, from the hit
+        int j = i;
+        while (j <= nbSamples) {
+            double g = (double) j / nbSamples;
+            double gx = origin.x + dx * g;
+            double gy = origin.y + dy * g;
+            double gz = origin.z + dz * g;
+            if (!isInMap(m, gx, gy, gz) || ((int) gx / 256) + ((int) gy / 256) * m->mmax_x_
+                + ((int) gz / 128) * m->mmax_m_xy != tile) {
+                break;
+            }
+            j++;
+        }
+        walk.chord = length * (j - i) / nbSamples;
+        break;
+    }
+
+    return walk;
+}
+
+/*!
+ * Returns true if a point of the line, between the given distances from
+ * the origin, is close to a solid part.
+ */
+bool touchesSolid(Mission *m, const WorldPoint &origin, const WorldPoint &target,
+        double from, double to) {
+    double dx = target.x - origin.x;
+    double dy = target.y - origin.y;
+    double dz = target.z - origin.z;
+    double length = sqrt(dx * dx + dy * dy + dz * dz);
+    int originTile = (origin.x / 256) + (origin.y / 256) * m->mmax_x_
+        + (origin.z / 128) * m->mmax_m_xy;
+    for (double d = from; d <= to; d += 0.25) {
+        for (int n = 0; n < 27; n++) {
+            double x = origin.x + dx * d / length + (n % 3 - 1) * kTouchDistance;
+            double y = origin.y + dy * d / length + (n / 3 % 3 - 1) * kTouchDistance;
+            double z = origin.z + dz * d / length + (n / 9 - 1) * kTouchDistance;
+            if (!isInMap(m, x, y, z)) {
+                continue;
+            }
+            int tile = ((int) x / 256) + ((int) y / 256) * m->mmax_x_
+                + ((int) z / 128) * m->mmax_m_xy;
+            uint8 surface;
+            if (isSolid(m, x, y, z, tile == originTile, &surface)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+double distance(double x1, double y1, double z1, double x2, double y2, double z2) {
+    return sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2) + (z1 - z2) * (z1 - z2));
+}
+
+double distance(const WorldPoint &a, const WorldPoint &b) {
+    return distance(a.x, a.y, a.z, b.x, b.y, b.z);
+}
+
+/*!
+ * Returns the distance from the origin of the projection of the point on
+ * the line, negative if the point is behind the origin.
+ */
+double alongLine(const WorldPoint &origin, const WorldPoint &target, const WorldPoint &p) {
+    double dx = target.x - origin.x;
+    double dy = target.y - origin.y;
+    double dz = target.z - origin.z;
+    return ((p.x - origin.x) * dx + (p.y - origin.y) * dy + (p.z - origin.z) * dz)
+        / sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/*!
+ * Distance from the origin of the last sample of the old walk.
+ */
+double lastOldSample(double length) {
+    // samples are at k * 8 while length - k * 8 > 8
+    int k = (int) ceil((length - kOldStep) / kOldStep) - 1;
+    return k < 0 ? -1 : k * kOldStep;
+}
+
+/*!
+ * Runs both walks on a line and explains their difference.
+ */
+Difference compareLine(Mission *m, const WorldPoint &origin, const WorldPoint &target,
+        double distanceMax) {
+    WorldPoint oldPos = target;
+    WorldPoint newPos = target;
+    uint8 oldMask = reference::checkBlockedByTile(m, origin, &oldPos, true, distanceMax);
+    uint8 newMask = m->checkBlockedByTile(origin, &newPos, true, distanceMax);
+    if (oldMask == newMask && ((newMask & 16) == 0
+        || distance(oldPos, newPos) <= kPositionTolerance)) {
+        return kDiffNone;
+    }
+
+    FineWalk fine = walkFine(m, origin, target, distanceMax);
+    bool sameStop = (newMask & 16) != 0 && (fine.mask & 16) != 0
+        && distance(newPos.x, newPos.y, newPos.z, fine.stopX, fine.stopY,
+            fine.stopZ) <= kStopTolerance;
+    if ((newMask & 16) != 0 && !sameStop) {
+        // the current walk must stop before the fine one, where the line
+        // touches a solid part that the samples of the fine walk miss
+        double from = distance(origin, newPos);
+        if ((fine.mask & 16) != 0 && from > fine.hitDistance) {
+            return kDiffUnknown;
+        }
+        return touchesSolid(m, origin, target, from, from + kOldStep + 2.0)
+            ? kDiffTouch : kDiffUnknown;
+    }
+    if ((newMask & 16) == 0 && (fine.mask & 16) != 0
+        && fine.hitDistance >= fine.length - kTouchDistance) {
+        // the line ends on the face of a solid tile, where the last samples
+        // of the fine walk already are
+        return kDiffTouch;
+    }
+    if (newMask != fine.mask) {
+        return kDiffUnknown;
+    }
+
+    if ((oldMask & 16) != 0 && ((newMask & 16) == 0
+        || alongLine(origin, target, oldPos) < alongLine(origin, target, newPos))) {
+        // The old walk stopped before the first blocker : this happens only
+        // on stairs, when the sample is rounded to a unit under the slope.
+        // The sample is one step after the reported position, which was
+        // rounded down, so points around it are looked at.
+        double length = distance(origin, target);
+        for (double step = kOldStep - 2.0; step <= kOldStep + 2.0; step += 0.25) {
+            for (int n = 0; n < 27; n++) {
+                double sx = oldPos.x + (target.x - origin.x) * step / length + n % 3 - 1;
+                double sy = oldPos.y + (target.y - origin.y) * step / length + n / 3 % 3 - 1;
+                double sz = oldPos.z + (target.z - origin.z) * step / length + n / 9 - 1;
+                if (!isInMap(m, sx, sy, sz)) {
+                    continue;
+                }
+                uint8 surface = m->mtsurfaces_[(int) sx / 256 + ((int) sy / 256) * m->mmax_x_
+                    + ((int) sz / 128) * m->mmax_m_xy];
+                if (surface >= 0x01 && surface <= 0x04) {
+                    return kDiffStairs;
+                }
+            }
+        }
+        return kDiffUnknown;
+    }
+
+    // the old walk missed the first blocker
+    if (fine.hitDistance > lastOldSample(fine.length)) {
+        return kDiffEnd;
+    }
+    if (fine.surface >= 0x01 && fine.surface <= 0x04) {
+        return kDiffStairs;
+    }
+    return fine.chord < kOldStep ? kDiffCorner : kDiffUnknown;
+}
+
+/*!
+ * Compares the walks on random lines of the surfaces of a mission.
+ * \return Number of unknown differences
+ */
+int compareMission(Mission *m, const char *name, int nbLines, int counts[kNbDiffs]) {
+    int local[kNbDiffs];
+    memset(local, 0, sizeof(local));
+    int maxX = m->mmax_x_ * 256;
+    int maxY = m->mmax_y_ * 256;
+    int maxZ = (m->mmax_z_ - 1) * 128;
+
+    for (int i = 0; i < nbLines; i++) {
+        WorldPoint origin, target;
+        origin.x = rand() % maxX;
+        origin.y = rand() % maxY;
+        origin.z = rand() % maxZ;
+        // weapons have a range of a few tiles
+        target.x = origin.x + rand() % 4001 - 2000;
+        target.y = origin.y + rand() % 4001 - 2000;
+        target.z = rand() % maxZ;
+        if (target.x < 0 || target.y < 0 || target.x >= maxX || target.y >= maxY) {
+            i--;
+            continue;
+        }
+        double distanceMax = rand() % 3000;
+
+        Difference diff = compareLine(m, origin, target, distanceMax);
+        local[diff]++;
+        if (diff == kDiffUnknown) {
+            printf("%s : (%d, %d, %d) -> (%d, %d, %d) max %.0f : walks differ\n",
+                name, origin.x, origin.y, origin.z, target.x, target.y, target.z,
+                distanceMax);
+        }
+    }
+
+    printf("%-12s", name);
+    for (int d = 0; d < kNbDiffs; d++) {
+        printf(" %s %6d", kDiffNames[d], local[d]);
+        counts[d] += local[d];
+    }
+    printf("\n");
+
+    return local[kDiffUnknown];
+}
+
+/*!
+ * Fills the surfaces of the mission with random tiles.
+ */
+void fillRandomSurfaces(Mission *m) {
+    m->mmax_x_ = kRandomMapX;
+    m->mmax_y_ = kRandomMapY;
+    m->mmax_z_ = kRandomMapZ;
+    m->mmax_m_xy = kRandomMapX * kRandomMapY;
+    int size = kRandomMapX * kRandomMapY * kRandomMapZ;
+    m->mtsurfaces_ = (uint8 *) malloc(size);
+    for (int i = 0; i < size; i++) {
+        int r = rand() % 100;
+        if (r < 75) {
+            m->mtsurfaces_[i] = 0x00;
+        } else if (r < 85) {
+            m->mtsurfaces_[i] = 0x05;
+        } else if (r < 90) {
+            m->mtsurfaces_[i] = 0x01 + rand() % 4;
+        } else if (r < 95) {
+            m->mtsurfaces_[i] = 0x0C;
+        } else {
+            m->mtsurfaces_[i] = 0x07;
+        }
+    }
+}
+
+void print_usage() {
+    printf("usage: blockcheck [options...]\n");
+    printf("    -h, --help            display this help and exit.\n");
+    printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
+    printf("    -l, --lines <num>     number of lines for each map (default: 20000).\n");
+    printf("    -r, --random          use random surfaces even if data is found.\n");
+    printf("    -s, --seed <num>      seed of the random lines and surfaces (default: 1).\n");
+}
+
+int main(int argc, char *argv[]) {
+    std::string iniPath;
+    int nbLines = 20000;
+    bool randomOnly = false;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-h", argv[i]) || 0 == strcmp("--help", argv[i])) {
+            print_usage();
+            return 1;
+        }
+        if (0 == strcmp("-r", argv[i]) || 0 == strcmp("--random", argv[i])) {
+            randomOnly = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        if (0 == strcmp("-i", argv[i]) || 0 == strcmp("--ini", argv[i])) {
+            iniPath = argv[++i];
+        } else if (0 == strcmp("-l", argv[i]) || 0 == strcmp("--lines", argv[i])) {
+            nbLines = atoi(argv[++i]);
+            if (nbLines <= 0) {
+                print_usage();
+                return 1;
+            }
+        } else if (0 == strcmp("-s", argv[i]) || 0 == strcmp("--seed", argv[i])) {
+            seed = (unsigned int) atoi(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (iniPath.size() == 0) {
+        iniPath.assign(App::defaultIniFolder());
+        iniPath.append("/freesynd.ini");
+    }
+
+    std::auto_ptr<App> app(new App(true));
+    bool hasData = !randomOnly && app->initializeHeadless(iniPath);
+
+    srand(seed);
+    int counts[kNbDiffs];
+    memset(counts, 0, sizeof(counts));
+    int nbUnknown = 0;
+    int nbMaps = 0;
+
+    if (hasData) {
+        MissionManager missionMgr;
+        std::set<int> mapsDone;
+        for (int misId = 1; misId <= 50; misId++) {
+            Mission *pMission = missionMgr.loadMission(misId);
+            if (pMission == NULL) {
+                continue;
+            }
+            if (mapsDone.insert(pMission->mapId()).second) {
+                char name[32];
+                sprintf(name, "map %d", pMission->mapId());
+                nbUnknown += compareMission(pMission, name, nbLines, counts);
+                nbMaps++;
+            }
+            delete pMission;
+        }
+    }
+
+    if (nbMaps == 0) {
+        printf("No mission data, using %d random maps\n", kNbRandomMaps);
+        LevelData::MapInfos mapInfos;
+        memset(&mapInfos, 0, sizeof(mapInfos));
+        for (int i = 0; i < kNbRandomMaps; i++) {
+            Mission *pMission = new Mission(mapInfos);
+            fillRandomSurfaces(pMission);
+            char name[32];
+            sprintf(name, "random %d", i);
+            nbUnknown += compareMission(pMission, name, nbLines, counts);
+            delete pMission;
+        }
+    }
+
+    printf("%-12s", "total");
+    for (int d = 0; d < kNbDiffs; d++) {
+        printf(" %s %6d", kDiffNames[d], counts[d]);
+    }
+    printf("\n%s\n", nbUnknown == 0 ? "all differences are known cases"
+        : "walks differ");
+
+    if (hasData) {
+        app->destroy();
+    }
+
+    return nbUnknown == 0 ? 0 : 1;
+}
@@ -39,6 +39,7 @@ GameController::GameController() {
 GameController::~GameController() {}
 
 void GameController::destroy() {
+    missions_.cancelPreload();
     agents_.destroy();
 }
 
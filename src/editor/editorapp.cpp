@@ -49,6 +49,7 @@
 #include "gfx/spritemanager.h"
 #include "gfx/screen.h"
 #include "sound/audio.h"
+#include "utils/assetcache.h"
 #include "utils/ccrc32.h"
 #include "utils/file.h"
 #include "utils/log.h"
@@ -173,6 +174,9 @@ bool EditorApp::readConfiguration() {
         string ourDataDir;
         context_->setFullScreen(conf.read("fullscreen", false));
         context_->setTimeForClick(conf.read("time_for_click", 80));
+        context_->setPresentThread(conf.read("present_thread", true));
+        context_->setScale(conf.read("scale", 1));
+        AssetCache::setEnabled(conf.read("asset_cache", true));
         bool origDataDirFound = conf.readInto(origDataDir, "data_dir");
         bool ourDataDirFound = conf.readInto(ourDataDir, "freesynd_data_dir");
 
@@ -348,7 +352,8 @@ bool EditorApp::initialize(const std::string& iniPath) {
     }
 
     LOG(Log::k_FLG_INFO, "EditorApp", "initialize", ("initializing system..."))
-    if (!system_->initialize(context_->isFullScreen())) {
+    if (!system_->initialize(context_->isFullScreen(), context_->isPresentThread(),
+            context_->scale())) {
         return false;
     }
 
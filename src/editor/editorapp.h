@@ -41,6 +41,7 @@
 #include "sound/soundmanager.h"
 #include "sound/musicmanager.h"
 #include "appcontext.h"
+#include "gameassetid.h"
 #include "core/gamecontroller.h"
 
 /*!
@@ -78,6 +79,9 @@ class EditorApp : public Singleton < EditorApp > {
         return music_;
     }
 
+    //! Data is loaded by initialize() : there is nothing to wait for
+    bool waitForAssets(uint32 assets) { return true; }
+
     //! Main application method
     void run();
 
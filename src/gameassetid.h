@@ -0,0 +1,45 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef GAMEASSETID_H_
+#define GAMEASSETID_H_
+
+#include "common.h"
+
+/*!
+ * Groups of data loaded in the background at startup : each one is a
+ * bit of the mask given to App::waitForAssets().
+ */
+namespace fs_game_assets {
+    static const uint32 kAssetMenuSprites = 0x01;
+    static const uint32 kAssetIntroFont = 0x02;
+    static const uint32 kAssetFonts = 0x04;
+    static const uint32 kAssetGameSprites = 0x08;
+    static const uint32 kAssetTiles = 0x10;
+    static const uint32 kAssetIntroSounds = 0x20;
+    static const uint32 kAssetGameSounds = 0x40;
+    static const uint32 kAssetMusic = 0x80;
+    /*! Data used to play a mission.*/
+    static const uint32 kAssetsMission = kAssetGameSprites | kAssetTiles
+        | kAssetGameSounds | kAssetMusic;
+};
+
+#endif  // GAMEASSETID_H_
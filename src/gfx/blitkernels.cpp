@@ -0,0 +1,336 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include "gfx/blitkernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BLIT_SSE2
+#define BLIT_AVX2
+#define BLIT_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define BLIT_SSE2
+#define BLIT_TARGET_SSE2
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BLIT_NEON
+#endif
+
+namespace {
+
+const uint8 kTransparent = 255;
+
+//*************************************
+// Scalar kernels
+//*************************************
+void maskedCopyScalar(uint8 *dst, const uint8 *src, int n) {
+    for (int i = 0; i < n; ++i) {
+        uint8 c = src[i];
+        if (c != kTransparent)
+            dst[i] = c;
+    }
+}
+
+void maskedCopyReversedScalar(uint8 *dst, const uint8 *src, int n) {
+    uint8 *d = dst + n - 1;
+    for (int i = 0; i < n; ++i, --d) {
+        uint8 c = src[i];
+        if (c != kTransparent)
+            *d = c;
+    }
+}
+
+void maskedCopyDoubledScalar(uint8 *dst, const uint8 *src, int n) {
+    for (int i = 0; i < n; ++i) {
+        uint8 c = src[i];
+        if (c != kTransparent) {
+            dst[2 * i] = c;
+            dst[2 * i + 1] = c;
+        }
+    }
+}
+
+void expandPaletteScalar(uint32 *dst, const uint8 *src, int n,
+        const uint32 *palette) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        dst[i] = palette[src[i]];
+        dst[i + 1] = palette[src[i + 1]];
+        dst[i + 2] = palette[src[i + 2]];
+        dst[i + 3] = palette[src[i + 3]];
+    }
+    for (; i < n; ++i) {
+        dst[i] = palette[src[i]];
+    }
+}
+
+#ifdef BLIT_SSE2
+//*************************************
+// SSE2 kernels : 16 pixels at a time
+//*************************************
+
+/*!
+ * Writes s where mask is not set and keeps dst elsewhere.
+ */
+BLIT_TARGET_SSE2 inline void blendSse2(uint8 *dst, __m128i s, __m128i mask) {
+    int bits = _mm_movemask_epi8(mask);
+    if (bits == 0xFFFF) {
+        // all transparent
+        return;
+    }
+    if (bits != 0) {
+        __m128i d = _mm_loadu_si128((const __m128i *) dst);
+        s = _mm_or_si128(_mm_and_si128(mask, d), _mm_andnot_si128(mask, s));
+    }
+    _mm_storeu_si128((__m128i *) dst, s);
+}
+
+BLIT_TARGET_SSE2 inline __m128i reverseSse2(__m128i v) {
+    // reverse dwords, then words in dwords, then bytes in words
+    v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+BLIT_TARGET_SSE2 void maskedCopySse2(uint8 *dst, const uint8 *src, int n) {
+    const __m128i key = _mm_set1_epi8((char) kTransparent);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        blendSse2(dst + i, s, _mm_cmpeq_epi8(s, key));
+    }
+    maskedCopyScalar(dst + i, src + i, n - i);
+}
+
+BLIT_TARGET_SSE2 void maskedCopyReversedSse2(uint8 *dst, const uint8 *src, int n) {
+    const __m128i key = _mm_set1_epi8((char) kTransparent);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i s = reverseSse2(_mm_loadu_si128((const __m128i *) (src + i)));
+        blendSse2(dst + n - i - 16, s, _mm_cmpeq_epi8(s, key));
+    }
+    maskedCopyReversedScalar(dst, src + i, n - i);
+}
+
+BLIT_TARGET_SSE2 void maskedCopyDoubledSse2(uint8 *dst, const uint8 *src, int n) {
+    const __m128i key = _mm_set1_epi8((char) kTransparent);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i mask = _mm_cmpeq_epi8(s, key);
+        blendSse2(dst + 2 * i, _mm_unpacklo_epi8(s, s), _mm_unpacklo_epi8(mask, mask));
+        blendSse2(dst + 2 * i + 16, _mm_unpackhi_epi8(s, s), _mm_unpackhi_epi8(mask, mask));
+    }
+    maskedCopyDoubledScalar(dst + 2 * i, src + i, n - i);
+}
+#endif  // BLIT_SSE2
+
+#ifdef BLIT_AVX2
+//*************************************
+// AVX2 kernels : 32 pixels at a time
+//*************************************
+BLIT_TARGET_AVX2 inline void blendAvx2(uint8 *dst, __m256i s, __m256i mask) {
+    int bits = _mm256_movemask_epi8(mask);
+    if (bits == -1) {
+        return;
+    }
+    if (bits != 0) {
+        __m256i d = _mm256_loadu_si256((const __m256i *) dst);
+        s = _mm256_blendv_epi8(s, d, mask);
+    }
+    _mm256_storeu_si256((__m256i *) dst, s);
+}
+
+BLIT_TARGET_AVX2 void maskedCopyAvx2(uint8 *dst, const uint8 *src, int n) {
+    const __m256i key = _mm256_set1_epi8((char) kTransparent);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) (src + i));
+        blendAvx2(dst + i, s, _mm256_cmpeq_epi8(s, key));
+    }
+    maskedCopySse2(dst + i, src + i, n - i);
+}
+
+BLIT_TARGET_AVX2 void maskedCopyReversedAvx2(uint8 *dst, const uint8 *src, int n) {
+    const __m256i key = _mm256_set1_epi8((char) kTransparent);
+    // reverses bytes in each 128 bits lane, lanes are swapped after
+    const __m256i reverse = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) (src + i));
+        s = _mm256_shuffle_epi8(s, reverse);
+        s = _mm256_permute2x128_si256(s, s, 1);
+        blendAvx2(dst + n - i - 32, s, _mm256_cmpeq_epi8(s, key));
+    }
+    maskedCopyReversedSse2(dst, src + i, n - i);
+}
+
+BLIT_TARGET_AVX2 void maskedCopyDoubledAvx2(uint8 *dst, const uint8 *src, int n) {
+    const __m256i key = _mm256_set1_epi8((char) kTransparent);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i mask = _mm256_cmpeq_epi8(s, key);
+        // unpack works in each lane : put lanes back in order
+        __m256i lo = _mm256_unpacklo_epi8(s, s);
+        __m256i hi = _mm256_unpackhi_epi8(s, s);
+        __m256i mlo = _mm256_unpacklo_epi8(mask, mask);
+        __m256i mhi = _mm256_unpackhi_epi8(mask, mask);
+        blendAvx2(dst + 2 * i, _mm256_permute2x128_si256(lo, hi, 0x20),
+            _mm256_permute2x128_si256(mlo, mhi, 0x20));
+        blendAvx2(dst + 2 * i + 32, _mm256_permute2x128_si256(lo, hi, 0x31),
+            _mm256_permute2x128_si256(mlo, mhi, 0x31));
+    }
+    maskedCopyDoubledSse2(dst + 2 * i, src + i, n - i);
+}
+
+BLIT_TARGET_AVX2 void expandPaletteAvx2(uint32 *dst, const uint8 *src, int n,
+        const uint32 *palette) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (src + i)));
+        _mm256_storeu_si256((__m256i *) (dst + i),
+            _mm256_i32gather_epi32((const int *) palette, indexes, 4));
+    }
+    expandPaletteScalar(dst + i, src + i, n - i, palette);
+}
+#endif  // BLIT_AVX2
+
+#ifdef BLIT_NEON
+//*************************************
+// NEON kernels : 16 pixels at a time
+//*************************************
+void maskedCopyNeon(uint8 *dst, const uint8 *src, int n) {
+    const uint8x16_t key = vdupq_n_u8(kTransparent);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t mask = vceqq_u8(s, key);
+        vst1q_u8(dst + i, vbslq_u8(mask, vld1q_u8(dst + i), s));
+    }
+    maskedCopyScalar(dst + i, src + i, n - i);
+}
+
+void maskedCopyReversedNeon(uint8 *dst, const uint8 *src, int n) {
+    const uint8x16_t key = vdupq_n_u8(kTransparent);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t s = vrev64q_u8(vld1q_u8(src + i));
+        s = vcombine_u8(vget_high_u8(s), vget_low_u8(s));
+        uint8x16_t mask = vceqq_u8(s, key);
+        uint8 *d = dst + n - i - 16;
+        vst1q_u8(d, vbslq_u8(mask, vld1q_u8(d), s));
+    }
+    maskedCopyReversedScalar(dst, src + i, n - i);
+}
+
+void maskedCopyDoubledNeon(uint8 *dst, const uint8 *src, int n) {
+    const uint8x16_t key = vdupq_n_u8(kTransparent);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16x2_t doubled = vzipq_u8(s, s);
+        uint8x16x2_t mask = vzipq_u8(vceqq_u8(s, key), vceqq_u8(s, key));
+        uint8 *d = dst + 2 * i;
+        vst1q_u8(d, vbslq_u8(mask.val[0], vld1q_u8(d), doubled.val[0]));
+        vst1q_u8(d + 16, vbslq_u8(mask.val[1], vld1q_u8(d + 16), doubled.val[1]));
+    }
+    maskedCopyDoubledScalar(dst + 2 * i, src + i, n - i);
+}
+#endif  // BLIT_NEON
+
+/*!
+ * All sets compiled in, from the slowest to the fastest.
+ */
+const BlitKernels kAllKernels[] = {
+    { "scalar", BlitKernels::kFeatureNone, maskedCopyScalar, maskedCopyReversedScalar,
+        maskedCopyDoubledScalar, expandPaletteScalar },
+    // SSE2 and NEON have no gather instruction : a table lookup is faster
+    // done one pixel at a time
+#ifdef BLIT_SSE2
+    { "sse2", BlitKernels::kFeatureSse2, maskedCopySse2, maskedCopyReversedSse2,
+        maskedCopyDoubledSse2, expandPaletteScalar },
+#endif
+#ifdef BLIT_AVX2
+    { "avx2", BlitKernels::kFeatureAvx2, maskedCopyAvx2, maskedCopyReversedAvx2,
+        maskedCopyDoubledAvx2, expandPaletteAvx2 },
+#endif
+#ifdef BLIT_NEON
+    { "neon", BlitKernels::kFeatureNone, maskedCopyNeon, maskedCopyReversedNeon,
+        maskedCopyDoubledNeon, expandPaletteScalar },
+#endif
+};
+
+const int kNbKernels = sizeof(kAllKernels) / sizeof(kAllKernels[0]);
+
+/*!
+ * Returns true if the CPU can run the given set.
+ */
+bool isSupported(const BlitKernels &kernels) {
+    switch (kernels.requiredFeature) {
+#if defined(BLIT_SSE2) && defined(__GNUC__)
+    case BlitKernels::kFeatureSse2:
+        return __builtin_cpu_supports("sse2");
+#endif
+#ifdef BLIT_AVX2
+    case BlitKernels::kFeatureAvx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        // the other sets run on any CPU the program is built for
+        return true;
+    }
+}
+
+}  // namespace
+
+int BlitKernels::numAvailable() {
+    int count = 0;
+    for (int i = 0; i < kNbKernels; i++) {
+        if (isSupported(kAllKernels[i])) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const BlitKernels *BlitKernels::available(int index) {
+    for (int i = 0; i < kNbKernels; i++) {
+        if (isSupported(kAllKernels[i])) {
+            if (index == 0) {
+                return &kAllKernels[i];
+            }
+            index--;
+        }
+    }
+    return NULL;
+}
+
+const BlitKernels *BlitKernels::best() {
+    return available(numAvailable() - 1);
+}
@@ -0,0 +1,72 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef GFX_BLITKERNELS_H_
+#define GFX_BLITKERNELS_H_
+
+#include "common.h"
+
+/*!
+ * A set of inner loops used by the Screen blitters.
+ * Each function copies a row of n pixels of 8-bit data, skipping pixels
+ * with the transparent color 255. A last function converts 8-bit pixels
+ * to 32-bit pixels for the display. Several sets exist (scalar, SSE2, AVX2,
+ * NEON), the best one supported by the CPU is chosen at startup.
+ * Images drawn with PixelSpans copy their opaque runs with memcpy and
+ * only use the reversed copy, for flipped images.
+ */
+class BlitKernels {
+public:
+    typedef void (*CopyFunction)(uint8 *dst, const uint8 *src, int n);
+    typedef void (*ExpandFunction)(uint32 *dst, const uint8 *src, int n,
+            const uint32 *palette);
+
+    /*!
+     * What the CPU must support to run a set.
+     */
+    enum Feature {
+        kFeatureNone,
+        kFeatureSse2,
+        kFeatureAvx2
+    };
+
+    /*! Name of the instruction set used.*/
+    const char *name;
+    /*! Checked at runtime before the set is used.*/
+    Feature requiredFeature;
+    /*! dst[i] receives src[i].*/
+    CopyFunction maskedCopy;
+    /*! dst[n - 1 - i] receives src[i], for flipped blits.*/
+    CopyFunction maskedCopyReversed;
+    /*! dst[2 * i] and dst[2 * i + 1] receive src[i], for scaled blits.*/
+    CopyFunction maskedCopyDoubled;
+    /*! dst[i] receives palette[src[i]], with no transparency.*/
+    ExpandFunction expandPalette;
+
+    //! Returns the fastest set supported by the CPU
+    static const BlitKernels *best();
+    //! Returns the number of sets supported by the CPU
+    static int numAvailable();
+    //! Returns a set supported by the CPU, 0 being the scalar one
+    static const BlitKernels *available(int i);
+};
+
+#endif  // GFX_BLITKERNELS_H_
@@ -20,143 +20,191 @@
  *                                                                      *
  ************************************************************************/
 
-#include "common.h"
+#include <string.h>
+
 #include "dirtylist.h"
 
 DirtyList::DirtyList(int screenWidth, int screenHeight) {
     size_ = 0;
-    pHead_ = NULL;
+    full_ = false;
     screenWidth_ = screenWidth;
     screenHeight_ = screenHeight;
-}
 
-DirtyList::~DirtyList() {
-    flush();
+    // tiles are 16 pixels wide unless the screen is too big for the bitmap
+    tileShift_ = 4;
+    while (((screenWidth_ >> tileShift_) + 1) > kMaxTiles
+        || ((screenHeight_ >> tileShift_) + 1) > kMaxTiles) {
+        tileShift_++;
+    }
+    // a rect touches the tile after its right and bottom borders
+    nbTilesX_ = (screenWidth_ >> tileShift_) + 1;
+    nbTilesY_ = (screenHeight_ >> tileShift_) + 1;
+    memset(tiles_, 0, sizeof(tiles_));
 }
 
-DirtyList::Link * DirtyList::createLink(int x, int y, int width, int height) {
-    Link *l = new Link();
-    l->pNext = NULL;
-    l->pPrev = NULL;
-    l->element.x = x;
-    l->element.y = y;
-    l->element.width = width;
-    l->element.height = height;
-
-    return l;
+DirtyList::~DirtyList() {
 }
 
+/*!
+ * Rects are clipped to the screen. A rect overlapping or touching another
+ * one is merged with it if their union is not bigger than both rects.
+ */
 void DirtyList::addRect(int x, int y, int width, int height) {
+    if (full_) {
+        return;
+    }
 
-    if (x >= screenWidth_ || y >= screenHeight_ ) {
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+    if (x + width > screenWidth_) {
+        width = screenWidth_ - x;
+    }
+    if (y + height > screenHeight_) {
+        height = screenHeight_ - y;
+    }
+    if (width <= 0 || height <= 0) {
         return;
     }
 
-    if (pHead_ == NULL) {
-        // Create new link
-        pHead_ = createLink(x, y, width, height);
-    } else {
-
-        Link *pCurr = pHead_;
-        do {
-            if (pCurr->element.x <= x && pCurr->element.y <= y &&
-                (pCurr->element.x + pCurr->element.width) >= (x + width) &&
-                (pCurr->element.y + pCurr->element.height) >= (y + height)) {
-                // Current rect is enclosing new rect so don't add new rect
-                return;
-            } else if (pCurr->element.x > x && pCurr->element.y > y &&
-                (pCurr->element.x + pCurr->element.width) < (x + width) &&
-                (pCurr->element.y + pCurr->element.height) < (y + height)) {
-                // Current rect is enclosed by new rect so remove it from the list
-                Link *pToRemove = pCurr;
-                if (pToRemove->pNext != NULL && pToRemove->pPrev != NULL) {
-                    // Current is between 2 links
-                    pToRemove->pPrev->pNext = pToRemove->pNext;
-                    pToRemove->pNext->pPrev = pToRemove->pPrev;
-                    pCurr = pToRemove->pNext;
-                } else if (pToRemove->pPrev != NULL && pToRemove->pNext == NULL) {
-                    // We are on the last element of the list
-                    pToRemove->pPrev->pNext = NULL;
-                    pCurr = pToRemove->pPrev;
-                } else if (pToRemove->pPrev == NULL && pToRemove->pNext != NULL) {
-                    // There no previous so we're on the head
-                    pHead_ = pCurr = pToRemove->pNext;
-                    pHead_->pPrev = NULL;
-                } else {
-                    pCurr = NULL;
-                }
-
-                // Delete current
-                pToRemove->pNext = NULL;
-                pToRemove->pPrev = NULL;
-                delete pToRemove;
-                size_--;
-            } else if (pCurr->pNext == NULL) {
-                break;
-            } else {
-                pCurr = pCurr->pNext;
+    DirtyRect added = {x, y, width, height};
+    int i = 0;
+    while (i < size_) {
+        DirtyRect &r = rects_[i];
+        if (r.x <= added.x && r.y <= added.y && r.x + r.width >= added.x + added.width
+            && r.y + r.height >= added.y + added.height) {
+            // Current rect is enclosing new rect so don't add new rect
+            return;
+        }
+
+        if (r.x <= added.x + added.width && added.x <= r.x + r.width
+            && r.y <= added.y + added.height && added.y <= r.y + r.height) {
+            int x1 = r.x < added.x ? r.x : added.x;
+            int y1 = r.y < added.y ? r.y : added.y;
+            int x2 = r.x + r.width > added.x + added.width ?
+                r.x + r.width : added.x + added.width;
+            int y2 = r.y + r.height > added.y + added.height ?
+                r.y + r.height : added.y + added.height;
+            if ((x2 - x1) * (y2 - y1) <= r.width * r.height + added.width * added.height) {
+                // Current rect is absorbed by the new one : as the new rect
+                // is bigger, it must be compared again with all rects
+                added.x = x1;
+                added.y = y1;
+                added.width = x2 - x1;
+                added.height = y2 - y1;
+                removeRectAt(i);
+                i = 0;
+                continue;
             }
-            
-        } while(pCurr != NULL);
-
-        Link *l = createLink(x, y, width, height);
-        if (pCurr == NULL) {
-            pHead_ = l;
-        } else {
-            pCurr->pNext = l;
-            l->pPrev = pCurr;
         }
+        i++;
+    }
+
+    if (size_ == kMaxRects
+        || (added.width == screenWidth_ && added.height == screenHeight_)) {
+        // too many rects : redraw everything
+        full_ = true;
+        size_ = 1;
+        rects_[0].x = 0;
+        rects_[0].y = 0;
+        rects_[0].width = screenWidth_;
+        rects_[0].height = screenHeight_;
+        for (int j = 0; j < nbTilesY_; j++) {
+            tiles_[j] = ~((uint64) 0);
+        }
+        return;
     }
-    size_++;
+
+    rects_[size_++] = added;
+    markTiles(added);
 }
 
-DirtyRect * DirtyList::getRectAt(int pos) {
-    if (pHead_ && pos >= 0 && pos < size_) {
-        int i = 0;
-        Link * l = pHead_;
-        while (i < pos) {
-            l = l->pNext;
-            i++;
+void DirtyList::removeRectAt(int pos) {
+    // order of rects doesn't matter
+    size_--;
+    rects_[pos] = rects_[size_];
+}
+
+/*!
+ * Marks the tiles touched by the rect, borders included.
+ */
+void DirtyList::markTiles(const DirtyRect &rect) {
+    int tx1 = rect.x >> tileShift_;
+    int tx2 = (rect.x + rect.width) >> tileShift_;
+    int ty1 = rect.y >> tileShift_;
+    int ty2 = (rect.y + rect.height) >> tileShift_;
+    uint64 mask = (~((uint64) 0) >> (63 - tx2 + tx1)) << tx1;
+    for (int j = ty1; j <= ty2; j++) {
+        tiles_[j] |= mask;
+    }
+}
+
+/*!
+ * Returns false if no tile touched by the rect is marked.
+ */
+bool DirtyList::touchesTiles(int x, int y, int width, int height) {
+    int tx1 = x < 0 ? 0 : x >> tileShift_;
+    int ty1 = y < 0 ? 0 : y >> tileShift_;
+    int tx2 = x + width < 0 ? -1 : (x + width) >> tileShift_;
+    int ty2 = y + height < 0 ? -1 : (y + height) >> tileShift_;
+    if (tx2 >= nbTilesX_) {
+        tx2 = nbTilesX_ - 1;
+    }
+    if (ty2 >= nbTilesY_) {
+        ty2 = nbTilesY_ - 1;
+    }
+    if (tx2 < tx1 || ty2 < ty1) {
+        return false;
+    }
+
+    uint64 mask = (~((uint64) 0) >> (63 - tx2 + tx1)) << tx1;
+    for (int j = ty1; j <= ty2; j++) {
+        if (tiles_[j] & mask) {
+            return true;
         }
-        return &(l->element);
     }
-       
+    return false;
+}
+
+DirtyRect * DirtyList::getRectAt(int pos) {
+    if (pos >= 0 && pos < size_) {
+        return &rects_[pos];
+    }
+
     return NULL;
 }
 
 void DirtyList::flush() {
-    size_ = 0;
-    if (pHead_) {
-        Link *pCurr = pHead_;
-        do {
-            Link *pNext = pCurr->pNext;
-            if (pNext) {
-                pNext->pPrev = NULL;
-                pCurr->pNext = NULL;
-            }
-            delete pCurr;
-            pCurr = pNext;
-        } while(pCurr != NULL);
+    for (int j = 0; j < nbTilesY_; j++) {
+        tiles_[j] = 0;
     }
-    pHead_ = NULL;
+    size_ = 0;
+    full_ = false;
 }
 
+/*!
+ * Rects that only touch a dirty rect are considered as intersecting.
+ */
 bool DirtyList::intersectsList(int x, int y, int width, int height)
 {
-    if (pHead_) {
-        Link * l = pHead_;
-        while (l) {
-            if ( !((x > l->element.x + l->element.width) || 
-                    (x + width < l->element.x) ||
-                    (y > l->element.y + l->element.height) ||
-                    (y + height < l->element.y)) ) {
-                return true;
-            }
-
+    if (size_ == 0 || !touchesTiles(x, y, width, height)) {
+        return false;
+    }
 
-            l = l->pNext;
+    for (int i = 0; i < size_; i++) {
+        const DirtyRect &r = rects_[i];
+        if ( !((x > r.x + r.width) ||
+                (x + width < r.x) ||
+                (y > r.y + r.height) ||
+                (y + height < r.y)) ) {
+            return true;
         }
     }
-       
+
     return false;
 }
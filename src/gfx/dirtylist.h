@@ -23,13 +23,28 @@
 #ifndef DIRTYLIST_H
 #define DIRTYLIST_H
 
+#include "common.h"
+
 struct DirtyRect {
     int x, y;
     int width, height;
 };
 
+/*!
+ * The areas of the screen that must be redrawn.
+ * Rects are kept in a fixed size array : a new rect absorbs the rects it
+ * overlaps or touches when their union is not bigger than both rects,
+ * and once the array is full, the whole screen is considered dirty.
+ * A coarse bitmap of the screen tiles touched by the rects allows to
+ * reject most intersection tests without looking at the rects.
+ */
 class DirtyList {
 public:
+    /*! Maximum number of rects before the whole screen is dirty.*/
+    static const int kMaxRects = 32;
+    /*! Maximum number of tiles on a row or column of the bitmap.*/
+    static const int kMaxTiles = 64;
+
     DirtyList(int screenWidth, int screenHeight);
 
     ~DirtyList();
@@ -38,6 +53,9 @@ public:
 
     int getSize() { return size_; }
 
+    //! Returns true if the whole screen is dirty
+    bool isFull() { return full_; }
+
     void addRect(int x, int y, int width, int height);
 
     DirtyRect * getRectAt(int pos);
@@ -48,18 +66,20 @@ public:
     bool intersectsList(int x, int y, int width, int height);
 
 private:
-    struct Link
-    {
-        Link *pPrev;
-        Link *pNext;
-        DirtyRect element;
-    };
-
-    Link * createLink(int x, int y, int width, int height);
+    void removeRectAt(int pos);
+    void markTiles(const DirtyRect &rect);
+    bool touchesTiles(int x, int y, int width, int height);
 
     int size_;
     int screenWidth_;
     int screenHeight_;
-    Link    *pHead_;
+    DirtyRect rects_[kMaxRects];
+    /*! True when the only rect is the whole screen.*/
+    bool full_;
+    /*! Size of the tiles of the bitmap is 1 << tileShift_.*/
+    int tileShift_;
+    int nbTilesX_, nbTilesY_;
+    /*! One bit per tile, set if a rect touches the tile.*/
+    uint64 tiles_[kMaxTiles];
 };
 #endif // DIRTYLIST_H
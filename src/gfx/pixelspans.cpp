@@ -0,0 +1,182 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <string.h>
+
+#include "gfx/pixelspans.h"
+#include "gfx/blitkernels.h"
+
+PixelSpans::PixelSpans() {
+    width_ = 0;
+    height_ = 0;
+    p_rows_ = NULL;
+    p_spans_ = NULL;
+    opaque_ = false;
+}
+
+/*!
+ * \param pixels Image data
+ * \param width Width of the image
+ * \param height Height of the image
+ * \param stride Number of bytes between two rows of data
+ */
+void PixelSpans::build(const uint8 *pixels, int width, int height, int stride) {
+    width_ = width;
+    height_ = height;
+    rows_.clear();
+    spans_.clear();
+    rows_.reserve(height + 1);
+
+    for (int j = 0; j < height; j++) {
+        const uint8 *row = pixels + j * stride;
+        rows_.push_back(spans_.size());
+        int i = 0;
+        while (i < width) {
+            while (i < width && row[i] == kTransparentColor) {
+                i++;
+            }
+            if (i == width) {
+                break;
+            }
+            Span span;
+            span.start = i;
+            while (i < width && row[i] != kTransparentColor) {
+                i++;
+            }
+            span.length = i - span.start;
+            spans_.push_back(span);
+        }
+    }
+    rows_.push_back(spans_.size());
+
+    opaque_ = width > 0 && height > 0 && spans_.size() == (size_t) height;
+    for (size_t s = 0; opaque_ && s < spans_.size(); s++) {
+        opaque_ = spans_[s].length == width;
+    }
+    p_rows_ = &rows_[0];
+    p_spans_ = spans_.empty() ? NULL : &spans_[0];
+}
+
+/*!
+ * The arrays are not copied and must outlive this object.
+ * \param width Width of the image
+ * \param height Height of the image
+ * \param rows Index of the first span of each row, followed by the
+ * number of spans, as returned by rows()
+ * \param spans Spans of all rows, as returned by spans()
+ * \param opaque True if image has no transparent pixel
+ */
+void PixelSpans::attach(int width, int height, const int32 *rows, const Span *spans,
+        bool opaque) {
+    width_ = width;
+    height_ = height;
+    rows_.clear();
+    spans_.clear();
+    p_rows_ = rows;
+    p_spans_ = spans;
+    opaque_ = opaque;
+}
+
+/*!
+ * Pixels out of the destination buffer are clipped.
+ * \param dest Destination buffer
+ * \param destWidth Width of the destination buffer
+ * \param destHeight Height of the destination buffer
+ * \param x Position of the image in the destination
+ * \param y Position of the image in the destination
+ * \param pixels Image data, the one given to build()
+ * \param stride Number of bytes between two rows of data
+ * \param flipped True to draw the image mirrored horizontally
+ * \param destStride Number of bytes between two rows of the destination,
+ * 0 if it is destWidth
+ * \param pKernels Kernels reversing the runs of flipped images, NULL to
+ * reverse them pixel by pixel
+ */
+void PixelSpans::draw(uint8 *dest, int destWidth, int destHeight, int x, int y,
+        const uint8 *pixels, int stride, bool flipped, int destStride,
+        const BlitKernels *pKernels) const {
+    if (x + width_ <= 0 || y + height_ <= 0 || x >= destWidth || y >= destHeight) {
+        return;
+    }
+
+    if (destStride == 0) {
+        destStride = destWidth;
+    }
+    int firstRow = y < 0 ? -y : 0;
+    int lastRow = y + height_ > destHeight ? destHeight - y : height_;
+    // visible part of the image, in image coordinates
+    int clipLeft = x < 0 ? -x : 0;
+    int clipRight = x + width_ > destWidth ? destWidth - x : width_;
+
+    if (opaque_ && !flipped) {
+        for (int j = firstRow; j < lastRow; j++) {
+            memcpy(dest + (y + j) * destStride + x + clipLeft,
+                pixels + j * stride + clipLeft, clipRight - clipLeft);
+        }
+        return;
+    }
+
+    for (int j = firstRow; j < lastRow; j++) {
+        const uint8 *src = pixels + j * stride;
+        uint8 *d = dest + (y + j) * destStride + x;
+
+        for (int s = p_rows_[j]; s < p_rows_[j + 1]; s++) {
+            int a = p_spans_[s].start;
+            int b = a + p_spans_[s].length;
+            if (flipped) {
+                // pixel i of the image goes to column width - 1 - i
+                int fa = width_ - b;
+                int fb = width_ - a;
+                if (fa < clipLeft) {
+                    fa = clipLeft;
+                }
+                if (fb > clipRight) {
+                    fb = clipRight;
+                }
+                if (fa >= fb) {
+                    continue;
+                }
+                if (pKernels != NULL) {
+                    // a run has no transparent pixel : the masked copy
+                    // only reverses it
+                    pKernels->maskedCopyReversed(d + fa, src + width_ - fb, fb - fa);
+                } else {
+                    for (int i = fa; i < fb; i++) {
+                        d[i] = src[width_ - 1 - i];
+                    }
+                }
+            } else {
+                if (a >= clipRight) {
+                    break;
+                }
+                if (a < clipLeft) {
+                    a = clipLeft;
+                }
+                if (b > clipRight) {
+                    b = clipRight;
+                }
+                if (a < b) {
+                    memcpy(d + a, src + a, b - a);
+                }
+            }
+        }
+    }
+}
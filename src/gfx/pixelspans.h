@@ -0,0 +1,92 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef GFX_PIXELSPANS_H_
+#define GFX_PIXELSPANS_H_
+
+#include <vector>
+
+#include "common.h"
+
+class BlitKernels;
+
+/*!
+ * Runs of non transparent pixels of an image.
+ * Images are stored as flat 8-bit buffers where color 255 is transparent.
+ * Spans are computed once at load time so that drawing copies each run
+ * with memcpy instead of testing every pixel. Images with no transparent
+ * pixel are copied row by row.
+ */
+class PixelSpans {
+public:
+    /*! Color index of transparent pixels.*/
+    static const uint8 kTransparentColor = 255;
+
+    /*!
+     * A run of non transparent pixels in a row.
+     */
+    struct Span {
+        uint16 start;
+        uint16 length;
+    };
+
+    PixelSpans();
+
+    //! Computes the spans of the given image
+    void build(const uint8 *pixels, int width, int height, int stride);
+    //! Uses spans computed before and stored elsewhere
+    void attach(int width, int height, const int32 *rows, const Span *spans,
+            bool opaque);
+    //! Returns true if image has no transparent pixel
+    bool isOpaque() const { return opaque_; }
+    //! Returns true if image has only transparent pixels
+    bool isEmpty() const { return numSpans() == 0; }
+
+    //! Returns the index of the first span of each row, plus the total
+    const int32 *rows() const { return p_rows_; }
+    //! Returns all spans, row after row
+    const Span *spans() const { return p_spans_; }
+    //! Returns the number of spans
+    int numSpans() const { return p_rows_ != NULL ? p_rows_[height_] : 0; }
+
+    //! Draws the non transparent pixels of the image to a buffer
+    void draw(uint8 *dest, int destWidth, int destHeight, int x, int y,
+            const uint8 *pixels, int stride, bool flipped = false,
+            int destStride = 0, const BlitKernels *pKernels = NULL) const;
+
+protected:
+    int width_;
+    int height_;
+    /*! Spans of row j are at rows_[j] to rows_[j + 1] - 1 in spans_.*/
+    std::vector<int32> rows_;
+    std::vector<Span> spans_;
+    /*! Spans in use : those of the vectors or attached ones.*/
+    const int32 *p_rows_;
+    const Span *p_spans_;
+    bool opaque_;
+
+private:
+    // copies would point to the arrays of the original
+    PixelSpans(const PixelSpans &);
+    PixelSpans &operator=(const PixelSpans &);
+};
+
+#endif  // GFX_PIXELSPANS_H_
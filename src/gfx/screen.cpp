@@ -26,6 +26,8 @@
 
 #include "common.h"
 #include "screen.h"
+#include "gfx/pixelspans.h"
+#include "gfx/blitkernels.h"
 #include "utils/file.h"
 
 const int Screen::kScreenWidth = 640;
@@ -36,9 +38,13 @@ Screen::Screen(int width, int height)
 :width_(width)
 , height_(height)
 , pixels_(NULL)
-, dirty_(false)
+, nb_dirty_areas_(0)
+, clip_x1_(0), clip_y1_(0), clip_x2_(width), clip_y2_(height)
+, tracking_(false), measuring_(false), signature_(0)
+, track_x1_(0), track_y1_(0), track_x2_(0), track_y2_(0)
 , data_logo_(NULL), data_logo_copy_(NULL)
 , data_mini_logo_(NULL), data_mini_logo_copy_(NULL)
+, p_kernels_(BlitKernels::best())
 {
     assert(width_ > 0);
     assert(height_ > 0);
@@ -62,7 +68,7 @@ Screen::~Screen()
 void Screen::clear(uint8 color)
 {
     memset(pixels_, color, width_ * height_);
-    dirty_ = true;
+    addDirtyArea(0, 0, width_, height_);
 }
 /*!
  * Blits data to screen
@@ -78,58 +84,81 @@ void Screen::clear(uint8 color)
 void Screen::blit(int x, int y, int width, int height,
                   const uint8 * pixeldata, bool flipped, int stride)
 {
-    if (x + width < 0 || y + height < 0 || x >= width_ || y >= height_)
+    if (x + width <= clip_x1_ || y + height <= clip_y1_
+        || x >= clip_x2_ || y >= clip_y2_)
         return;
 
-    int clipped_x = x < 0 ? 0 : x;
-    int clipped_y = y < 0 ? 0 : y;
+    trackArea(x, y, width, height);
+    if (measuring_) {
+        measure(x, y, width, height, pixeldata, flipped);
+        return;
+    }
 
-    int sx = x < 0 ? -x : 0;
-    int sy = y < 0 ? -y : 0;
+    // columns and rows of the data that are clipped
+    int sx = x < clip_x1_ ? clip_x1_ - x : 0;
+    int sy = y < clip_y1_ ? clip_y1_ - y : 0;
 
-    int w = x < 0 ? x + width : x + width > width_ ? width_ - x : width;
-    int h = y < 0
-        ? y + height : y + height > height_ ? height_ - y : height;
+    int w = (x + width > clip_x2_ ? clip_x2_ - x : width) - sx;
+    int h = (y + height > clip_y2_ ? clip_y2_ - y : height) - sy;
 
     stride = (stride == 0 ? width : stride);
-    int ofs = (flipped ? w - 1 : 0) + clipped_x;
-    uint8 *d = pixels_ + clipped_y * width_ + ofs;
+    uint8 *d = pixels_ + (y + sy) * width_ + x + sx;
 
     if (flipped) {
-        const uint8 *s = pixeldata + sy * stride + sx + (width - w);
+        // pixel i of a row goes to column width - 1 - i
+        const uint8 *s = pixeldata + sy * stride + width - sx - w;
         for (int j = 0; j < h; ++j) {
-
-            const uint8 *cp_s = s;
+            p_kernels_->maskedCopyReversed(d, s, w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d--;
-            }
         }
     } else {
         const uint8 *s = pixeldata + sy * stride + sx;
         for (int j = 0; j < h; ++j) {
-
-            const uint8 *cp_s = s;
+            p_kernels_->maskedCopy(d, s, w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d++;
-            }
         }
     }
 
-    dirty_ = true;
+    addDirtyArea(x + sx, y + sy, w, h);
+}
+
+/*!
+ * Blits data to screen using the runs of non transparent pixels
+ * computed at load time.
+ * @param x position by x coord
+ * @param y position by y coord
+ * @param width data's width
+ * @param height data's height
+ * @param spans runs of non transparent pixels of data
+ * @param pixeldata pointer to data to be blitted
+ * @param flipped draw flipped
+ * @param stride actual data width
+ */
+void Screen::blitSpans(int x, int y, int width, int height,
+                       const PixelSpans &spans, const uint8 * pixeldata,
+                       bool flipped, int stride)
+{
+    if (x + width <= clip_x1_ || y + height <= clip_y1_
+        || x >= clip_x2_ || y >= clip_y2_)
+        return;
+
+    trackArea(x, y, width, height);
+    if (measuring_) {
+        measure(x, y, width, height, pixeldata, flipped);
+        return;
+    }
+
+    // the clip rectangle is given as the destination buffer
+    spans.draw(pixels_ + clip_y1_ * width_ + clip_x1_, clip_x2_ - clip_x1_,
+               clip_y2_ - clip_y1_, x - clip_x1_, y - clip_y1_, pixeldata,
+               stride == 0 ? width : stride, flipped, width_, p_kernels_);
+
+    int x1 = x < clip_x1_ ? clip_x1_ : x;
+    int y1 = y < clip_y1_ ? clip_y1_ : y;
+    addDirtyArea(x1, y1, (x + width > clip_x2_ ? clip_x2_ : x + width) - x1,
+                 (y + height > clip_y2_ ? clip_y2_ : y + height) - y1);
 }
 
 /*!
@@ -138,15 +167,21 @@ void Screen::blit(int x, int y, int width, int height,
 void Screen::blitRect(int x, int y, int width, int height,
                   const uint8 * pixeldata, bool flipped, int stride)
 {
-    if (x + width < 0 || y + height < 0 || x >= width_ || y >= height_)
+    if (x + width <= clip_x1_ || y + height <= clip_y1_
+        || x >= clip_x2_ || y >= clip_y2_)
+        return;
+
+    trackArea(x, y, width, height);
+    if (measuring_) {
+        measure(x, y, width, height, pixeldata, flipped);
         return;
+    }
 
-    int dest_x = x < 0 ? 0 : x;
-    int dest_y = y < 0 ? 0 : y;
+    int dest_x = x < clip_x1_ ? clip_x1_ : x;
+    int dest_y = y < clip_y1_ ? clip_y1_ : y;
 
-    int clipped_w = x < 0 ? x + width : x + width > width_ ? width_ - x : width;
-    int clipped_h = y < 0
-        ? y + height : y + height > height_ ? height_ - y : height;
+    int clipped_w = (x + width > clip_x2_ ? clip_x2_ : x + width) - dest_x;
+    int clipped_h = (y + height > clip_y2_ ? clip_y2_ : y + height) - dest_y;
 
     stride = (stride == 0 ? width : stride);
     int ofs = (flipped ? clipped_w - 1 : 0) + dest_x;
@@ -155,51 +190,61 @@ void Screen::blitRect(int x, int y, int width, int height,
     if (flipped) {
         const uint8 *s = pixeldata + y * stride + x + (width - clipped_w);
         for (int j = 0; j < clipped_h; ++j) {
-
-            const uint8 *cp_s = s;
+            // d points on the rightmost pixel of the row
+            p_kernels_->maskedCopyReversed(d - (clipped_w - 1), s, clipped_w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < clipped_w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d--;
-            }
         }
     } else {
         const uint8 *s = pixeldata + y * stride + x;
         for (int j = 0; j < clipped_h; ++j) {
-
-            const uint8 *cp_s = s;
+            p_kernels_->maskedCopy(d, s, clipped_w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < clipped_w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d++;
-            }
         }
     }
 
-    dirty_ = true;
+    addDirtyArea(dest_x, dest_y, clipped_w, clipped_h);
 }
 
 void Screen::scale2x(int x, int y, int width, int height,
                      const uint8 * pixeldata, int stride, bool transp)
 {
     stride = (stride == 0 ? width : stride);
+    trackArea(x, y, width * 2, height * 2);
+    if (measuring_) {
+        measure(x, y, width * 2, height * 2, pixeldata, transp);
+        return;
+    }
+
+    if (x < clip_x1_ || y < clip_y1_ || x + width * 2 > clip_x2_
+        || y + height * 2 > clip_y2_) {
+        // data is not entirely in the clip rectangle : test each pixel
+        for (int j = 0; j < height * 2; ++j) {
+            for (int i = 0; i < width * 2; ++i) {
+                uint8 c = pixeldata[(j / 2) * stride + i / 2];
+                if ((c != 255 || !transp) && x + i >= clip_x1_ && x + i < clip_x2_
+                    && y + j >= clip_y1_ && y + j < clip_y2_) {
+                    pixels_[(y + j) * width_ + x + i] = c;
+                }
+            }
+        }
+        int x1 = x < clip_x1_ ? clip_x1_ : x;
+        int y1 = y < clip_y1_ ? clip_y1_ : y;
+        addDirtyArea(x1, y1, (x + width * 2 > clip_x2_ ? clip_x2_ : x + width * 2) - x1,
+                     (y + height * 2 > clip_y2_ ? clip_y2_ : y + height * 2) - y1);
+        return;
+    }
 
     for (int j = 0; j < height; ++j) {
         uint8 *d = pixels_ + (y + j * 2) * width_ + x;
 
-        for (int i = 0; i < width; ++i, d += 2) {
-            uint8 c = *(pixeldata + i);
-            if (c != 255 || !transp) {
+        if (transp) {
+            p_kernels_->maskedCopyDoubled(d, pixeldata, width);
+            p_kernels_->maskedCopyDoubled(d + width_, pixeldata, width);
+        } else {
+            for (int i = 0; i < width; ++i, d += 2) {
+                uint8 c = *(pixeldata + i);
                 *(d + 0) = c;
                 *(d + 1) = c;
                 *(d + 0 + width_) = c;
@@ -210,7 +255,226 @@ void Screen::scale2x(int x, int y, int width, int height,
         pixeldata += stride;
     }
 
-    dirty_ = true;
+    addDirtyArea(x, y, width * 2, height * 2);
+}
+
+/*!
+ * Copies data to screen. Unlike blit(), all pixels are copied.
+ * @param x position by x coord
+ * @param y position by y coord
+ * @param width data's width
+ * @param height data's height
+ * @param pixeldata pointer to data to be copied
+ * @param stride actual data width
+ */
+void Screen::copyRect(int x, int y, int width, int height,
+                      const uint8 * pixeldata, int stride)
+{
+    if (x + width <= clip_x1_ || y + height <= clip_y1_
+        || x >= clip_x2_ || y >= clip_y2_)
+        return;
+
+    trackArea(x, y, width, height);
+    if (measuring_) {
+        measure(x, y, width, height, pixeldata, false);
+        return;
+    }
+
+    stride = (stride == 0 ? width : stride);
+    int sx = x < clip_x1_ ? clip_x1_ - x : 0;
+    int sy = y < clip_y1_ ? clip_y1_ - y : 0;
+    int w = (x + width > clip_x2_ ? clip_x2_ - x : width) - sx;
+    int h = (y + height > clip_y2_ ? clip_y2_ - y : height) - sy;
+
+    const uint8 *s = pixeldata + sy * stride + sx;
+    uint8 *d = pixels_ + (y + sy) * width_ + x + sx;
+    for (int j = 0; j < h; ++j) {
+        memcpy(d, s, w);
+        s += stride;
+        d += width_;
+    }
+
+    addDirtyArea(x + sx, y + sy, w, h);
+}
+
+/*!
+ * Pixels moved out of the rectangle are lost and pixels uncovered by
+ * the move are left unchanged : the caller must draw them again.
+ * \param x Left of the rectangle
+ * \param y Top of the rectangle
+ * \param width Width of the rectangle
+ * \param height Height of the rectangle
+ * \param dx Horizontal move, positive to the right
+ * \param dy Vertical move, positive downward
+ */
+void Screen::scrollRect(int x, int y, int width, int height, int dx, int dy)
+{
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+    if (x + width > width_)
+        width = width_ - x;
+    if (y + height > height_)
+        height = height_ - y;
+
+    int w = width - (dx < 0 ? -dx : dx);
+    int h = height - (dy < 0 ? -dy : dy);
+    if (w <= 0 || h <= 0)
+        return;
+
+    int sx = dx < 0 ? x - dx : x;
+    int dstx = dx < 0 ? x : x + dx;
+    if (dy > 0) {
+        // rows are moved down : start from the bottom not to overwrite
+        // rows not yet moved
+        for (int j = h - 1; j >= 0; j--) {
+            memmove(pixels_ + (y + dy + j) * width_ + dstx,
+                    pixels_ + (y + j) * width_ + sx, w);
+        }
+    } else {
+        for (int j = 0; j < h; j++) {
+            memmove(pixels_ + (y + j) * width_ + dstx,
+                    pixels_ + (y - dy + j) * width_ + sx, w);
+        }
+    }
+
+    addDirtyArea(x, y, width, height);
+}
+
+void Screen::startAreaTracking()
+{
+    tracking_ = true;
+    measuring_ = false;
+    track_x1_ = width_;
+    track_y1_ = height_;
+    track_x2_ = 0;
+    track_y2_ = 0;
+}
+
+/*!
+ * @param x receives left of the area
+ * @param y receives top of the area
+ * @param width receives width of the area
+ * @param height receives height of the area
+ * @return false if nothing was drawn
+ */
+bool Screen::stopAreaTracking(int *x, int *y, int *width, int *height)
+{
+    tracking_ = false;
+    measuring_ = false;
+    if (track_x2_ <= track_x1_ || track_y2_ <= track_y1_)
+        return false;
+
+    *x = track_x1_;
+    *y = track_y1_;
+    *width = track_x2_ - track_x1_;
+    *height = track_y2_ - track_y1_;
+    return true;
+}
+
+/*!
+ * Like startAreaTracking() but blits are not drawn : they only extend the
+ * area and change the value returned by measuredSignature().
+ */
+void Screen::startMeasuring()
+{
+    startAreaTracking();
+    measuring_ = true;
+    signature_ = 2166136261u;
+}
+
+/*!
+ * Mixes the parameters of a blit in the signature.
+ */
+void Screen::measure(int x, int y, int width, int height,
+                     const uint8 *pixeldata, bool flipped)
+{
+    uint32 values[6] = { (uint32) x, (uint32) y, (uint32) width, (uint32) height,
+        (uint32) (size_t) pixeldata, flipped ? 1u : 0u };
+    for (int i = 0; i < 6; i++) {
+        signature_ = (signature_ ^ values[i]) * 16777619u;
+    }
+}
+
+/*!
+ * Blits and copies only change pixels inside this rectangle. Lines and
+ * rectangles are not clipped.
+ */
+void Screen::setClipRect(int x, int y, int width, int height)
+{
+    clip_x1_ = x < 0 ? 0 : x;
+    clip_y1_ = y < 0 ? 0 : y;
+    clip_x2_ = x + width > width_ ? width_ : x + width;
+    clip_y2_ = y + height > height_ ? height_ : y + height;
+}
+
+void Screen::resetClipRect()
+{
+    setClipRect(0, 0, width_, height_);
+}
+
+/*!
+ * Records that the given area has been modified. Areas already covered
+ * are ignored and areas covered by the new one are removed. When the list
+ * is full, all areas are merged into one.
+ */
+void Screen::addDirtyArea(int x, int y, int width, int height)
+{
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+    if (x + width > width_)
+        width = width_ - x;
+    if (y + height > height_)
+        height = height_ - y;
+    if (width <= 0 || height <= 0)
+        return;
+
+    int n = 0;
+    for (int i = 0; i < nb_dirty_areas_; i++) {
+        DirtyRect &r = dirty_areas_[i];
+        if (r.x <= x && r.y <= y && r.x + r.width >= x + width
+            && r.y + r.height >= y + height) {
+            // already covered
+            return;
+        }
+        if (x > r.x || y > r.y || x + width < r.x + r.width
+            || y + height < r.y + r.height) {
+            // r is not covered by the new area : keep it
+            dirty_areas_[n++] = r;
+        }
+    }
+    nb_dirty_areas_ = n;
+
+    if (nb_dirty_areas_ == kMaxDirtyAreas) {
+        int x2 = x + width, y2 = y + height;
+        for (int i = 0; i < nb_dirty_areas_; i++) {
+            DirtyRect &r = dirty_areas_[i];
+            if (r.x < x) x = r.x;
+            if (r.y < y) y = r.y;
+            if (r.x + r.width > x2) x2 = r.x + r.width;
+            if (r.y + r.height > y2) y2 = r.y + r.height;
+        }
+        nb_dirty_areas_ = 0;
+        width = x2 - x;
+        height = y2 - y;
+    }
+
+    DirtyRect &added = dirty_areas_[nb_dirty_areas_++];
+    added.x = x;
+    added.y = y;
+    added.width = width;
+    added.height = height;
 }
 
 void Screen::drawVLine(int x, int y, int length, uint8 color)
@@ -226,13 +490,12 @@ void Screen::drawVLine(int x, int y, int length, uint8 color)
     if (length < 1)
         return;
 
+    addDirtyArea(x, y, 1, length);
     uint8 *pixel = pixels_ + y * width_ + x;
     while (length--) {
         *pixel = color;
         pixel += width_;
     }
-
-    dirty_ = true;
 }
 
 void Screen::drawHLine(int x, int y, int length, uint8 color)
@@ -248,11 +511,10 @@ void Screen::drawHLine(int x, int y, int length, uint8 color)
     if (length < 1)
         return;
 
+    addDirtyArea(x, y, length, 1);
     uint8 *pixel_ptr = pixels_ + y * width_ + x;
     while (length--)
         *pixel_ptr++ = color;
-
-    dirty_ = true;
 }
 
 int Screen::numLogos()
@@ -285,8 +547,6 @@ void Screen::drawLogo(int x, int y, int logo, int colour, bool mini)
         scale2x(x, y, 16, 16, data_mini_logo_copy_ + logo * 16 * 16, 16);
     else
         scale2x(x, y, 32, 32, data_logo_copy_ + logo * 32 * 32, 32);
-
-    dirty_ = true;
 }
 
 // Taken from SDL_gfx
@@ -349,7 +609,8 @@ void Screen::drawLine(int x1, int y1, int x2, int y2, uint8 color,
         }
     }
 
-    dirty_ = true;
+    addDirtyArea(x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2,
+                 ABS(x2 - x1) + 1, ABS(y2 - y1) + 1);
 }
 
 void Screen::setPixel(int x, int y, uint8 color)
@@ -357,7 +618,7 @@ void Screen::setPixel(int x, int y, uint8 color)
     if (x < 0 || y < 0 || x >= width_ || y >= height_)
         return;
     pixels_[y * width_ + x] = color;
-    dirty_ = true;
+    addDirtyArea(x, y, 1, 1);
 }
 
 
@@ -374,7 +635,7 @@ void Screen::drawRect(int x, int y, int width, int height, uint8 color)
         for (int w = 0; w != width; w++)
             *p_pixels++ = color;
     }
-    dirty_ = true;
+    addDirtyArea(x, y, width, height);
 }
 
 int Screen::gameScreenHeight()
@@ -26,6 +26,10 @@
 #define SCREEN_H
 
 #include "common.h"
+#include "gfx/dirtylist.h"
+
+class PixelSpans;
+class BlitKernels;
 
 /*!
  * Screen class.
@@ -38,6 +42,8 @@ public:
     static const int kScreenHeight;
     /*! Width of the left control panel*/
     static const int kScreenPanelWidth;
+    /*! Maximum number of modified areas recorded.*/
+    static const int kMaxDirtyAreas = 32;
 
     explicit Screen(int width, int height);
     ~Screen();
@@ -45,15 +51,40 @@ public:
     void clear(uint8 color = 0);
 
     const uint8 *pixels() const { return pixels_; }
-    bool dirty() { return dirty_; }
-    void clearDirty() { dirty_ = false; }
+    bool dirty() { return nb_dirty_areas_ > 0; }
+    void clearDirty() { nb_dirty_areas_ = 0; }
+    //! Returns the number of areas modified since last clearDirty()
+    int numDirtyAreas() { return nb_dirty_areas_; }
+    //! Returns a modified area
+    const DirtyRect &dirtyArea(int i) { return dirty_areas_[i]; }
 
     void blit(int x, int y, int width, int height, const uint8 *pixeldata,
             bool flipped = false, int stride = 0);
+    void blitSpans(int x, int y, int width, int height, const PixelSpans &spans,
+            const uint8 *pixeldata, bool flipped = false, int stride = 0);
     void blitRect(int x, int y, int width, int height,
                   const uint8 * pixeldata, bool flipped = false, int stride = 0);
     void scale2x(int x, int y, int width, int height, const uint8 *pixeldata,
             int stride = 0, bool transp = true);
+    //! Copies data to screen, without transparency
+    void copyRect(int x, int y, int width, int height, const uint8 *pixeldata,
+            int stride = 0);
+    //! Moves the content of a rectangle of the screen
+    void scrollRect(int x, int y, int width, int height, int dx, int dy);
+
+    //! Starts recording the area drawn by blits
+    void startAreaTracking();
+    //! Starts recording the area of blits without drawing them
+    void startMeasuring();
+    //! Stops recording and returns the area drawn since start
+    bool stopAreaTracking(int *x, int *y, int *width, int *height);
+    //! Returns a value identifying the blits measured since start
+    uint32 measuredSignature() { return signature_; }
+
+    //! Restricts blits to the given rectangle
+    void setClipRect(int x, int y, int width, int height);
+    //! Allows blits on the whole screen
+    void resetClipRect();
 
     void drawVLine(int x, int y, int length, uint8 color);
     void drawHLine(int x, int y, int length, uint8 color);
@@ -63,6 +94,11 @@ public:
     void drawLine(int x1, int y1, int x2, int y2, uint8 color, int skip = 0,
             int off = 0);
 
+    //! Returns the inner loops used by blits
+    const BlitKernels *blitKernels() { return p_kernels_; }
+    //! Changes the inner loops used by blits
+    void setBlitKernels(const BlitKernels *pKernels) { p_kernels_ = pKernels; }
+
     void setPixel(int x, int y, uint8 color);
     void drawRect(int x, int y, int width, int height, uint8 color = 0);
 
@@ -70,15 +106,46 @@ public:
     int gameScreenWidth();
     int gameScreenLeftMargin();
 
+protected:
+    void addDirtyArea(int x, int y, int width, int height);
+    void measure(int x, int y, int width, int height, const uint8 *pixeldata,
+            bool flipped);
+
+    /*!
+     * Extends the tracked area with the given rectangle.
+     */
+    void trackArea(int x, int y, int width, int height) {
+        if (tracking_) {
+            if (x < track_x1_) track_x1_ = x;
+            if (y < track_y1_) track_y1_ = y;
+            if (x + width > track_x2_) track_x2_ = x + width;
+            if (y + height > track_y2_) track_y2_ = y + height;
+        }
+    }
+
 protected:
     int width_;
     int height_;
     uint8 *pixels_;
-    bool dirty_;
+    /*! Areas modified since last presented.*/
+    DirtyRect dirty_areas_[kMaxDirtyAreas];
+    int nb_dirty_areas_;
+    /*! Blits are clipped to this rectangle : top left and bottom right (excluded).*/
+    int clip_x1_, clip_y1_, clip_x2_, clip_y2_;
+    /*! True when area drawn by blits is recorded.*/
+    bool tracking_;
+    /*! True when blits are recorded but not drawn.*/
+    bool measuring_;
+    /*! Hash of the parameters of the blits measured.*/
+    uint32 signature_;
+    /*! Area drawn since tracking started : top left and bottom right (excluded).*/
+    int track_x1_, track_y1_, track_x2_, track_y2_;
     int size_logo_;
     uint8 *data_logo_, *data_logo_copy_;
     int size_mini_logo_;
     uint8 *data_mini_logo_, *data_mini_logo_copy_;
+    /*! Inner loops of the blits, chosen for the CPU.*/
+    const BlitKernels *p_kernels_;
 
     Screen();
 };
@@ -70,12 +70,13 @@ Sprite::Sprite()
     , height_(0)
     , stride_(0)
     , sprite_data_(NULL)
+    , owns_data_(false)
 {
 }
 
 Sprite::~Sprite()
 {
-    if (sprite_data_)
+    if (sprite_data_ && owns_data_)
         delete[] sprite_data_;
 
     width_ = height_ = stride_ = 0;
@@ -124,15 +125,18 @@ void Sprite::loadSpriteFromPNG(const char *filename)
     if (depth != 8) {
         fprintf(stderr, "expected 8 bit depth from %s.\n", filename);
     } else {
-        if (sprite_data_)
+        if (sprite_data_ && owns_data_)
             delete[] sprite_data_;
 
-        sprite_data_ = new uint8[w * h];
+        uint8 *pixels = new uint8[w * h];
         width_ = w;
         height_ = h;
         stride_ = w;
         for (unsigned int i = 0; i < h; i++)
-            memcpy(sprite_data_ + i * stride_, row_pointers[i], w);
+            memcpy(pixels + i * stride_, row_pointers[i], w);
+        sprite_data_ = pixels;
+        owns_data_ = true;
+        spans_.build(sprite_data_, width_, height_, stride_);
     }
 
     png_destroy_read_struct(&png_ptr, &info_ptr, 0);
@@ -161,15 +165,17 @@ bool Sprite::loadSprite(uint8 * tabData, uint8 * spriteData, uint32 offset,
     stride_ = ceil8(width_);
     uint8 *spriteBlocks = spriteData + spriteOffset;
 
-    sprite_data_ = new uint8[stride_ * height_];
-    memset(sprite_data_, 255, stride_ * height_);
+    uint8 *pixels = new uint8[stride_ * height_];
+    memset(pixels, 255, stride_ * height_);
+    sprite_data_ = pixels;
+    owns_data_ = true;
 
     uint8 *currentPixel;
 
     if (rle) {
         for (int i = 0; i < height_; ++i) {
             int spriteWidth = width_;
-            currentPixel = sprite_data_ + i * stride_;
+            currentPixel = pixels + i * stride_;
 
             uint8 b = *spriteBlocks++;
             int runLength = b < 128 ? b : -(256 - b);
@@ -177,12 +183,12 @@ bool Sprite::loadSprite(uint8 * tabData, uint8 * spriteData, uint32 offset,
                 spriteWidth -= runLength;
 
                 if (runLength > 0) {
-                    if (currentPixel < sprite_data_)
-                        currentPixel = sprite_data_;
+                    if (currentPixel < pixels)
+                        currentPixel = pixels;
                     if (currentPixel + runLength >
-                        sprite_data_ + height_ * stride_)
+                        pixels + height_ * stride_)
                         runLength =
-                            sprite_data_ + height_ * stride_ -
+                            pixels + height_ * stride_ -
                             currentPixel;
                     // pixel run
                     for (int j = 0; j < runLength; ++j)
@@ -191,12 +197,12 @@ bool Sprite::loadSprite(uint8 * tabData, uint8 * spriteData, uint32 offset,
                 } else if (runLength < 0) {
                     // transparent run
                     runLength *= -1;
-                    if (currentPixel < sprite_data_)
-                        currentPixel = sprite_data_;
+                    if (currentPixel < pixels)
+                        currentPixel = pixels;
                     if (currentPixel + runLength >
-                        sprite_data_ + height_ * stride_)
+                        pixels + height_ * stride_)
                         runLength =
-                            sprite_data_ + height_ * stride_ -
+                            pixels + height_ * stride_ -
                             currentPixel;
                     memset(currentPixel, 255, runLength);
                     currentPixel += runLength;
@@ -212,7 +218,7 @@ bool Sprite::loadSprite(uint8 * tabData, uint8 * spriteData, uint32 offset,
         }
     } else {
         for (int j = 0; j < height_; ++j) {
-            currentPixel = sprite_data_ + j * stride_;
+            currentPixel = pixels + j * stride_;
 
             for (int i = 0; i < width_; i += PIXELS_PER_BLOCK) {
                 unpackBlocks1(spriteBlocks, currentPixel);
@@ -223,16 +229,40 @@ bool Sprite::loadSprite(uint8 * tabData, uint8 * spriteData, uint32 offset,
         }
     }
 
+    spans_.build(sprite_data_, width_, height_, stride_);
     return true;
 }
 
+/*!
+ * \param width Width of the sprite
+ * \param height Height of the sprite
+ * \param stride Number of bytes between two rows of pixels
+ * \param pixels Pixels of the sprite
+ * \param rows Spans of the pixels (see PixelSpans::attach())
+ * \param spans Spans of the pixels (see PixelSpans::attach())
+ * \param opaque True if sprite has no transparent pixel
+ */
+void Sprite::attach(int width, int height, int stride, const uint8 *pixels,
+        const int32 *rows, const PixelSpans::Span *spans, bool opaque)
+{
+    if (sprite_data_ && owns_data_)
+        delete[] sprite_data_;
+
+    width_ = width;
+    height_ = height;
+    stride_ = stride;
+    sprite_data_ = pixels;
+    owns_data_ = false;
+    spans_.attach(width, height, rows, spans, opaque);
+}
+
 void Sprite::draw(int x, int y, int z, bool flipped, bool x2)
 {
     if (x2)
         g_Screen.scale2x(x, y, width_, height_, sprite_data_, stride_);
     else
-        g_Screen.blit(x, y, width_, height_, sprite_data_, flipped,
-                      stride_);
+        g_Screen.blitSpans(x, y, width_, height_, spans_, sprite_data_,
+                           flipped, stride_);
 }
 
 void Sprite::data(uint8 * spr_data) const
@@ -27,6 +27,7 @@
 #define SPRITE_H
 
 #include "common.h"
+#include "gfx/pixelspans.h"
 
 const int TABENTRY_SIZE = 6;
 
@@ -42,7 +43,11 @@ class Sprite {
      * (boundary of 8)
      */
     int stride_;
-    uint8 *sprite_data_;
+    const uint8 *sprite_data_;
+    /*! False when sprite_data_ belongs to someone else.*/
+    bool owns_data_;
+    /*! Runs of non transparent pixels in sprite_data_.*/
+    PixelSpans spans_;
 
 public:
     /*! Id of sprite agent selector 1 in the menu sprite list.*/
@@ -89,10 +94,19 @@ public:
     void loadSpriteFromPNG(const char *filename);
     bool loadSprite(uint8 *tabData, uint8 *spriteData, uint32 offset,
             bool rle = false);
+    //! Uses pixels and spans stored elsewhere, that must outlive the sprite
+    void attach(int width, int height, int stride, const uint8 *pixels,
+            const int32 *rows, const PixelSpans::Span *spans, bool opaque);
     void draw(int x, int y, int z, bool flipped = false, bool x2 = false);
 
     int width() const { return width_; }
     int height() const { return height_; }
+    //! Returns the number of bytes between two rows of pixels
+    int stride() const { return stride_; }
+    //! Returns the pixels, NULL for an empty sprite
+    const uint8 *pixels() const { return sprite_data_; }
+    //! Returns the runs of non transparent pixels
+    const PixelSpans &spans() const { return spans_; }
 
     void data(uint8 *spr_data) const;
 };
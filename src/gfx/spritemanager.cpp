@@ -23,12 +23,42 @@
  ************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <set>
 
 #include "gfx/spritemanager.h"
 #include "utils/file.h"
 
-SpriteManager::SpriteManager():sprites_(NULL), sprite_count_(0)
+/*!
+ * A sprite in a cache file. Offsets are from the start of the payload.
+ */
+struct CachedSprite {
+    int32 width;
+    int32 height;
+    int32 stride;
+    uint32 pixels;
+    uint32 rows;
+    uint32 spans;
+    int32 opaque;
+};
+
+/*!
+ * Start of the cache file of the game sprites.
+ */
+struct CachedGameSprites {
+    uint32 sprites;
+    uint32 elements;
+    uint32 nbElements;
+    uint32 frames;
+    uint32 nbFrames;
+    uint32 index;
+    uint32 nbIndex;
+};
+
+SpriteManager::SpriteManager():sprites_(NULL), sprite_count_(0),
+    nb_png_pending_(0)
 {
 }
 
@@ -44,6 +74,10 @@ void SpriteManager::clear()
 
     sprites_ = NULL;
     sprite_count_ = 0;
+    png_pending_.clear();
+    nb_png_pending_ = 0;
+    // sprites may have pointed into the cache
+    cache_.reset();
 }
 
 bool SpriteManager::loadSprites(uint8 * tabData, int tabSize,
@@ -65,6 +99,134 @@ bool SpriteManager::loadSprites(uint8 * tabData, int tabSize,
     return true;
 }
 
+/*!
+ * Decoded sprites are kept in a cache file named after the data file.
+ * \param tabName Name of the original file with the sprites table
+ * \param datName Name of the original file with the sprites data
+ * \param rle True if sprites are run length encoded
+ * \return False if original files could not be read
+ */
+bool SpriteManager::loadSprites(const char *tabName, const char *datName, bool rle)
+{
+    clear();
+    if (!cache_.addSource(tabName) || !cache_.addSource(datName)) {
+        cache_.reset();
+        return false;
+    }
+    if (cache_.open(datName) && attachSprites(0)) {
+        return true;
+    }
+
+    int tabSize, size;
+    uint8 *tabData = cache_.unpackSource(0, tabSize);
+    uint8 *data = cache_.unpackSource(1, size);
+    bool res = false;
+    if (tabData && data) {
+        res = loadSprites(tabData, tabSize, data, rle);
+    }
+    delete[] tabData;
+    delete[] data;
+
+    if (res) {
+        std::vector<uint8> payload;
+        saveSprites(payload);
+        cache_.write(datName, payload);
+    }
+    cache_.releaseSources();
+    return res;
+}
+
+/*!
+ * The sprites are written as a count, an array of CachedSprite and
+ * the pixels and spans of each sprite.
+ * \param payload Data of the cache file
+ * \return Offset of the sprites in the payload
+ */
+uint32 SpriteManager::saveSprites(std::vector<uint8> &payload)
+{
+    uint32 count = sprite_count_;
+    uint32 offset = AssetCache::append(payload, &count, sizeof(count));
+    if (count == 0) {
+        return offset;
+    }
+
+    std::vector<CachedSprite> entries(count);
+    uint32 entriesOffset = AssetCache::append(payload, &entries[0],
+        count * sizeof(CachedSprite));
+
+    for (uint32 i = 0; i < count; i++) {
+        const Sprite &sprite = sprites_[i];
+        CachedSprite &entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        if (sprite.pixels() == NULL || sprite.width() == 0 || sprite.height() == 0) {
+            continue;
+        }
+
+        const PixelSpans &spans = sprite.spans();
+        entry.width = sprite.width();
+        entry.height = sprite.height();
+        entry.stride = sprite.stride();
+        entry.pixels = AssetCache::append(payload, sprite.pixels(),
+            sprite.stride() * sprite.height());
+        entry.rows = AssetCache::append(payload, spans.rows(),
+            (sprite.height() + 1) * sizeof(int32));
+        entry.spans = AssetCache::append(payload, spans.spans(),
+            spans.numSpans() * sizeof(PixelSpans::Span));
+        entry.opaque = spans.isOpaque() ? 1 : 0;
+    }
+
+    memcpy(&payload[entriesOffset], &entries[0], count * sizeof(CachedSprite));
+    return offset;
+}
+
+/*!
+ * Sprites point into the cache file.
+ * \param offset Offset of the sprites in the payload
+ * \return False if the data is not valid
+ */
+bool SpriteManager::attachSprites(uint32 offset)
+{
+    const uint32 *pCount = static_cast<const uint32 *>(cache_.at(offset, sizeof(uint32)));
+    if (pCount == NULL || *pCount == 0) {
+        return false;
+    }
+    uint32 count = *pCount;
+    const CachedSprite *entries = static_cast<const CachedSprite *>(
+        cache_.at(offset + sizeof(uint32), count * sizeof(CachedSprite)));
+    if (entries == NULL) {
+        return false;
+    }
+
+    Sprite *sprites = new Sprite[count];
+    for (uint32 i = 0; i < count; i++) {
+        const CachedSprite &entry = entries[i];
+        if (entry.width <= 0 || entry.height <= 0) {
+            continue;
+        }
+
+        const uint8 *pixels = static_cast<const uint8 *>(
+            cache_.at(entry.pixels, entry.stride * entry.height));
+        const int32 *rows = static_cast<const int32 *>(
+            cache_.at(entry.rows, (entry.height + 1) * sizeof(int32)));
+        const PixelSpans::Span *spans = NULL;
+        if (rows != NULL) {
+            spans = static_cast<const PixelSpans::Span *>(
+                cache_.at(entry.spans, rows[entry.height] * sizeof(PixelSpans::Span)));
+        }
+        if (pixels == NULL || spans == NULL) {
+            delete[] sprites;
+            cache_.close();
+            return false;
+        }
+        sprites[i].attach(entry.width, entry.height, entry.stride, pixels,
+            rows, spans, entry.opaque != 0);
+    }
+
+    sprites_ = sprites;
+    sprite_count_ = count;
+    return true;
+}
+
 Sprite *SpriteManager::sprite(int spriteNum)
 {
     if (spriteNum >= sprite_count_) {
@@ -72,7 +234,36 @@ Sprite *SpriteManager::sprite(int spriteNum)
                spriteNum);
         return NULL;
     }
-    return &sprites_[spriteNum];
+    return &at(spriteNum);
+}
+
+/*!
+ * All PNG files must be in the same directory.
+ * \param dir Directory of the file, ending with a slash
+ * \param spriteNum The sprite replaced by file "<spriteNum>.png"
+ */
+void SpriteManager::addPNGFile(const std::string &dir, int spriteNum)
+{
+    if (spriteNum < 0 || spriteNum >= sprite_count_) {
+        return;
+    }
+    if (png_pending_.empty()) {
+        png_pending_.assign(sprite_count_, false);
+    }
+    if (!png_pending_[spriteNum]) {
+        png_dir_ = dir;
+        png_pending_[spriteNum] = true;
+        nb_png_pending_++;
+    }
+}
+
+void SpriteManager::loadPNGFile(int spriteNum)
+{
+    char tmp[32];
+    sprintf(tmp, "%i.png", spriteNum);
+    sprites_[spriteNum].loadSpriteFromPNG((png_dir_ + tmp).c_str());
+    png_pending_[spriteNum] = false;
+    nb_png_pending_--;
 }
 
 
@@ -85,7 +276,7 @@ bool SpriteManager::drawSpriteXYZ(int spriteNum, int x, int y, int z,
         return false;
     }
 
-    sprites_[spriteNum].draw(x, y, z, flipped, x2);
+    at(spriteNum).draw(x, y, z, flipped, x2);
 
     return true;
 }
@@ -99,134 +290,336 @@ GameSpriteManager::~GameSpriteManager()
 {
 }
 
+/*!
+ * Sprites and animations are read from the original files or from their
+ * cache. The text versions of the animation files replace the original
+ * ones when they exist : the cache is not used then.
+ */
 void GameSpriteManager::load()
 {
+    static const char *kCacheName = "hspr-0";
     int tabSize, size;
     uint8 *tabData, *data;
-#if 1
-    tabData = File::loadOriginalFile("hspr-0.tab", tabSize);
-    data = File::loadOriginalFile("hspr-0.dat", size);
-    printf("Loaded %d sprites from hspr-0.dat\n", tabSize / 6);
-#else
-    tabData = File::loadOriginalFile("hspr-0-d.tab", tabSize);
-    data = File::loadOriginalFile("hspr-0-d.dat", size);
-    printf("Loading %d sprites from hspr-0-d.dat\n", tabSize / 6);
-#endif
-    loadSprites(tabData, tabSize, data);
-    delete[] tabData;
-    delete[] data;
+    bool textFiles = hasTextFile("HELE-0.TXT") || hasTextFile("HFRA-0.TXT")
+        || hasTextFile("HSTA-0.TXT");
 
-    FILE *fp = File::openOriginalFile("HELE-0.TXT");
-    if (fp) {
-        char line[1024];
-        while (fgets(line, 1024, fp)) {
-            GameSpriteFrameElement e;
-            char flipped;
-            if (*line == '#')
-                continue;
-            sscanf(line, "%i %i %i %c %i", &e.sprite_, &e.off_x_, &e.off_y_,
-                   &flipped, &e.next_element_);
-            e.flipped_ = (flipped == 'f');
-            elements_.push_back(e);
-        }
-        for (unsigned int i = 0; i < elements_.size(); i++)
-            assert(elements_[i].next_element_ < (int)elements_.size());
-        fclose(fp);
+    clear();
+    bool cached = false;
+    if (!textFiles && cache_.addSource("hspr-0.tab") && cache_.addSource("hspr-0.dat")
+        && cache_.addSource("HELE-0.ANI") && cache_.addSource("HFRA-0.ANI")
+        && cache_.addSource("HSTA-0.ANI")) {
+        cached = cache_.open(kCacheName) && attachCache();
+    }
+
+    if (cached) {
+        printf("Loaded %d sprites from cache\n", sprite_count_);
     } else {
-        // try original data file
-        data = File::loadOriginalFile("HELE-0.ANI", size);
-        assert(size % 10 == 0);
-        for (int i = 0; i < size / 10; i++) {
-            GameSpriteFrameElement e;
-            e.sprite_ = data[i * 10] | (data[i * 10 + 1] << 8);
-            assert(e.sprite_ % 6 == 0);
-            e.sprite_ /= 6;
-            e.off_x_ = data[i * 10 + 2] | (data[i * 10 + 3] << 8);
-            e.off_y_ = data[i * 10 + 4] | (data[i * 10 + 5] << 8);
-            e.flipped_ =
-                (data[i * 10 + 6] | (data[i * 10 + 7] << 8)) !=
-                0 ? true : false;
-            e.next_element_ = data[i * 10 + 8] | (data[i * 10 + 9] << 8);
-            if (e.off_x_ & (1 << 15))
-                e.off_x_ = -(65536 - e.off_x_);
-            if (e.off_y_ & (1 << 15))
-                e.off_y_ = -(65536 - e.off_y_);
-            assert(e.next_element_ < size / 10);
-            elements_.push_back(e);
+        // sources that were not read by the cache are read now
+        tabData = cache_.unpackSource(0, tabSize);
+        if (tabData == NULL) {
+            tabData = File::loadOriginalFile("hspr-0.tab", tabSize);
+        }
+        data = cache_.unpackSource(1, size);
+        if (data == NULL) {
+            data = File::loadOriginalFile("hspr-0.dat", size);
         }
+        printf("Loaded %d sprites from hspr-0.dat\n", tabSize / 6);
+        loadSprites(tabData, tabSize, data);
+        delete[] tabData;
         delete[] data;
+
+        FILE *fp = File::openOriginalFile("HELE-0.TXT");
+        if (fp) {
+            loadElements(fp);
+            fclose(fp);
+        } else {
+            // try original data file
+            data = cache_.unpackSource(2, size);
+            if (data == NULL) {
+                data = File::loadOriginalFile("HELE-0.ANI", size);
+            }
+            loadElements(data, size);
+            delete[] data;
+        }
+
+        fp = File::openOriginalFile("HFRA-0.TXT");
+        if (fp) {
+            loadFrames(fp);
+            fclose(fp);
+        } else {
+            // try original data file
+            data = cache_.unpackSource(3, size);
+            if (data == NULL) {
+                data = File::loadOriginalFile("HFRA-0.ANI", size);
+            }
+            loadFrames(data, size);
+            delete[] data;
+        }
+
+        fp = File::openOriginalFile("HSTA-0.TXT");
+        if (fp) {
+            loadIndex(fp);
+            fclose(fp);
+        } else {
+            // try original data file
+            data = cache_.unpackSource(4, size);
+            if (data == NULL) {
+                data = File::loadOriginalFile("HSTA-0.ANI", size);
+            }
+            loadIndex(data, size);
+            delete[] data;
+        }
+
+        if (!textFiles) {
+            saveCache(kCacheName);
+        }
+        cache_.releaseSources();
     }
 
     printf("loaded %i frame elements\n", (int)elements_.size());
+    printf("loaded %i frames\n", (int)frames_.size());
+    printf("index contains %i animations\n", (int)index_.size());
+
+    findPNGFiles();
+}
+
+/*!
+ * Sprites of frame elements can be replaced by PNG files named after
+ * the sprite number in the sprites directory. The directory is read
+ * once : files are only read when their sprite is first used.
+ */
+void GameSpriteManager::findPNGFiles()
+{
+    static const char *kPNGDir = "sprites/";
+    std::vector<std::string> files;
+    File::listFiles(kPNGDir, ".png", files);
+    if (files.empty()) {
+        return;
+    }
+
+    std::set<int> numbers;
+    for (size_t i = 0; i < files.size(); i++) {
+        // only names written as the file is read later : "<number>.png"
+        int num = atoi(files[i].c_str());
+        char tmp[32];
+        sprintf(tmp, "%i.png", num);
+        if (files[i] == tmp) {
+            numbers.insert(num);
+        }
+    }
 
     for (unsigned int i = 0; i < elements_.size(); i++) {
         int esprite = elements_[i].sprite_;
-        if (esprite) {
-            char tmp[1024];
-            sprintf(tmp, "sprites/%i.png", esprite);
-            sprites_[esprite].loadSpriteFromPNG(tmp);        
+        if (esprite && numbers.find(esprite) != numbers.end()) {
+            addPNGFile(kPNGDir, esprite);
         }
-    } 
+    }
+    printf("found %i sprites replaced by PNG files\n", nb_png_pending_);
+}
+
+void GameSpriteManager::clear()
+{
+    SpriteManager::clear();
+    index_.clear();
+    frames_.clear();
+    elements_.clear();
+}
 
-    fp = File::openOriginalFile("HFRA-0.TXT");
+bool GameSpriteManager::hasTextFile(const char *filename)
+{
+    FILE *fp = File::openOriginalFile(filename);
     if (fp) {
-        char line[1024];
-        while (fgets(line, 1024, fp)) {
-            GameSpriteFrame f;
-            if (*line == '#')
-                continue;
-            sscanf(line, "%i %i %i %i %i", &f.first_element_, &f.width_, 
-                    &f.height_, &f.flags_, &f.next_frame_);
-            assert(f.first_element_ < (int) elements_.size());
-            frames_.push_back(f);
-        }
-        for (unsigned int i = 0; i < frames_.size(); i++)
-            assert(frames_[i].next_frame_ < (int)frames_.size());
         fclose(fp);
-    } else {
-        // try original data file
-        data = File::loadOriginalFile("HFRA-0.ANI", size);
-        assert(size % 8 == 0);
-        for (int i = 0; i < size / 8; i++) {
-            GameSpriteFrame f;
-            f.first_element_ = data[i * 8] | (data[i * 8 + 1] << 8);
-            assert(f.first_element_ < (int) elements_.size());
-            f.width_ = data[i * 8 + 2];
-            f.height_ = data[i * 8 + 3];
-            f.flags_ = data[i * 8 + 4] | (data[i * 8 + 5] << 8);
-            f.next_frame_ = data[i * 8 + 6] | (data[i * 8 + 7] << 8);
-            assert(f.next_frame_ < size / 8);
-            frames_.push_back(f);
-        }
-        delete[] data;
+        return true;
     }
+    return false;
+}
 
-    printf("loaded %i frames\n", (int)frames_.size());
+void GameSpriteManager::loadElements(FILE *fp)
+{
+    char line[1024];
+    while (fgets(line, 1024, fp)) {
+        GameSpriteFrameElement e;
+        char flipped;
+        if (*line == '#')
+            continue;
+        sscanf(line, "%i %i %i %c %i", &e.sprite_, &e.off_x_, &e.off_y_,
+               &flipped, &e.next_element_);
+        e.flipped_ = (flipped == 'f');
+        elements_.push_back(e);
+    }
+    for (unsigned int i = 0; i < elements_.size(); i++)
+        assert(elements_[i].next_element_ < (int)elements_.size());
+}
 
-    fp = File::openOriginalFile("HSTA-0.TXT");
-    if (fp) {
-        char line[1024];
-        while (fgets(line, 1024, fp)) {
-            int index;
-            if (*line == '#')
-                continue;
-            sscanf(line, "%i", &index);
-            assert(index < (int) frames_.size());
-            index_.push_back(index);
-        }
-        fclose(fp);
-    } else {
-        // try original data file
-        data = File::loadOriginalFile("HSTA-0.ANI", size);
-        assert(size % 2 == 0);
-        for (int i = 0; i < size / 2; i++) {
-            index_.push_back(data[i * 2] | (data[i * 2 + 1] << 8));
-            assert(index_[i] < (int) frames_.size());
-        }
-        delete[] data;
+void GameSpriteManager::loadElements(uint8 *data, int size)
+{
+    assert(size % 10 == 0);
+    for (int i = 0; i < size / 10; i++) {
+        GameSpriteFrameElement e;
+        e.sprite_ = data[i * 10] | (data[i * 10 + 1] << 8);
+        assert(e.sprite_ % 6 == 0);
+        e.sprite_ /= 6;
+        e.off_x_ = data[i * 10 + 2] | (data[i * 10 + 3] << 8);
+        e.off_y_ = data[i * 10 + 4] | (data[i * 10 + 5] << 8);
+        e.flipped_ =
+            (data[i * 10 + 6] | (data[i * 10 + 7] << 8)) !=
+            0 ? true : false;
+        e.next_element_ = data[i * 10 + 8] | (data[i * 10 + 9] << 8);
+        if (e.off_x_ & (1 << 15))
+            e.off_x_ = -(65536 - e.off_x_);
+        if (e.off_y_ & (1 << 15))
+            e.off_y_ = -(65536 - e.off_y_);
+        assert(e.next_element_ < size / 10);
+        elements_.push_back(e);
     }
+}
 
-    printf("index contains %i animations\n", (int)index_.size());
+void GameSpriteManager::loadFrames(FILE *fp)
+{
+    char line[1024];
+    while (fgets(line, 1024, fp)) {
+        GameSpriteFrame f;
+        if (*line == '#')
+            continue;
+        sscanf(line, "%i %i %i %i %i", &f.first_element_, &f.width_, 
+                &f.height_, &f.flags_, &f.next_frame_);
+        assert(f.first_element_ < (int) elements_.size());
+        frames_.push_back(f);
+    }
+    for (unsigned int i = 0; i < frames_.size(); i++)
+        assert(frames_[i].next_frame_ < (int)frames_.size());
+}
+
+void GameSpriteManager::loadFrames(uint8 *data, int size)
+{
+    assert(size % 8 == 0);
+    for (int i = 0; i < size / 8; i++) {
+        GameSpriteFrame f;
+        f.first_element_ = data[i * 8] | (data[i * 8 + 1] << 8);
+        assert(f.first_element_ < (int) elements_.size());
+        f.width_ = data[i * 8 + 2];
+        f.height_ = data[i * 8 + 3];
+        f.flags_ = data[i * 8 + 4] | (data[i * 8 + 5] << 8);
+        f.next_frame_ = data[i * 8 + 6] | (data[i * 8 + 7] << 8);
+        assert(f.next_frame_ < size / 8);
+        frames_.push_back(f);
+    }
+}
+
+void GameSpriteManager::loadIndex(FILE *fp)
+{
+    char line[1024];
+    while (fgets(line, 1024, fp)) {
+        int index;
+        if (*line == '#')
+            continue;
+        sscanf(line, "%i", &index);
+        assert(index < (int) frames_.size());
+        index_.push_back(index);
+    }
+}
+
+void GameSpriteManager::loadIndex(uint8 *data, int size)
+{
+    assert(size % 2 == 0);
+    for (int i = 0; i < size / 2; i++) {
+        index_.push_back(data[i * 2] | (data[i * 2 + 1] << 8));
+        assert(index_[i] < (int) frames_.size());
+    }
+}
+
+/*!
+ * The cache holds the decoded sprites followed by the animation tables.
+ * Tables are small so they are copied from the cache.
+ */
+void GameSpriteManager::saveCache(const char *name)
+{
+    std::vector<uint8> payload;
+    CachedGameSprites header;
+    memset(&header, 0, sizeof(header));
+    uint32 headerOffset = AssetCache::append(payload, &header, sizeof(header));
+
+    header.sprites = saveSprites(payload);
+
+    std::vector<int32> values;
+    for (size_t i = 0; i < elements_.size(); i++) {
+        const GameSpriteFrameElement &e = elements_[i];
+        values.push_back(e.sprite_);
+        values.push_back(e.off_x_);
+        values.push_back(e.off_y_);
+        values.push_back(e.flipped_ ? 1 : 0);
+        values.push_back(e.next_element_);
+    }
+    header.nbElements = elements_.size();
+    header.elements = AssetCache::append(payload, values.empty() ? NULL : &values[0],
+        values.size() * sizeof(int32));
+
+    values.clear();
+    for (size_t i = 0; i < frames_.size(); i++) {
+        const GameSpriteFrame &f = frames_[i];
+        values.push_back(f.first_element_);
+        values.push_back(f.width_);
+        values.push_back(f.height_);
+        values.push_back(f.flags_);
+        values.push_back(f.next_frame_);
+    }
+    header.nbFrames = frames_.size();
+    header.frames = AssetCache::append(payload, values.empty() ? NULL : &values[0],
+        values.size() * sizeof(int32));
+
+    values.assign(index_.begin(), index_.end());
+    header.nbIndex = index_.size();
+    header.index = AssetCache::append(payload, values.empty() ? NULL : &values[0],
+        values.size() * sizeof(int32));
+
+    memcpy(&payload[headerOffset], &header, sizeof(header));
+    cache_.write(name, payload);
+}
+
+/*!
+ * \return False if the data of the cache is not valid
+ */
+bool GameSpriteManager::attachCache()
+{
+    const CachedGameSprites *pHeader = static_cast<const CachedGameSprites *>(
+        cache_.at(0, sizeof(CachedGameSprites)));
+    if (pHeader == NULL) {
+        return false;
+    }
+    const int32 *elements = static_cast<const int32 *>(
+        cache_.at(pHeader->elements, pHeader->nbElements * 5 * sizeof(int32)));
+    const int32 *frames = static_cast<const int32 *>(
+        cache_.at(pHeader->frames, pHeader->nbFrames * 5 * sizeof(int32)));
+    const int32 *index = static_cast<const int32 *>(
+        cache_.at(pHeader->index, pHeader->nbIndex * sizeof(int32)));
+    if (elements == NULL || frames == NULL || index == NULL
+        || !attachSprites(pHeader->sprites)) {
+        return false;
+    }
+
+    elements_.resize(pHeader->nbElements);
+    for (size_t i = 0; i < elements_.size(); i++) {
+        GameSpriteFrameElement &e = elements_[i];
+        e.sprite_ = elements[i * 5];
+        e.off_x_ = elements[i * 5 + 1];
+        e.off_y_ = elements[i * 5 + 2];
+        e.flipped_ = elements[i * 5 + 3] != 0;
+        e.next_element_ = elements[i * 5 + 4];
+    }
+
+    frames_.resize(pHeader->nbFrames);
+    for (size_t i = 0; i < frames_.size(); i++) {
+        GameSpriteFrame &f = frames_[i];
+        f.first_element_ = frames[i * 5];
+        f.width_ = frames[i * 5 + 1];
+        f.height_ = frames[i * 5 + 2];
+        f.flags_ = frames[i * 5 + 3];
+        f.next_frame_ = frames[i * 5 + 4];
+    }
+
+    index_.assign(index, index + pHeader->nbIndex);
+    return true;
 }
 
 bool GameSpriteManager::drawFrame(int animNum, int frameNum, int x, int y)
@@ -244,8 +637,8 @@ bool GameSpriteManager::drawFrame(int animNum, int frameNum, int x, int y)
 
     GameSpriteFrameElement *e = &elements_[f->first_element_];
     while (1) {
-        sprites_[e->sprite_].draw(x + e->off_x_, y + e->off_y_, 0,
-                                  e->flipped_);
+        at(e->sprite_).draw(x + e->off_x_, y + e->off_y_, 0,
+                            e->flipped_);
         if (e->next_element_ == 0)
             break;
         e = &elements_[e->next_element_];
@@ -25,9 +25,13 @@
 #ifndef SPRITEMANAGER_H
 #define SPRITEMANAGER_H
 
-#include "sprite.h"
+#include <stdio.h>
+#include <string>
 #include <vector>
 
+#include "sprite.h"
+#include "utils/assetcache.h"
+
 /*!
  * Sprite manager class.
  */
@@ -43,13 +47,42 @@ public:
 
     bool loadSprites(uint8 * tabData, int tabSize, uint8 *spriteData,
             bool rle = false);
+    //! Loads sprites from the original files or from their cache
+    bool loadSprites(const char *tabName, const char *datName, bool rle = false);
     Sprite *sprite(int spriteNum);
     bool drawSpriteXYZ(int spriteNum, int x, int y, int z, bool flipped = false,
             bool x2 = false);
 
+protected:
+    //! Adds the decoded sprites to a cache payload
+    uint32 saveSprites(std::vector<uint8> &payload);
+    //! Uses the decoded sprites of the cache
+    bool attachSprites(uint32 offset);
+
+    //! Replaces a sprite by a PNG file of the directory when first used
+    void addPNGFile(const std::string &dir, int spriteNum);
+    void loadPNGFile(int spriteNum);
+
+    /*!
+     * Returns the sprite, reading its PNG file first if it has one.
+     */
+    Sprite &at(int spriteNum) {
+        if (nb_png_pending_ != 0 && png_pending_[spriteNum]) {
+            loadPNGFile(spriteNum);
+        }
+        return sprites_[spriteNum];
+    }
+
 protected:
     Sprite *sprites_;
     int sprite_count_;
+    /*! Cache file the sprites may point into.*/
+    AssetCache cache_;
+    /*! Directory of the PNG files replacing sprites.*/
+    std::string png_dir_;
+    /*! True for sprites whose PNG file has not been read yet.*/
+    std::vector<bool> png_pending_;
+    int nb_png_pending_;
 };
 
 /*!
@@ -87,6 +120,7 @@ public:
     virtual ~GameSpriteManager();
 
     void load();
+    void clear();
 
     int numAnims() { return (int) index_.size(); }
 
@@ -96,6 +130,21 @@ public:
     int getFrameFromFrameIndx(int frameIndx);
     int getFrameNum(int animNum);
 
+protected:
+    static bool hasTextFile(const char *filename);
+    void loadElements(FILE *fp);
+    void loadElements(uint8 *data, int size);
+    void loadFrames(FILE *fp);
+    void loadFrames(uint8 *data, int size);
+    void loadIndex(FILE *fp);
+    void loadIndex(uint8 *data, int size);
+    //! Writes sprites and animations to the cache file
+    void saveCache(const char *name);
+    //! Uses sprites and animations of the cache file
+    bool attachCache();
+    //! Looks for PNG files replacing sprites of frame elements
+    void findPNGFiles();
+
 protected:
     std::vector<int> index_;
     std::vector<GameSpriteFrame> frames_;
@@ -34,14 +34,44 @@ Tile::Tile(uint8 id_set, uint8 *tile_Data, bool not_alpha, EType type_set)
 {
     i_id_ = id_set;
     e_type_ = type_set;
-    a_pixels_ = new uint8[TILE_WIDTH * TILE_HEIGHT];
-    memcpy(a_pixels_, tile_Data, TILE_WIDTH * TILE_HEIGHT);
+    uint8 *pixels = new uint8[TILE_WIDTH * TILE_HEIGHT];
+    // tile data is stored from bottom to top
+    for (int j = 0; j < TILE_HEIGHT; ++j) {
+        memcpy(pixels + j * TILE_WIDTH,
+            tile_Data + (TILE_HEIGHT - 1 - j) * TILE_WIDTH, TILE_WIDTH);
+    }
+    a_pixels_ = pixels;
+    owns_pixels_ = true;
+    spans_.build(a_pixels_, TILE_WIDTH, TILE_HEIGHT, TILE_WIDTH);
+    not_alpha_ = not_alpha;
+}
+
+/*!
+ * \param id_set Id of the tile
+ * \param pixels Pixels of the tile, from top to bottom
+ * \param rows Spans of the pixels (see PixelSpans::attach())
+ * \param spans Spans of the pixels (see PixelSpans::attach())
+ * \param opaque True if the tile has no transparent pixel
+ * \param not_alpha Value returned by notTransparent()
+ * \param type_set The tile type
+ */
+Tile::Tile(uint8 id_set, const uint8 *pixels, const int32 *rows,
+        const PixelSpans::Span *spans, bool opaque, bool not_alpha,
+        EType type_set)
+{
+    i_id_ = id_set;
+    e_type_ = type_set;
+    a_pixels_ = pixels;
+    owns_pixels_ = false;
+    spans_.attach(TILE_WIDTH, TILE_HEIGHT, rows, spans, opaque);
     not_alpha_ = not_alpha;
 }
 
 Tile::~Tile()
 {
-    delete[] a_pixels_;
+    if (owns_pixels_) {
+        delete[] a_pixels_;
+    }
 }
 
 bool Tile::drawTo(uint8 * screen, int swidth, int sheight, int x, int y)
@@ -52,34 +82,16 @@ bool Tile::drawTo(uint8 * screen, int swidth, int sheight, int x, int y)
         return false;
     }
 
-    int xlow = x < 0 ? 0 : x;
-    int clipped_w = TILE_WIDTH - (xlow - x);
-    int xhigh = xlow + clipped_w >= swidth ? swidth : xlow + clipped_w;
-    int ylow = y < 0 ? 0 : y;
-    int clipped_h = TILE_HEIGHT - (ylow - y);
-    int yhigh = ylow + clipped_h >= sheight ? sheight : ylow + clipped_h;
-
-    uint8 *ptr_a_pixels = a_pixels_ + ((TILE_HEIGHT - 1) - (ylow - y)) * TILE_WIDTH;
-    uint8 *ptr_screen = screen + ylow * swidth + xlow;
-    for (int j = ylow; j < yhigh; ++j)
-    {
-        uint8 *cp_ptr_a_pixels = ptr_a_pixels;
-        ptr_a_pixels -= TILE_WIDTH;
-        uint8 *cp_ptr_screen = ptr_screen;
-        ptr_screen += swidth;
-        for (int i = xlow; i < xhigh; ++i) {
-            uint8 c = *cp_ptr_a_pixels++;
-            if (c != 255)
-                *cp_ptr_screen = c;
-            ++cp_ptr_screen;
-        }
-    }
+    spans_.draw(screen, swidth, sheight, x, y, a_pixels_, TILE_WIDTH);
     return true;
 }
 
 bool Tile::drawToScreen(int x, int y)
 {
-    return drawTo((uint8*) g_Screen.pixels(), g_Screen.gameScreenWidth(), g_Screen.gameScreenHeight(), x, y);
+    // goes through the screen to honour its clip rectangle
+    g_Screen.blitSpans(x, y, TILE_WIDTH, TILE_HEIGHT, spans_, a_pixels_);
+    return x + TILE_WIDTH > 0 && y + TILE_HEIGHT > 0
+        && x < g_Screen.gameScreenWidth() && y < g_Screen.gameScreenHeight();
 }
 
 uint8 Tile::getWalkData() {
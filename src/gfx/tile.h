@@ -26,6 +26,7 @@
 #define TILE_H
 
 #include "common.h"
+#include "gfx/pixelspans.h"
 
 // TODO: Convert these to const int's -- we are using C++, yes? :-)
 #define TILE_WIDTH              64
@@ -75,6 +76,10 @@ public:
     };
 
     Tile(uint8 id_set, uint8 *tile_Data, bool not_alpha, EType type_set);
+    //! Creates a tile whose pixels and spans are stored elsewhere
+    Tile(uint8 id_set, const uint8 *pixels, const int32 *rows,
+            const PixelSpans::Span *spans, bool opaque, bool not_alpha,
+            EType type_set);
     ~Tile();
 
     //! Returns the tile id
@@ -99,12 +104,20 @@ public:
     bool drawToScreen(int x, int y);
 
     inline bool notTransparent() { return not_alpha_; }
+    //! Returns the pixels of the tile, from top to bottom
+    const uint8 *pixels() { return a_pixels_; }
+    //! Returns the runs of non transparent pixels
+    const PixelSpans &spans() const { return spans_; }
 
 protected:
     /*! Each tile has a unique id.*/
     uint8 i_id_;
-    /*! The pixels that compose the tile.*/
-    uint8 *a_pixels_;
+    /*! The pixels that compose the tile, from top to bottom.*/
+    const uint8 *a_pixels_;
+    /*! False when a_pixels_ belongs to someone else.*/
+    bool owns_pixels_;
+    /*! Runs of non transparent pixels in a_pixels_.*/
+    PixelSpans spans_;
     /*! A quick flag to tell that all pixel are transparent.*/
     bool not_alpha_;
     /*! The tile type. */
@@ -23,7 +23,9 @@
  ************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <vector>
 
 #include "tilemanager.h"
 #include "resources.h"
@@ -74,6 +76,18 @@ void loadSubTile(const uint8 * data, uint32 offset, uint32 index,
 
 const int TileManager::kNumOfTiles = 256;
 
+/*!
+ * A tile in a cache file. Offsets are from the start of the payload.
+ */
+struct CachedTile {
+    uint32 pixels;
+    uint32 rows;
+    uint32 spans;
+    int32 opaque;
+    int32 notAlpha;
+    int32 type;
+};
+
 /*!
  * Default constructor.
  */
@@ -181,25 +195,38 @@ Tile::EType TileManager::toTileType(uint8 data)
 }
 
 /*!
- * Loads all tile from the file.
+ * Loads all tile from the file or from its cache.
  */
 bool TileManager::loadTiles()
 {
     int size;
     uint8 *type_data;
 
+    cache_.reset();
+    if (cache_.addSource(TILE_TYPES) && cache_.addSource(TILE_SET)
+        && cache_.open(TILE_SET) && attachCache()) {
+        return true;
+    }
+
     // first reads types
-    type_data = File::loadOriginalFile(TILE_TYPES, size);
+    type_data = cache_.unpackSource(0, size);
+    if (!type_data) {
+        type_data = File::loadOriginalFile(TILE_TYPES, size);
+    }
     if (!type_data) {
         return false;
     }
 
     // then reads tiles
-    uint8 *tileData = File::loadOriginalFile(TILE_SET, size);
+    uint8 *tileData = cache_.unpackSource(1, size);
+    if (!tileData) {
+        tileData = File::loadOriginalFile(TILE_SET, size);
+    }
   
     if (!tileData) {
         FSERR(Log::k_FLG_IO, "TileManager", "loadTiles", ("Failed to load tiles data\n"));
         delete[] type_data;
+        cache_.reset();
         return false;
     }
 
@@ -210,6 +237,71 @@ bool TileManager::loadTiles()
 
     delete[] type_data;
     delete[] tileData;
+    saveCache();
+    cache_.releaseSources();
+    return true;
+}
+
+void TileManager::saveCache()
+{
+    std::vector<uint8> payload;
+    std::vector<CachedTile> entries(kNumOfTiles);
+    uint32 entriesOffset = AssetCache::append(payload, &entries[0],
+        kNumOfTiles * sizeof(CachedTile));
+
+    for (int i = 0; i < kNumOfTiles; i++) {
+        Tile *pTile = a_tiles_[i];
+        const PixelSpans &spans = pTile->spans();
+        CachedTile &entry = entries[i];
+        entry.pixels = AssetCache::append(payload, pTile->pixels(),
+            TILE_WIDTH * TILE_HEIGHT);
+        entry.rows = AssetCache::append(payload, spans.rows(),
+            (TILE_HEIGHT + 1) * sizeof(int32));
+        entry.spans = AssetCache::append(payload, spans.spans(),
+            spans.numSpans() * sizeof(PixelSpans::Span));
+        entry.opaque = spans.isOpaque() ? 1 : 0;
+        entry.notAlpha = pTile->notTransparent() ? 1 : 0;
+        entry.type = pTile->type();
+    }
+
+    memcpy(&payload[entriesOffset], &entries[0], kNumOfTiles * sizeof(CachedTile));
+    cache_.write(TILE_SET, payload);
+}
+
+/*!
+ * Tiles point into the cache file.
+ * \return False if the data of the cache is not valid
+ */
+bool TileManager::attachCache()
+{
+    const CachedTile *entries = static_cast<const CachedTile *>(
+        cache_.at(0, kNumOfTiles * sizeof(CachedTile)));
+    if (entries == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < kNumOfTiles; i++) {
+        const CachedTile &entry = entries[i];
+        const uint8 *pixels = static_cast<const uint8 *>(
+            cache_.at(entry.pixels, TILE_WIDTH * TILE_HEIGHT));
+        const int32 *rows = static_cast<const int32 *>(
+            cache_.at(entry.rows, (TILE_HEIGHT + 1) * sizeof(int32)));
+        const PixelSpans::Span *spans = NULL;
+        if (rows != NULL) {
+            spans = static_cast<const PixelSpans::Span *>(
+                cache_.at(entry.spans, rows[TILE_HEIGHT] * sizeof(PixelSpans::Span)));
+        }
+        if (pixels == NULL || spans == NULL) {
+            for (int j = 0; j < i; j++) {
+                delete a_tiles_[j];
+                a_tiles_[j] = NULL;
+            }
+            cache_.close();
+            return false;
+        }
+        a_tiles_[i] = new Tile(i, pixels, rows, spans, entry.opaque != 0,
+            entry.notAlpha != 0, static_cast<Tile::EType>(entry.type));
+    }
     return true;
 }
 
@@ -27,6 +27,7 @@
 
 #include "common.h"
 #include "tile.h"
+#include "utils/assetcache.h"
 
 /*!
  * Tile manager loads and holds all the game tiles.
@@ -49,10 +50,16 @@ protected:
     Tile * loadTile(uint8 *tileData, uint8 id, Tile::EType type);
     //! Returns the good enum for the given data
     Tile::EType toTileType(uint8 data);
+    //! Writes the decoded tiles to the cache file
+    void saveCache();
+    //! Creates tiles from the cache file
+    bool attachCache();
 
 protected:
     //! All the tiles in the game
     Tile **a_tiles_;
+    /*! Cache file the tiles may point into.*/
+    AssetCache cache_;
 };
 
 #endif
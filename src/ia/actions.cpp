@@ -235,15 +235,16 @@ bool WalkAction::suspend(PedInstance *pPed) {
 }
 
 void WalkAction::doStart(Mission *pMission, PedInstance *pPed) {
-    // Go to given location at given speed
-    if (!pPed->initMovementToDestination(pMission, destLocT_, newSpeed_)) {
+    // Go to given location at given speed : path is searched in the background
+    if (!pPed->requestMovementToDestination(pMission, destLocT_, newSpeed_)) {
         setFailed();
         return;
     }
 }
 
 /*!
- * This method first updates movement for the ped.
+ * This method first checks if the path requested at start is available.
+ * Then it updates movement for the ped.
  * Then if the ped has no more destination point, it means that
  * he has arrived.
  * Else action continue.
@@ -252,8 +253,14 @@ void WalkAction::doStart(Mission *pMission, PedInstance *pPed) {
  * \param pPed The ped executing the action.
  */
 bool WalkAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed) {
+    if (pPed->isWaitingForPath() &&
+        pPed->updatePathRequest(pMission) == PedInstance::kPathRequestFailed) {
+        setFailed();
+        return false;
+    }
+
     bool updated = pPed->doMove(elapsed, pMission);
-    if (!pPed->hasDestination()) {
+    if (!pPed->hasDestination() && !pPed->isWaitingForPath()) {
         // Ped has arrived at destination
         setSucceeded();
     }
@@ -410,7 +417,7 @@ void FollowAction::doStart(Mission *pMission, PedInstance *pPed) {
     updateLastTargetPos();
     // If target is not too close, then initiate movement.
     if (!pPed->isCloseTo(pTarget_, kFollowDistance)) {
-        if (!pPed->initMovementToDestination(pMission, targetLastPos_)) {
+        if (!pPed->requestMovementToDestination(pMission, targetLastPos_)) {
             setFailed();
         }
     } else {
@@ -426,12 +433,20 @@ bool FollowAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed)
 
     if (pTarget_->isDead()) {
         // target is dead so stop moving and terminate action
+        pPed->cancelPathRequest(pMission);
         pPed->clearDestination();
         setFailed();
     } else {
+        if (pPed->isWaitingForPath() &&
+            pPed->updatePathRequest(pMission) == PedInstance::kPathRequestFailed) {
+            setFailed();
+            return false;
+        }
+
         if (pPed->speed() != 0) {
             if (pPed->isCloseTo(pTarget_, kFollowDistance)) {
                 // We reached the target so stop moving temporarily
+                pPed->cancelPathRequest(pMission);
                 pPed->clearDestination();
                 pPed->leaveState(targetState_);
             } else {
@@ -444,7 +459,7 @@ bool FollowAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed)
         if (!pTarget_->sameTile(targetLastPos_)) {
             // resetting target position
             updateLastTargetPos();
-            if (pPed->initMovementToDestination(pMission, targetLastPos_)) {
+            if (pPed->requestMovementToDestination(pMission, targetLastPos_)) {
                 targetState_ = PedInstance::pa_smWalking;
                 pPed->goToState(targetState_);
             } else {
@@ -112,6 +112,8 @@ typedef struct Key {
 #define isLetterH(codePoint) codePoint == 0x0068 || codePoint == 0x0048
 #define isLetterQ(codePoint) codePoint == 0x0071 || codePoint == 0x0051
 #define isLetterP(codePoint) codePoint == 0x0070 || codePoint == 0x0050
+#define isLetterR(codePoint) codePoint == 0x0072 || codePoint == 0x0052 || codePoint == 0x0012
+#define isLetterT(codePoint) codePoint == 0x0074 || codePoint == 0x0054 || codePoint == 0x0014
 
 #define K_PLUS    0x002B
 #define K_MINUS    0x002D
@@ -37,6 +37,7 @@ Map::Map(TileManager * tileManager, uint16 anId) : tile_manager_(tileManager)
 {
     id_ = anId;
     a_tiles_ = NULL;
+    version_ = 0;
 }
 
 Map::~Map()
@@ -84,11 +85,26 @@ bool Map::loadMap(uint8 * mapData)
     LOG(Log::k_FLG_GFX, "Map", "loadMap",
         ("Map size in pixels: width = %d, height = %d.", map_width_, map_height_));
 
+    version_++;
     LOG(Log::k_FLG_GFX, "Map", "loadMap", ("Loading finished"));
 
     return true;
 }
 
+/*!
+ * Only the map object and its array of tiles are counted : tiles are
+ * shared by all maps. loadMap() allocates one layer more than the file
+ * has and then increments max_z_, so max_z_ layers are counted.
+ */
+size_t Map::memorySize()
+{
+    size_t size = sizeof(Map);
+    if (a_tiles_) {
+        size += max_x_ * max_y_ * max_z_ * sizeof(Tile *);
+    }
+    return size;
+}
+
 void Map::mapDimensions(int *x, int *y, int *z)
 {
     *x = maxX();
@@ -248,6 +264,7 @@ void Map::patchMap(int x, int y, int z, uint8 tileNum)
         && (y >= 0 && y < max_y_)
         && (z >= 0 && z < max_z_));
     a_tiles_[(y * max_x_ + x) * max_z_ + z] = tile_manager_->getTile(tileNum);
+    version_++;
 }
 
 
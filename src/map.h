@@ -68,6 +68,10 @@ public:
     Tile * getTileAt(int x, int y, int z);
     int tileAt(int x, int y, int z);
     void patchMap(int x, int y, int z, uint8 tileNum);
+    //! Returns a number that changes each time tiles change
+    uint32 version() { return version_; }
+    //! Returns the memory used by the map in bytes
+    size_t memorySize();
     //! Return true if tile at given position is traversable by car
     bool isTileWalkableByCar(int x, int y, int z);
 
@@ -79,6 +83,8 @@ protected:
     Tile **a_tiles_;
     TileManager *tile_manager_;
     int map_width_, map_height_;
+    /*! Incremented each time tiles are loaded or patched.*/
+    uint32 version_;
 };
 
 /*!
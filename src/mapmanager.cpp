@@ -30,12 +30,16 @@
 
 MapManager::MapManager()
 {
+    cache_size_ = kDefaultCacheSize;
+    memory_used_ = 0;
 }
 
 MapManager::~MapManager()
 {
-    for (unsigned int i = 0; i < maps_.size(); i++)
-        delete maps_[i];
+    for (std::map<int, Map *>::iterator it = maps_.begin();
+        it != maps_.end(); ++it) {
+        delete it->second;
+    }
 }
 
 /*!
@@ -50,61 +54,101 @@ bool MapManager::initialize()
 /*!
  * Loads the given map.
  * First look in the map cache if the map already exists.
- * If the map exists, returns it. Otherwise, creates a new one.
+ * If the map exists, returns it. Otherwise, creates a new one and drops
+ * the oldest maps if the cache is full.
  * \param i_mapNum The map id.
  * \return NULL if map could not be loaded
  */
 Map * MapManager::loadMap(uint16 i_mapNum)
 {
-    char tmp[100];
-    int size;
-
     LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("loading map %i", i_mapNum));
     // First look in cache
     if (maps_.find(i_mapNum) != maps_.end()) {
         LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("Map is already in cache"));
+        lru_.remove(i_mapNum);
+        lru_.push_front(i_mapNum);
         return maps_[i_mapNum];
     }
-    
+
     // Not found so construct new one
     LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("Load new map"));
+    Map *p_map = createMap(i_mapNum);
+    if (p_map == NULL) {
+        return NULL;
+    }
+
+    maps_[i_mapNum] = p_map;
+    lru_.push_front(i_mapNum);
+    memory_used_ += p_map->memorySize();
+    evictMaps();
+
+    return p_map;
+}
+
+/*!
+ * Reads the map file and patches the map.
+ * \param i_mapNum The map id.
+ * \return NULL if map could not be loaded
+ */
+Map *MapManager::createMap(uint16 i_mapNum)
+{
+    char tmp[100];
+    int size;
+
     sprintf(tmp, "map%02d.dat", i_mapNum);
     uint8 *mapData = File::loadOriginalFile(tmp, size);
     if (mapData == NULL) {
         return NULL;
     }
 
-    maps_[i_mapNum] = new Map(&tileManager_, i_mapNum);
-    maps_[i_mapNum]->loadMap(mapData);
+    Map *p_map = new Map(&tileManager_, i_mapNum);
+    p_map->loadMap(mapData);
     // patch for "YUKON" map
     if (i_mapNum == 0x27) {
-        maps_[i_mapNum]->patchMap(60, 63, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 63, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 63, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 64, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 64, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 64, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 65, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 65, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 65, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 66, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 66, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 66, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 67, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 67, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 67, 1, 0x27);
+        p_map->patchMap(60, 63, 1, 0x27);
+        p_map->patchMap(61, 63, 1, 0x27);
+        p_map->patchMap(62, 63, 1, 0x27);
+        p_map->patchMap(60, 64, 1, 0x27);
+        p_map->patchMap(61, 64, 1, 0x27);
+        p_map->patchMap(62, 64, 1, 0x27);
+        p_map->patchMap(60, 65, 1, 0x27);
+        p_map->patchMap(61, 65, 1, 0x27);
+        p_map->patchMap(62, 65, 1, 0x27);
+        p_map->patchMap(60, 66, 1, 0x27);
+        p_map->patchMap(61, 66, 1, 0x27);
+        p_map->patchMap(62, 66, 1, 0x27);
+        p_map->patchMap(60, 67, 1, 0x27);
+        p_map->patchMap(61, 67, 1, 0x27);
+        p_map->patchMap(62, 67, 1, 0x27);
     }
     // patch for "INDONESIA" map
     // TODO: find better way to block access for our agents
     if (i_mapNum == 0x5B) {
-        maps_[i_mapNum]->patchMap(49, 27, 2, 0);
-        maps_[i_mapNum]->patchMap(49, 28, 2, 0);
-        maps_[i_mapNum]->patchMap(49, 29, 2, 0);
+        p_map->patchMap(49, 27, 2, 0);
+        p_map->patchMap(49, 28, 2, 0);
+        p_map->patchMap(49, 29, 2, 0);
     }
 
     delete[] mapData;
 
-    return maps_[i_mapNum];
+    return p_map;
+}
+
+/*!
+ * Drops the least recently loaded maps until the cache fits in its size.
+ * The most recent map is always kept.
+ */
+void MapManager::evictMaps()
+{
+    while (memory_used_ > cache_size_ && lru_.size() > 1) {
+        int id = lru_.back();
+        lru_.pop_back();
+        Map *p_map = maps_[id];
+        LOG(Log::k_FLG_IO, "MapManager", "evictMaps", ("dropping map %i from cache", id));
+        memory_used_ -= p_map->memorySize();
+        maps_.erase(id);
+        delete p_map;
+    }
 }
 
 /*!
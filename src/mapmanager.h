@@ -27,15 +27,23 @@
 #define MAPMANAGER_H
 
 #include <map>
+#include <list>
 #include "common.h"
 #include "map.h"
 #include "gfx/tilemanager.h"
 
 /*!
  * Map manager class.
+ * Loaded maps are kept in a cache. When the maps in the cache use more
+ * memory than allowed, the least recently loaded maps are dropped.
+ * Maps are only dropped by loadMap(), so a map stays valid until another
+ * map is loaded : a mission must not load other maps while it is played.
  */
 class MapManager {
 public:
+    /*! Default size of the cache in bytes.*/
+    static const size_t kDefaultCacheSize = 8 * 1024 * 1024;
+
     MapManager();
     ~MapManager();
 
@@ -45,9 +53,26 @@ public:
     Map * loadMap(uint16 i_mapNum);
     //! Look in the cache for the map with the given id
     Map *map(int mapNum);
+    //! Returns the tiles used by all maps
+    TileManager &tiles() { return tileManager_; }
+
+    //! Sets the memory that maps in the cache may use
+    void setCacheSize(size_t size) { cache_size_ = size; }
+    //! Returns the memory used by maps in the cache
+    size_t memoryUsed() { return memory_used_; }
+
+protected:
+    Map *createMap(uint16 i_mapNum);
+    void evictMaps();
 
 protected:
     std::map<int, Map *> maps_;
+    /*! Ids of cached maps, the most recently loaded first.*/
+    std::list<int> lru_;
+    /*! Maximum memory used by cached maps.*/
+    size_t cache_size_;
+    /*! Memory used by cached maps.*/
+    size_t memory_used_;
     TileManager tileManager_;
 };
 
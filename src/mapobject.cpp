@@ -575,6 +575,7 @@ ShootableMovableMapObject::ShootableMovableMapObject(uint16 anId, int m, ObjectN
     speed_ = 0;
     base_speed_ = 0;
     dist_to_pos_ = 0;
+    move_time_carry_ = 0.0;
 }
 
 /*!
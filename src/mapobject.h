@@ -508,6 +508,8 @@ protected:
     int speed_, base_speed_;
     //! on reaching this distance object should stop
     int dist_to_pos_;
+    //! Time left by doMove() because it was too short to move a unit
+    double move_time_carry_;
     std::list<TilePoint> dest_path_;
 };
 
@@ -238,10 +238,12 @@ void FliMenu::handleTick(int elapsed)
                 else if (desc.evtList[i].frame == frameIndex_) {
                     // Play music
                     if (desc.evtList[i].music != msc::NO_TRACK) {
+                        g_App.waitForAssets(fs_game_assets::kAssetMusic);
                         g_App.music().playTrack(desc.evtList[i].music);
                     }
                     // Play sound
                     if (desc.evtList[i].sound != snd::NO_SOUND) {
+                        g_App.waitForAssets(fs_game_assets::kAssetGameSounds);
                         g_App.gameSounds().play(desc.evtList[i].sound, desc.evtList[i].sndChan);
                     }
                     // Draw subtitle
@@ -27,12 +27,15 @@
  ************************************************************************/
 
 #include <stdio.h>
+#include <ctype.h>
+#include <time.h>
 #include <assert.h>
 #include "app.h"
 #include "gameplaymenu.h"
 #include "menus/gamemenuid.h"
 #include "gfx/fliplayer.h"
 #include "utils/file.h"
+#include "utils/profiler.h"
 #include "model/vehicle.h"
 #include "mission.h"
 #include "model/shot.h"
@@ -51,7 +54,7 @@ const int GameplayMenu::kMiniMapScreenY = 46 + 44 + 10 + 46 + 44 + 15 + 2 * 32 +
 
 GameplayMenu::GameplayMenu(MenuManager *m) :
 Menu(m, fs_game_menus::kMenuIdGameplay, fs_game_menus::kMenuIdDebrief, "", "mscrenup.dat"),
-tick_count_(0), last_animate_tick_(0), last_motion_tick_(0),
+tick_count_(0), last_motion_tick_(0),
 last_motion_x_(320), last_motion_y_(240), mission_hint_ticks_(0),
 mission_hint_(0), mission_(NULL), selection_(),
 target_(NULL),
@@ -341,59 +344,34 @@ void GameplayMenu::handleTick(int elapsed)
     }
 
     // Scroll the map
+    bool scrolled = false;
     if (scroll_x_ != 0) {
-        change = scrollOnX();
+        scrolled = scrollOnX();
         scroll_x_ = 0;
     }
 
     if (scroll_y_ != 0) {
-        change = scrollOnY();
+        scrolled |= scrollOnY();
         scroll_y_ = 0;
     }
+    change = scrolled;
 
-    if (tick_count_ - last_animate_tick_ > 33) {
-        int diff = tick_count_ - last_animate_tick_;
-        last_animate_tick_ = tick_count_;
+    // The application runs the simulation at a fixed step so objects
+    // are animated on every tick.
+    change |= mission_->animateObjects(elapsed);
 
-        for (size_t i = 0; i < mission_->numSfxObjects(); i++) {
-            SFXObject *pSfx = mission_->sfxObjects(i);
-            change |= pSfx->animate(diff);
-            if (pSfx->sfxLifeOver()) {
-                mission_->delSfxObject(i);
-                i--;
-            }
-        }
-
-        for (size_t i = 0; i < mission_->numPeds(); i++)
-            change |= mission_->ped(i)->animate(diff, mission_);
-
-
-        for (size_t i = 0; i < mission_->numVehicles(); i++)
-            change |= mission_->vehicle(i)->animate(diff);
-
-        for (size_t i = 0; i < mission_->numWeaponsOnGround(); i++)
-            change |= mission_->weaponOnGround(i)->animate(diff);
-
-        for (size_t i = 0; i < mission_->numStatics(); i++)
-            change |= mission_->statics(i)->animate(diff, mission_);
-
-        for (size_t i = 0; i < mission_->numPrjShots(); i++) {
-            change |= mission_->prjShots(i)->animate(diff, mission_);
-            if (mission_->prjShots(i)->isLifeOver()) {
-                mission_->delPrjShot(i);
-                i--;
-            }
-        }
-
-        updateMarkersPosition();
-    }
+    updateMarkersPosition();
 
     updateMinimap(elapsed);
 
     updateIPALevelMeters(elapsed);
 
+    if (change || Profiler::isEnabled()) {
+        // the map renderer finds by itself what changed on the map
+        // and reuses the last frame when the view has scrolled
+        addDirtyRect(0, 0, Screen::kScreenPanelWidth, GAME_SCREEN_HEIGHT);
+    }
     if (change) {
-        needRendering();
         // force target to update
         handleMouseMotion(last_motion_x_, last_motion_y_, 0, KMD_NONE);
     }
@@ -403,14 +381,29 @@ void GameplayMenu::handleTick(int elapsed)
 
 void GameplayMenu::handleRender(DirtyList &dirtyList)
 {
-    g_Screen.clear(0);
-    map_renderer_.render(displayOriginPt_);
-    g_Screen.drawRect(0,0, 129, GAME_SCREEN_HEIGHT);
-    agt_sel_renderer_.render(selection_, mission_->getSquad());
-    drawSelectAllButton();
-    drawMissionHint(0);
-    drawWeaponSelectors();
-    mm_renderer_.render(kMiniMapScreenX, kMiniMapScreenY);
+    // intersectsList() is true for rects that only touch : the map
+    // area is tested from one pixel after the panel
+    if (dirtyList.intersectsList(Screen::kScreenPanelWidth + 1, 0,
+        GAME_SCREEN_WIDTH - Screen::kScreenPanelWidth - 1, GAME_SCREEN_HEIGHT)) {
+        ProfileScope scope(Profiler::kSectionMapRender);
+        map_renderer_.render(displayOriginPt_);
+    } else {
+        ProfileScope scope(Profiler::kSectionMapRender);
+        map_renderer_.renderChanges(displayOriginPt_);
+    }
+
+    if (dirtyList.intersectsList(0, 0, Screen::kScreenPanelWidth, GAME_SCREEN_HEIGHT)) {
+        g_Screen.drawRect(0,0, 129, GAME_SCREEN_HEIGHT);
+        agt_sel_renderer_.render(selection_, mission_->getSquad());
+        drawSelectAllButton();
+        drawMissionHint(0);
+        drawWeaponSelectors();
+        mm_renderer_.render(kMiniMapScreenX, kMiniMapScreenY);
+    }
+
+    if (Profiler::isEnabled()) {
+        drawProfiler();
+    }
 
 #ifdef _DEBUG
     // drawing of different sprites
@@ -470,6 +463,95 @@ void GameplayMenu::handleRender(DirtyList &dirtyList)
 #endif
 }
 
+/*!
+ * For each section, shows the minimum, average and 99th percentile of
+ * its time over the last frames, in milliseconds, then the histogram of
+ * the duration of frames. The map renderer is told to draw the map under
+ * the overlay again on the next frame.
+ */
+void GameplayMenu::drawProfiler()
+{
+    static const int kWidth = 196;
+    static const int kNbBuckets = 20;
+    /*! Each bucket of the histogram covers 2ms.*/
+    static const uint32 kBucketSize = 2000;
+    static const int kGraphHeight = 30;
+    static const uint8 kColor = 14;
+
+    int lineHeight = gameFont()->textHeight(false) + 2;
+    int height = (Profiler::kNbRows + 2) * lineHeight + kGraphHeight + 8;
+    int x = Screen::kScreenWidth - kWidth - 2;
+    int y = 2;
+    g_Screen.drawRect(x, y, kWidth, height, 0);
+
+    int ty = y + 2;
+    gameFont()->drawText(x + 4, ty, "MS", kColor);
+    gameFont()->drawText(x + 76, ty, "MIN", kColor);
+    gameFont()->drawText(x + 116, ty, "AVG", kColor);
+    gameFont()->drawText(x + 156, ty, "P99", kColor);
+    ty += lineHeight;
+
+    char tmp[32];
+    for (int row = 0; row < Profiler::kNbRows; row++) {
+        Profiler::Stats stats;
+        Profiler::stats(row, &stats);
+
+        const char *name = Profiler::rowName(row);
+        size_t i = 0;
+        for (; name[i] != 0 && i < sizeof(tmp) - 1; i++) {
+            tmp[i] = toupper(name[i]);
+        }
+        tmp[i] = 0;
+        gameFont()->drawText(x + 4, ty, tmp, kColor);
+
+        sprintf(tmp, "%.2f", stats.min / 1000.0f);
+        gameFont()->drawText(x + 76, ty, tmp, kColor);
+        sprintf(tmp, "%.2f", stats.avg / 1000.0f);
+        gameFont()->drawText(x + 116, ty, tmp, kColor);
+        sprintf(tmp, "%.2f", stats.p99 / 1000.0f);
+        gameFont()->drawText(x + 156, ty, tmp, kColor);
+        ty += lineHeight;
+    }
+
+    int counts[kNbBuckets];
+    int maxCount = Profiler::histogram(Profiler::kRowFrame, kBucketSize,
+        counts, kNbBuckets);
+    int barWidth = (kWidth - 8) / kNbBuckets;
+    int base = ty + 2 + kGraphHeight;
+    for (int i = 0; i < kNbBuckets; i++) {
+        if (counts[i] > 0) {
+            int barHeight = counts[i] * kGraphHeight / maxCount;
+            if (barHeight == 0) {
+                barHeight = 1;
+            }
+            g_Screen.drawRect(x + 4 + i * barWidth, base - barHeight,
+                barWidth - 1, barHeight, kColor);
+        }
+    }
+    g_Screen.drawHLine(x + 4, base, kNbBuckets * barWidth, kColor);
+
+    sprintf(tmp, "FRAME 0-%dMS%s", kNbBuckets * kBucketSize / 1000,
+        Profiler::isTracing() ? "  REC" : "");
+    gameFont()->drawText(x + 4, base + 3, tmp, kColor);
+
+    map_renderer_.invalidateArea(x, y, kWidth, height);
+}
+
+/*!
+ * Timings are written in a file of the home directory named after the
+ * current time.
+ */
+void GameplayMenu::toggleProfilerTrace()
+{
+    if (Profiler::isTracing()) {
+        Profiler::stopTrace();
+    } else {
+        char filename[64];
+        sprintf(filename, "profile-%lu.csv", (unsigned long) time(NULL));
+        Profiler::startTrace(File::homeFullPath(filename).c_str());
+    }
+}
+
 void GameplayMenu::handleLeave()
 {
     g_App.music().stopPlayback();
@@ -480,7 +562,6 @@ void GameplayMenu::handleLeave()
     selection_.clear();
 
     tick_count_ = 0;
-    last_animate_tick_ = 0;
     last_motion_tick_ = 0;
     last_motion_x_ = 320;
     last_motion_y_ = 240;
@@ -898,18 +979,25 @@ bool GameplayMenu::handleUnknownKey(Key key, const int modKeys) {
 
     // Pause/unpause game
     if (isLetterP(key.unicode)) {
+        // TODO: translate all paused texts
+        std::string str_paused = getMessage("GAME_PAUSED");
+        MenuFont *font_used = getMenuFont(FontManager::SIZE_1);
+        int txt_width = font_used->textWidth(str_paused.c_str(), false);
+        int txt_posx = Screen::kScreenWidth / 2 - txt_width / 2;
+        int txt_height = font_used->textHeight(false);
+        int txt_posy = Screen::kScreenHeight / 2 - txt_height / 2;
+
         if (paused_) {
             paused_ = false;
+            // the box was drawn over the map : it is drawn again
+            map_renderer_.invalidateArea(txt_posx - 10, txt_posy - 5,
+                txt_width + 20, txt_height + 10);
+            addDirtyRect(txt_posx - 10, txt_posy - 5,
+                txt_width + 20, txt_height + 10);
         } else {
             paused_ = true;
-            // TODO: translate all paused texts
-            std::string str_paused = getMessage("GAME_PAUSED");
-            MenuFont *font_used = getMenuFont(FontManager::SIZE_1);
-            int txt_width = font_used->textWidth(str_paused.c_str(), false);
-            int txt_posx = Screen::kScreenWidth / 2 - txt_width / 2;
-            int txt_height = font_used->textHeight(false);
-            int txt_posy = Screen::kScreenHeight / 2 - txt_height / 2;
-
+            // frames reused while scrolling must not hold the box
+            map_renderer_.dropLastFrame();
             g_Screen.drawRect(txt_posx - 10, txt_posy - 5,
                 txt_width + 20, txt_height + 10);
             gameFont()->drawText(txt_posx, txt_posy, str_paused.c_str(), 11);
@@ -999,6 +1087,12 @@ bool GameplayMenu::handleUnknownKey(Key key, const int modKeys) {
         uint8 weapon_idx = (uint8) key.keyFunc - (uint8) KFC_F5;
         handleWeaponSelection(weapon_idx, ctrl);
         return true;
+    } else if ((isLetterT(key.unicode)) && ctrl) { // timings overlay
+        Profiler::setEnabled(!Profiler::isEnabled());
+        // map under the overlay is drawn again with the next frame
+        addDirtyRect(0, 0, Screen::kScreenPanelWidth, GAME_SCREEN_HEIGHT);
+    } else if ((isLetterR(key.unicode)) && ctrl) { // timings recorded to a file
+        toggleProfilerTrace();
     } else if ((isLetterD(key.unicode)) && ctrl) { // selected agents are killed with 'd'
         // save current selection as it will be modified when agents die
         std::vector<PedInstance *> agents_suicide;
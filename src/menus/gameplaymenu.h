@@ -69,6 +69,10 @@ protected:
     void drawSelectAllButton();
     void drawMissionHint(int elapsed);
     void drawWeaponSelectors();
+    //! Draws the timings of the last frames over the map
+    void drawProfiler();
+    //! Starts or stops writing frame timings to a file
+    void toggleProfilerTrace();
     //! Scroll the map horizontally.
     bool scrollOnX();
     //! Scroll the map vertically.
@@ -106,7 +110,7 @@ protected:
     /*! Origin of the minimap on the screen.*/
     static const int kMiniMapScreenY;
 
-    int tick_count_, last_animate_tick_;
+    int tick_count_;
     int last_motion_tick_, last_motion_x_, last_motion_y_;
     int mission_hint_ticks_, mission_hint_;
     Mission *mission_;
@@ -28,6 +28,7 @@
 #include <assert.h>
 
 #include "loadingmenu.h"
+#include "app.h"
 #include "gfx/screen.h"
 #include "mission.h"
 #include "core/gamecontroller.h"
@@ -46,6 +47,8 @@ LoadingMenu::LoadingMenu(MenuManager * m):Menu(m, fs_game_menus::kMenuIdLoading,
 void LoadingMenu::handleTick(int elapsed)
 {
     if (do_load_) {
+        // Data used by the game must be there
+        g_App.waitForAssets(fs_game_assets::kAssetsMission);
         // Loads mission
         int id = g_Session.getSelectedBlock().mis_id;
         Mission *pMission = g_gameCtrl.missions().loadMission(id);
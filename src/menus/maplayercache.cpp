@@ -0,0 +1,172 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <string.h>
+
+#include "menus/maplayercache.h"
+#include "map.h"
+#include "gfx/screen.h"
+#include "gfx/tile.h"
+
+namespace {
+    //! Division that rounds toward minus infinity
+    int floorDiv(int a, int b) {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+}
+
+MapLayerCache::MapLayerCache() {
+    p_map_ = NULL;
+    map_version_ = 0;
+    use_counter_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+}
+
+MapLayerCache::~MapLayerCache() {
+    clear();
+}
+
+void MapLayerCache::clear() {
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        delete[] chunks_[i].pixels;
+    }
+    chunks_.clear();
+}
+
+void MapLayerCache::setMap(Map *pMap) {
+    clear();
+    p_map_ = pMap;
+    map_version_ = pMap ? pMap->version() : 0;
+}
+
+/*!
+ * Returns the chunk at the given position, rendering it if needed.
+ */
+MapLayerCache::Chunk *MapLayerCache::getChunk(int cx, int cy) {
+    use_counter_++;
+    Chunk *pOldest = NULL;
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        Chunk *pChunk = &chunks_[i];
+        if (pChunk->cx == cx && pChunk->cy == cy) {
+            hits_++;
+            pChunk->lastUse = use_counter_;
+            return pChunk;
+        }
+        if (pOldest == NULL || pChunk->lastUse < pOldest->lastUse) {
+            pOldest = pChunk;
+        }
+    }
+
+    misses_++;
+    if (chunks_.size() < (size_t) kMaxChunks) {
+        Chunk chunk;
+        chunk.pixels = new uint8[kChunkSize * kChunkSize];
+        chunks_.push_back(chunk);
+        pOldest = &chunks_.back();
+    }
+    pOldest->cx = cx;
+    pOldest->cy = cy;
+    pOldest->lastUse = use_counter_;
+    renderChunk(pOldest);
+    return pOldest;
+}
+
+/*!
+ * Draws all tiles that cross the chunk.
+ * Tile (x, y, z) has its top left corner at map pixel
+ *   px = (maxX + x - y) * TILE_WIDTH / 2
+ *   py = (maxZ + x + y - z + 1) * TILE_HEIGHT / 3
+ * and tiles are drawn by increasing x + y + z, then decreasing z,
+ * then increasing x as in MapRenderer::render().
+ */
+void MapLayerCache::renderChunk(Chunk *pChunk) {
+    // same background as the screen before rendering
+    memset(pChunk->pixels, 0, kChunkSize * kChunkSize);
+
+    int maxX = p_map_->maxX();
+    int maxY = p_map_->maxY();
+    int maxZ = p_map_->maxZ();
+    int x0 = pChunk->cx * kChunkSize;
+    int y0 = pChunk->cy * kChunkSize;
+
+    // u = x - y and w = x + y - z of tiles that cross the chunk
+    int uMin = floorDiv(x0 - TILE_WIDTH, TILE_WIDTH / 2) - maxX;
+    int uMax = floorDiv(x0 + kChunkSize, TILE_WIDTH / 2) - maxX;
+    int wMin = floorDiv(y0 - TILE_HEIGHT, TILE_HEIGHT / 3) - maxZ - 1;
+    int wMax = floorDiv(y0 + kChunkSize, TILE_HEIGHT / 3) - maxZ - 1;
+
+    int maxV = maxX + maxY - 2;
+    for (int s = 0; s <= maxV + maxZ - 1; s++) {
+        for (int z = (s < maxZ - 1 ? s : maxZ - 1); z >= 0; z--) {
+            int v = s - z;
+            int w = v - z;
+            if (v > maxV || w < wMin || w > wMax) {
+                continue;
+            }
+            int py = (maxZ + w + 1) * (TILE_HEIGHT / 3) - y0;
+            // x - y has the same parity as x + y
+            int u = uMin;
+            if ((u + v) & 1) {
+                u++;
+            }
+            for (; u <= uMax; u += 2) {
+                int x = (u + v) / 2;
+                int y = (v - u) / 2;
+                if (x < 0 || x >= maxX || y < 0 || y >= maxY) {
+                    continue;
+                }
+                Tile *pTile = p_map_->getTileAt(x, y, z);
+                if (pTile->notTransparent()) {
+                    pTile->drawTo(pChunk->pixels, kChunkSize, kChunkSize,
+                        (maxX + u) * (TILE_WIDTH / 2) - x0, py);
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * \param viewport Position of the screen on the map image
+ */
+void MapLayerCache::draw(const Point2D &viewport) {
+    if (p_map_ == NULL) {
+        return;
+    }
+    if (map_version_ != p_map_->version()) {
+        clear();
+        map_version_ = p_map_->version();
+    }
+
+    // map pixel at the left of the game area
+    int left = viewport.x;
+    int right = viewport.x + Screen::kScreenWidth - Screen::kScreenPanelWidth;
+    int top = viewport.y;
+    int bottom = viewport.y + Screen::kScreenHeight;
+
+    for (int cy = floorDiv(top, kChunkSize); cy * kChunkSize < bottom; cy++) {
+        for (int cx = floorDiv(left, kChunkSize); cx * kChunkSize < right; cx++) {
+            Chunk *pChunk = getChunk(cx, cy);
+            g_Screen.copyRect(cx * kChunkSize - viewport.x + Screen::kScreenPanelWidth,
+                cy * kChunkSize - viewport.y, kChunkSize, kChunkSize, pChunk->pixels);
+        }
+    }
+}
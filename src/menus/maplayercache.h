@@ -0,0 +1,86 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef MENUS_MAPLAYERCACHE_H_
+#define MENUS_MAPLAYERCACHE_H_
+
+#include <vector>
+
+#include "common.h"
+
+class Map;
+
+/*!
+ * Cache of the map tiles rendered in off-screen chunks.
+ * The map image (without objects) is cut into square chunks of kChunkSize
+ * pixels. A chunk is rendered the first time it is visible and kept until
+ * it is the least recently used of kMaxChunks chunks. All chunks are
+ * dropped when the map changes (see Map::version()).
+ * Tiles are drawn in the same order as MapRenderer::render() so that a
+ * chunk is identical to what the renderer would have drawn.
+ */
+class MapLayerCache {
+public:
+    /*! Size in pixels of a chunk.*/
+    static const int kChunkSize = 256;
+    /*! Maximum number of chunks kept in memory.*/
+    static const int kMaxChunks = 32;
+
+    MapLayerCache();
+    ~MapLayerCache();
+
+    //! Sets the map to render and drops all chunks
+    void setMap(Map *pMap);
+    //! Copies the tiles visible from the viewport to the screen
+    void draw(const Point2D &viewport);
+
+    //! Returns the number of chunks found in the cache
+    uint32 hits() { return hits_; }
+    //! Returns the number of chunks rendered
+    uint32 misses() { return misses_; }
+
+protected:
+    /*!
+     * A part of the map image.
+     */
+    struct Chunk {
+        /*! Position of the chunk in number of chunks.*/
+        int cx, cy;
+        /*! Value of the use counter when the chunk was last drawn.*/
+        uint32 lastUse;
+        uint8 *pixels;
+    };
+
+    void clear();
+    Chunk *getChunk(int cx, int cy);
+    void renderChunk(Chunk *pChunk);
+
+protected:
+    Map *p_map_;
+    /*! Version of the map when chunks were rendered.*/
+    uint32 map_version_;
+    std::vector<Chunk> chunks_;
+    uint32 use_counter_;
+    uint32 hits_;
+    uint32 misses_;
+};
+
+#endif  // MENUS_MAPLAYERCACHE_H_
@@ -25,8 +25,11 @@
  *                                                                      *
  ************************************************************************/
 
+#include <algorithm>
+
 #include "menus/maprenderer.h"
 #include "mission.h"
+#include "objectgrid.h"
 #include "agentmanager.h"
 #include "mapobject.h"
 #include "model/vehicle.h"
@@ -40,12 +43,143 @@ void MapRenderer::init(Mission *pMission, SquadSelection *pSelection) {
     pMission_ = pMission;
     pMap_ = pMission->get_map();
     pSelection_ = pSelection;
+    layerCache_.setMap(pMap_);
+    hasLastFrame_ = false;
 }
 
 /**
- * Draw tiles and map objects.
+ * Draw tiles and map objects on the whole map area.
  */
 void MapRenderer::render(const Point2D &viewport) {
+    DEBUG_SPEED_INIT
+
+    overdrawnAreas_.clear();
+    listObjectsToDraw(viewport);
+    sortObjectsToDraw();
+    measureObjects(viewport);
+
+    drawArea(viewport, Screen::kScreenPanelWidth, 0,
+        Screen::kScreenWidth - Screen::kScreenPanelWidth, Screen::kScreenHeight);
+    endFrame(viewport);
+
+#ifdef _DEBUG
+    if (g_System.getKeyModState() & KMD_LALT) {
+        for (SquadSelection::Iterator it = pSelection_->begin();
+            it != pSelection_->end(); ++it) {
+            (*it)->showPath(viewport.x, viewport.y);
+        }
+    }
+#endif
+
+    DEBUG_SPEED_LOG("MapRenderer::render")
+}
+
+/**
+ * Draw only the parts of the map area that changed since the last frame :
+ * where objects appeared, disappeared, moved or changed their animation.
+ * If the viewport moved, the pixels of the last frame are moved with it
+ * and only the strips uncovered by the move are drawn in addition.
+ * If the map changed, the whole area is drawn.
+ */
+void MapRenderer::renderChanges(const Point2D &viewport) {
+    // move of the last frame pixels on screen
+    int dx = lastViewport_.x - viewport.x;
+    int dy = lastViewport_.y - viewport.y;
+    int areaWidth = Screen::kScreenWidth - Screen::kScreenPanelWidth;
+    if (!hasLastFrame_ || mapVersion_ != pMap_->version()
+        || dx <= -areaWidth || dx >= areaWidth
+        || dy <= -Screen::kScreenHeight || dy >= Screen::kScreenHeight) {
+        render(viewport);
+        return;
+    }
+#ifdef _DEBUG
+    if (g_System.getKeyModState() & KMD_LALT) {
+        // paths are not tracked
+        render(viewport);
+        return;
+    }
+#endif
+
+    listObjectsToDraw(viewport);
+    sortObjectsToDraw();
+    measureObjects(viewport);
+    changedAreas_.clear();
+    findChangedAreas(dx, dy);
+    // what was drawn over the last frame has moved with it
+    for (size_t i = 0; i < overdrawnAreas_.size(); i++) {
+        const DirtyRect &area = overdrawnAreas_[i];
+        addChangedArea(area.x + dx, area.y + dy, area.width, area.height);
+    }
+    overdrawnAreas_.clear();
+
+    if (dx != 0 || dy != 0) {
+        g_Screen.scrollRect(Screen::kScreenPanelWidth, 0, areaWidth,
+            Screen::kScreenHeight, dx, dy);
+        // uncovered strips
+        if (dx > 0) {
+            addChangedArea(Screen::kScreenPanelWidth, 0, dx, Screen::kScreenHeight);
+        } else if (dx < 0) {
+            addChangedArea(Screen::kScreenWidth + dx, 0, -dx, Screen::kScreenHeight);
+        }
+        if (dy > 0) {
+            addChangedArea(Screen::kScreenPanelWidth, 0, areaWidth, dy);
+        } else if (dy < 0) {
+            addChangedArea(Screen::kScreenPanelWidth, Screen::kScreenHeight + dy,
+                areaWidth, -dy);
+        }
+    }
+
+    for (size_t i = 0; i < changedAreas_.size(); i++) {
+        const DirtyRect &area = changedAreas_[i];
+        drawArea(viewport, area.x, area.y, area.width, area.height);
+    }
+    endFrame(viewport);
+}
+
+/**
+ * The area is drawn again by the next call to renderChanges().
+ */
+void MapRenderer::invalidateArea(int x, int y, int width, int height) {
+    DirtyRect area = {x, y, width, height};
+    overdrawnAreas_.push_back(area);
+}
+
+/**
+ * Draws tiles and objects in the given rectangle of the screen.
+ * All tiles are copied from the cache, then objects are drawn in
+ * depth order and only tiles in front of an object are drawn again.
+ */
+void MapRenderer::drawArea(const Point2D &viewport, int x, int y, int width, int height) {
+    DirtyRect area = {x, y, width, height};
+    area_ = area;
+    g_Screen.setClipRect(x, y, width, height);
+    layerCache_.draw(viewport);
+    clearCoverage();
+    drawCursor_ = 0;
+    walkTiles(viewport, false);
+    g_Screen.resetClipRect();
+}
+
+/**
+ * Keeps what was drawn for the next call to renderChanges().
+ */
+void MapRenderer::endFrame(const Point2D &viewport) {
+    // Objects that were listed for drawing may be bigger than objects
+    // really drawn : they are dropped with the list
+    drawList_.clear();
+    lastObjects_.swap(drawnObjects_);
+    lastViewport_ = viewport;
+    mapVersion_ = pMap_->version();
+    hasLastFrame_ = true;
+}
+
+/**
+ * Walks all visible tiles from back to front.
+ * \param viewport Position of the screen on the map
+ * \param measuring If true, objects are measured and nothing is drawn. If
+ * false, objects and tiles in front of them are drawn.
+ */
+void MapRenderer::walkTiles(const Point2D &viewport, bool measuring) {
     // TODO: list of bugs to fix in rendering
     //  - Some advert panels lack a corner
     TilePoint mtp = pMap_->screenToTilePoint(viewport.x, viewport.y);
@@ -56,10 +190,6 @@ void MapRenderer::render(const Point2D &viewport) {
 
     int shm = sh + chk;
 
-    DEBUG_SPEED_INIT
-
-    listObjectsToDraw(viewport);
-
     int cmw = viewport.x + Screen::kScreenWidth -
                 Screen::kScreenPanelWidth + 128;
     int cmh = viewport.y + Screen::kScreenHeight + 128;
@@ -93,7 +223,7 @@ void MapRenderer::render(const Point2D &viewport) {
                         continue;
 #endif
                     // draw a tile
-                    if (tile_z < pMap_->maxZ()) {
+                    if (!measuring && tile_z < pMap_->maxZ()) {
                         Tile *p_tile = pMap_->getTileAt(tile_x, tile_y, tile_z);
                         if (p_tile->notTransparent()) {
                             int dx = 0, dy = 0;
@@ -102,7 +232,8 @@ void MapRenderer::render(const Point2D &viewport) {
                             if (coord_h - viewport.y < 0)
                                 dy = -(coord_h - viewport.y);
                             if (dx < TILE_WIDTH && dy < TILE_HEIGHT) {
-                                p_tile->drawToScreen(screen_w - cmx, coord_h - viewport.y);
+                                drawTileInCoveredCells(p_tile, screen_w - cmx,
+                                    coord_h - viewport.y);
                             }
                         }
                     }
@@ -113,7 +244,7 @@ void MapRenderer::render(const Point2D &viewport) {
                         Point2D screenPos = {screen_w - cmx + TILE_WIDTH / 2,
                             coord_h - viewport.y + TILE_HEIGHT / 3 * 2};
 
-                        drawObjectsOnTile(currentTile, screenPos);
+                        drawObjectsOnTile(currentTile, screenPos, measuring);
                     }
                 }
                 --tile_y;
@@ -121,71 +252,205 @@ void MapRenderer::render(const Point2D &viewport) {
             --tile_z;
         }
     }
+}
+
+/**
+ * Finds the area and the signature of all objects to draw.
+ */
+void MapRenderer::measureObjects(const Point2D &viewport) {
+    drawnObjects_.clear();
+    drawCursor_ = 0;
+    walkTiles(viewport, true);
+    std::sort(drawnObjects_.begin(), drawnObjects_.end());
+}
 
-    freeUnreleasedResources();
+/**
+ * Compares objects of this frame with those of the last frame and lists
+ * the areas of the screen that must be drawn again.
+ * \param dx Horizontal move of the last frame on screen
+ * \param dy Vertical move of the last frame on screen
+ */
+void MapRenderer::findChangedAreas(int dx, int dy) {
+    size_t first = changedAreas_.size();
 
-#ifdef _DEBUG
-    if (g_System.getKeyModState() & KMD_LALT) {
-        for (SquadSelection::Iterator it = pSelection_->begin();
-            it != pSelection_->end(); ++it) {
-            (*it)->showPath(viewport.x, viewport.y);
+    // both lists are sorted by address
+    std::vector<DrawnObject>::const_iterator itLast = lastObjects_.begin();
+    std::vector<DrawnObject>::const_iterator itNew = drawnObjects_.begin();
+    while (itLast != lastObjects_.end() || itNew != drawnObjects_.end()) {
+        if (itNew == drawnObjects_.end()
+            || (itLast != lastObjects_.end() && itLast->pObject < itNew->pObject)) {
+            // object is no more drawn
+            addChangedArea(itLast->x + dx, itLast->y + dy, itLast->width, itLast->height);
+            ++itLast;
+        } else if (itLast == lastObjects_.end() || itNew->pObject < itLast->pObject) {
+            // object is drawn for the first time
+            addChangedArea(itNew->x, itNew->y, itNew->width, itNew->height);
+            ++itNew;
+        } else {
+            if (itLast->key != itNew->key || itLast->x + dx != itNew->x
+                || itLast->y + dy != itNew->y
+                || itLast->width != itNew->width || itLast->height != itNew->height
+                || itLast->signature != itNew->signature) {
+                addChangedArea(itLast->x + dx, itLast->y + dy, itLast->width, itLast->height);
+                addChangedArea(itNew->x, itNew->y, itNew->width, itNew->height);
+            }
+            ++itLast;
+            ++itNew;
         }
     }
-#endif
 
-    DEBUG_SPEED_LOG("MapRenderer::render")
+    if (changedAreas_.size() - first > kMaxChangedAreas) {
+        // too many areas : draw their bounding box once
+        DirtyRect box = changedAreas_[first];
+        for (size_t i = first + 1; i < changedAreas_.size(); i++) {
+            mergeRect(&box, changedAreas_[i]);
+        }
+        changedAreas_.resize(first);
+        addChangedArea(box.x, box.y, box.width, box.height);
+    }
+}
+
+/**
+ * Adds the area, clipped to the map area, to the list of changed areas.
+ * Overlapping areas are merged so that no pixel is drawn twice.
+ */
+void MapRenderer::addChangedArea(int x, int y, int width, int height) {
+    // Areas are aligned on the coverage grid so that tiles in front of
+    // objects are drawn the same way as when the whole area is drawn
+    int x1 = x < 0 ? 0 : x / kCoverCellSize * kCoverCellSize;
+    int y1 = y < 0 ? 0 : y / kCoverCellSize * kCoverCellSize;
+    int x2 = (x + width + kCoverCellSize - 1) / kCoverCellSize * kCoverCellSize;
+    int y2 = (y + height + kCoverCellSize - 1) / kCoverCellSize * kCoverCellSize;
+    if (x1 < Screen::kScreenPanelWidth) {
+        x1 = Screen::kScreenPanelWidth;
+    }
+    if (x2 > Screen::kScreenWidth) {
+        x2 = Screen::kScreenWidth;
+    }
+    if (y2 > Screen::kScreenHeight) {
+        y2 = Screen::kScreenHeight;
+    }
+    if (x2 <= x1 || y2 <= y1) {
+        return;
+    }
+
+    DirtyRect area = {x1, y1, x2 - x1, y2 - y1};
+    size_t i = 0;
+    while (i < changedAreas_.size()) {
+        const DirtyRect &other = changedAreas_[i];
+        if (other.x < area.x + area.width && area.x < other.x + other.width
+            && other.y < area.y + area.height && area.y < other.y + other.height) {
+            mergeRect(&area, other);
+            changedAreas_.erase(changedAreas_.begin() + i);
+            // the larger area may now overlap areas already tested
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    changedAreas_.push_back(area);
 }
 
-int MapRenderer::tileHashKey(MapObject * m) {
-    return tileHashKey(m->position());
+void MapRenderer::mergeRect(DirtyRect *pRect, const DirtyRect &other) {
+    int x2 = pRect->x + pRect->width;
+    int y2 = pRect->y + pRect->height;
+    if (other.x + other.width > x2) {
+        x2 = other.x + other.width;
+    }
+    if (other.y + other.height > y2) {
+        y2 = other.y + other.height;
+    }
+    if (other.x < pRect->x) {
+        pRect->x = other.x;
+    }
+    if (other.y < pRect->y) {
+        pRect->y = other.y;
+    }
+    pRect->width = x2 - pRect->x;
+    pRect->height = y2 - pRect->y;
+}
+
+/*!
+ * Tiles are walked by increasing x + y + z, then decreasing z, then
+ * increasing x : the key encodes those values in that order so that
+ * comparing keys gives the drawing order.
+ * \param tilePos Tile coordinates
+ * \param pKey Set with the key
+ * \return False if the tile is out of the range of the walk
+ */
+bool MapRenderer::drawKey(const TilePoint &tilePos, uint32 *pKey) {
+    if (tilePos.tx < 0 || tilePos.tx > 255 || tilePos.ty < 0 || tilePos.ty > 255
+        || tilePos.tz < 0 || tilePos.tz > 255) {
+        return false;
+    }
+    *pKey = ((tilePos.tx + tilePos.ty + tilePos.tz) << 16)
+        | ((255 - tilePos.tz) << 8) | tilePos.tx;
+    return true;
 }
 
 void MapRenderer::listObjectsToDraw(const Point2D &viewport) {
-    /*if (tilex < 0)
-        tilex = 0;
-    if (tiley < 0)
-        tiley = 0;
-    if (maxtilex >= pMap_->maxX())
-        maxtilex = pMap_->maxX();
-    if (maxtiley >= pMap_->maxY())
-        maxtiley = pMap_->maxY();*/
+    drawList_.clear();
+    drawCursor_ = 0;
+
+    // Drawing area in tile diagonals : u = tx - ty and v = tx + ty
+    // (see isObjectInsideDrawingArea() and Map::tileToScreenPoint())
+    int minU = (viewport.x - TILE_WIDTH - pMap_->maxX() * (TILE_WIDTH / 2))
+        / (TILE_WIDTH / 2) - 1;
+    int maxU = (viewport.x + Screen::kScreenWidth - Screen::kScreenPanelWidth + 10
+        - pMap_->maxX() * (TILE_WIDTH / 2)) / (TILE_WIDTH / 2) + 1;
+    int minV = (viewport.y - (pMap_->maxZ() + 1) * (TILE_HEIGHT / 3))
+        / (TILE_HEIGHT / 3) - 1;
+    int maxV = (viewport.y + Screen::kScreenHeight + pMap_->maxZ() * 48
+        - (pMap_->maxZ() + 1) * (TILE_HEIGHT / 3)) / (TILE_HEIGHT / 3) + 1;
 
+    // Only objects in the rectangle of tiles around that area are tested
+    ObjectGrid *pGrid = pMission_->objectGrid();
+    int minTileX = (minU + minV) / 2 - 1;
+    int maxTileX = (maxU + maxV) / 2 + 1;
+    int minTileY = (minV - maxU) / 2 - 1;
+    int maxTileY = (maxV - minU) / 2 + 1;
+    std::vector<int> indexes;
 
     // Include peds
-    for (size_t i = 0; i < pMission_->numPeds(); i++) {
-        PedInstance *pPed = pMission_->ped(i);
+    pGrid->findInTiles(ObjectGrid::kKindPed, minTileX, minTileY, maxTileX, maxTileY, indexes);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        PedInstance *pPed = pMission_->ped(indexes[n]);
         if (pPed->isDrawable() && isObjectInsideDrawingArea(pPed, viewport)) {
             addObjectToDraw(pPed);
         }
     }
 
     // vehicles
-    for (size_t i = 0; i < pMission_->numVehicles(); i++) {
-        Vehicle *pVehicle = pMission_->vehicle(i);
+    pGrid->findInTiles(ObjectGrid::kKindVehicle, minTileX, minTileY, maxTileX, maxTileY, indexes);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        Vehicle *pVehicle = pMission_->vehicle(indexes[n]);
         if (isObjectInsideDrawingArea(pVehicle, viewport)) {
             addObjectToDraw(pVehicle);
         }
     }
 
     // weapons
-    for (size_t i = 0; i < pMission_->numWeaponsOnGround(); i++) {
-        WeaponInstance *pWeapon = pMission_->weaponOnGround(i);
+    pGrid->findInTiles(ObjectGrid::kKindWeapon, minTileX, minTileY, maxTileX, maxTileY, indexes);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        WeaponInstance *pWeapon = pMission_->weaponOnGround(indexes[n]);
         if (pWeapon->isDrawable() && isObjectInsideDrawingArea(pWeapon, viewport)) {
             addObjectToDraw(pWeapon);
         }
     }
 
     // statics
-    for (size_t i = 0; i < pMission_->numStatics(); i++) {
-        Static *pStatic = pMission_->statics(i);
+    pGrid->findInTiles(ObjectGrid::kKindStatic, minTileX, minTileY, maxTileX, maxTileY, indexes);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        Static *pStatic = pMission_->statics(indexes[n]);
         if (isObjectInsideDrawingArea(pStatic, viewport)) {
             addObjectToDraw(pStatic);
         }
     }
 
     // sfx objects
-    for (size_t i = 0; i < pMission_->numSfxObjects(); i++) {
-        SFXObject *pSfx = pMission_->sfxObjects(i);
+    pGrid->findInTiles(ObjectGrid::kKindSfx, minTileX, minTileY, maxTileX, maxTileY, indexes);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        SFXObject *pSfx = pMission_->sfxObjects(indexes[n]);
         if (pSfx->isDrawable() && isObjectInsideDrawingArea(pSfx, viewport)) {
             addObjectToDraw(pSfx);
         }
@@ -215,102 +480,231 @@ bool MapRenderer::isObjectInsideDrawingArea(MapObject *pObject, const Point2D &v
  * Draw all objects on the given tile.
  * \param tilePos const TilePoint& tile coordinates
  * \param screenPos const Point2D& position of tile on the screen
+ * \param measuring If true, objects are measured instead of drawn
  * \return int number of objects for debug
  *
  */
-int MapRenderer::drawObjectsOnTile(const TilePoint & tilePos, const Point2D &screenPos) {
-    int tileKey = tileHashKey(tilePos);
+int MapRenderer::drawObjectsOnTile(const TilePoint & tilePos, const Point2D &screenPos,
+        bool measuring) {
+    uint32 tileKey;
     int nbDrawnObjects = 0;
 
-    std::map<int, ObjectToDraw *>::iterator it = objectsByTile_.find(tileKey);
-    if(it != objectsByTile_.end()) {
-        ObjectToDraw *pObj = it->second;
-        objectsByTile_.erase(it);
-        while(pObj != NULL) {
-            pObj->getObject()->draw(screenPos.x, screenPos.y);
-            ObjectToDraw *pNext = pObj->getNext();
-            pool_.releaseResource(pObj);
-            pObj = pNext;
-            nbDrawnObjects++;
+    if (!drawKey(tilePos, &tileKey)) {
+        return 0;
+    }
+
+    // Tiles are walked in the order of the list : objects whose tile
+    // was skipped are not drawn
+    while (drawCursor_ < drawList_.size() && drawList_[drawCursor_].key < tileKey) {
+        drawCursor_++;
+    }
+
+    while (drawCursor_ < drawList_.size() && drawList_[drawCursor_].key == tileKey) {
+        MapObject *pObject = drawList_[drawCursor_].pObject;
+        int x, y, width, height;
+        if (measuring) {
+            g_Screen.startMeasuring();
+            pObject->draw(screenPos.x, screenPos.y);
+            if (g_Screen.stopAreaTracking(&x, &y, &width, &height)) {
+                DrawnObject drawn = {pObject, tileKey, x, y, width, height,
+                    g_Screen.measuredSignature()};
+                drawnObjects_.push_back(drawn);
+            }
+        } else {
+            g_Screen.startAreaTracking();
+            pObject->draw(screenPos.x, screenPos.y);
+            if (g_Screen.stopAreaTracking(&x, &y, &width, &height)) {
+                markCovered(x, y, width, height);
+            }
         }
+        drawCursor_++;
+        nbDrawnObjects++;
     }
 
     return nbDrawnObjects;
 }
 
 
+void MapRenderer::clearCoverage() {
+    covered_.assign((Screen::kScreenWidth / kCoverCellSize) *
+        (Screen::kScreenHeight / kCoverCellSize), false);
+    nothingCovered_ = true;
+}
+
+/**
+ * Marks the cells of the coverage grid that intersect the given rectangle.
+ */
+void MapRenderer::markCovered(int x, int y, int width, int height) {
+    int nbCols = Screen::kScreenWidth / kCoverCellSize;
+    int nbRows = Screen::kScreenHeight / kCoverCellSize;
+    int minCol = x < 0 ? 0 : x / kCoverCellSize;
+    int minRow = y < 0 ? 0 : y / kCoverCellSize;
+    int maxCol = (x + width - 1) / kCoverCellSize;
+    int maxRow = (y + height - 1) / kCoverCellSize;
+    if (maxCol >= nbCols) {
+        maxCol = nbCols - 1;
+    }
+    if (maxRow >= nbRows) {
+        maxRow = nbRows - 1;
+    }
+
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int col = minCol; col <= maxCol; col++) {
+            covered_[row * nbCols + col] = true;
+            nothingCovered_ = false;
+        }
+    }
+}
+
+/**
+ * Draws a tile again over the objects drawn before it. The tile is
+ * clipped to the covered cells : out of them, the tiles in front of it
+ * are not drawn again and must stay on top of it.
+ * \param pTile Tile to draw
+ * \param x Position of the tile on screen
+ * \param y Position of the tile on screen
+ */
+void MapRenderer::drawTileInCoveredCells(Tile *pTile, int x, int y) {
+    if (nothingCovered_ || x + TILE_WIDTH <= 0 || y + TILE_HEIGHT <= 0
+        || x >= Screen::kScreenWidth || y >= Screen::kScreenHeight) {
+        return;
+    }
+
+    int nbCols = Screen::kScreenWidth / kCoverCellSize;
+    int nbRows = Screen::kScreenHeight / kCoverCellSize;
+    int minCol = x < 0 ? 0 : x / kCoverCellSize;
+    int minRow = y < 0 ? 0 : y / kCoverCellSize;
+    int maxCol = (x + TILE_WIDTH - 1) / kCoverCellSize;
+    int maxRow = (y + TILE_HEIGHT - 1) / kCoverCellSize;
+    if (maxCol >= nbCols) {
+        maxCol = nbCols - 1;
+    }
+    if (maxRow >= nbRows) {
+        maxRow = nbRows - 1;
+    }
+
+    bool drawn = false;
+    for (int row = minRow; row <= maxRow; row++) {
+        int col = minCol;
+        while (col <= maxCol) {
+            if (!covered_[row * nbCols + col]) {
+                col++;
+                continue;
+            }
+            // run of covered cells on the row, inside the drawn area
+            int first = col;
+            while (col <= maxCol && covered_[row * nbCols + col]) {
+                col++;
+            }
+            int x1 = first * kCoverCellSize;
+            int y1 = row * kCoverCellSize;
+            int x2 = col * kCoverCellSize;
+            int y2 = y1 + kCoverCellSize;
+            if (x1 < area_.x) {
+                x1 = area_.x;
+            }
+            if (y1 < area_.y) {
+                y1 = area_.y;
+            }
+            if (x2 > area_.x + area_.width) {
+                x2 = area_.x + area_.width;
+            }
+            if (y2 > area_.y + area_.height) {
+                y2 = area_.y + area_.height;
+            }
+            if (x1 < x2 && y1 < y2) {
+                g_Screen.setClipRect(x1, y1, x2 - x1, y2 - y1);
+                pTile->drawToScreen(x, y);
+                drawn = true;
+            }
+        }
+    }
+    if (drawn) {
+        g_Screen.setClipRect(area_.x, area_.y, area_.width, area_.height);
+    }
+}
+
 /**
- * Adds an object to the list of objects to draw for the tile it's on.
- * For a given tile object are sorted from back to front so that
- * objects in the back are drawn first.
+ * Adds an object to the list of objects to draw.
  * \param pObjectToAdd MapObject* Object to add
  * \return void
  *
  */
 void MapRenderer::addObjectToDraw(MapObject *pObjectToAdd) {
-    int tileKey;
-    ObjectToDraw *pNewEntry = pool_.getResource();
-    pNewEntry->setObject(pObjectToAdd);
+    DrawEntry entry;
+    entry.pObject = pObjectToAdd;
 
+    TilePoint tilePos(pObjectToAdd->position());
     if (pObjectToAdd->is(MapObject::kNatureVehicle)) {
         // vehicle are associated with the tile just above (z+1)
         // because it is bigger than a tile so all tiles below must be drawn first
-        TilePoint vehiclePos( pObjectToAdd->position());
-        vehiclePos.tz += 1;
-        tileKey = tileHashKey(vehiclePos);
-    } else {
-        tileKey = tileHashKey(pObjectToAdd);
-    }
-
-    std::map<int, ObjectToDraw *>::iterator element = objectsByTile_.find(tileKey);
-    if(element == objectsByTile_.end()) {
-        // no element has been set with the tile so add the first element
-        objectsByTile_[tileKey] = pNewEntry;
-    } else {
-        // there is at leastone element already set with the tile
-        ObjectToDraw *pObjectInList = element->second;
-        if (pObjectToAdd->isBehindObjectOnSameTile(pObjectInList->getObject())) {
-            // first case is when the new object should be first in the list
-            pNewEntry->setNext(pObjectInList);
-            objectsByTile_[tileKey] = pNewEntry;
-        } else {
-            // second case is when new object is somewhere in the list
-            while (pObjectInList != NULL) {
-                if (pObjectInList->getNext() != NULL) {
-                    if (pObjectToAdd->isBehindObjectOnSameTile(pObjectInList->getNext()->getObject())) {
-                        pObjectInList->insertNext(pNewEntry);
-                        break;
-                    } else {
-                        pObjectInList = pObjectInList->getNext();
-                    }
-                } else {
-                    pObjectInList->setNext(pNewEntry);
-                    break;
-                }
+        tilePos.tz += 1;
+    }
+
+    if (drawKey(tilePos, &entry.key)) {
+        drawList_.push_back(entry);
+    }
+}
+
+/**
+ * Sorts the list of objects by tile with a radix sort on the key, one byte
+ * at a time. The sort is stable so objects on a tile keep the order they
+ * were added in, then they are sorted from back to front.
+ */
+void MapRenderer::sortObjectsToDraw() {
+    size_t nbEntries = drawList_.size();
+    if (nbEntries < 2) {
+        return;
+    }
+    sortBuffer_.resize(nbEntries);
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t count[257];
+        memset(count, 0, sizeof(count));
+        for (size_t i = 0; i < nbEntries; i++) {
+            count[((drawList_[i].key >> shift) & 0xFF) + 1]++;
+        }
+        if (count[((drawList_[0].key >> shift) & 0xFF) + 1] == nbEntries) {
+            // all keys have the same byte : nothing to sort
+            continue;
+        }
+        for (int b = 1; b < 257; b++) {
+            count[b] += count[b - 1];
+        }
+        for (size_t i = 0; i < nbEntries; i++) {
+            sortBuffer_[count[(drawList_[i].key >> shift) & 0xFF]++] = drawList_[i];
+        }
+        drawList_.swap(sortBuffer_);
+    }
+
+    size_t first = 0;
+    for (size_t i = 1; i <= nbEntries; i++) {
+        if (i == nbEntries || drawList_[i].key != drawList_[first].key) {
+            if (i - first > 1) {
+                sortObjectsOnTile(first, i);
             }
+            first = i;
         }
     }
 }
 
 /**
- * Objects that were listed for drawing may be bigger than objects really drawn.
- * So remove those objects from the list.
- * \return void
- *
+ * Sorts objects on the same tile so that objects in the back are drawn
+ * first. Each object is put before the first object it is behind, in the
+ * order they were added.
+ * \param first Index of the first object of the tile
+ * \param last Index after the last object of the tile
  */
-void MapRenderer::freeUnreleasedResources() {
-    int nbFreed = 0;
-    std::map<int, ObjectToDraw *>::iterator itr = objectsByTile_.begin();
-    while (itr != objectsByTile_.end()) {
-        std::map<int, ObjectToDraw *>::iterator toErase = itr;
-        ++itr;
-        ObjectToDraw *pObj = toErase->second;
-        while(pObj != NULL) {
-            ObjectToDraw *pNext = pObj->getNext();
-            pool_.releaseResource(pObj);
-            nbFreed++;
-            pObj = pNext;
+void MapRenderer::sortObjectsOnTile(size_t first, size_t last) {
+    for (size_t k = first + 1; k < last; k++) {
+        DrawEntry entry = drawList_[k];
+        size_t pos = first;
+        while (pos < k && !entry.pObject->isBehindObjectOnSameTile(drawList_[pos].pObject)) {
+            pos++;
+        }
+        for (size_t i = k; i > pos; i--) {
+            drawList_[i] = drawList_[i - 1];
         }
-        objectsByTile_.erase(toErase);
+        drawList_[pos] = entry;
     }
 }
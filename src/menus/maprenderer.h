@@ -28,14 +28,13 @@
 #ifndef MENUS_MAPRENDERER_H_
 #define MENUS_MAPRENDERER_H_
 
-#include <list>
 #include <vector>
-#include <set>
-#include <map>
 
 #include "common.h"
 #include "utils/log.h"
 #include "model/position.h"
+#include "gfx/dirtylist.h"
+#include "menus/maplayercache.h"
 
 class Mission;
 class Map;
@@ -46,139 +45,113 @@ class WeaponInstance;
 class Static;
 class SFXObject;
 class SquadSelection;
-
-class PoolableResource {
-public:
-    PoolableResource() { free_ = true; }
-    virtual ~PoolableResource() {}
-
-    bool isFree() { return free_; }
-    void setFree(bool free) { free_ = free; }
-
-    virtual void handleRelease() {}
-
-private:
-    bool free_;
-};
-
-class ObjectToDraw : public PoolableResource {
-public:
-    ObjectToDraw() {
-        handleRelease();
-    }
-
-    void handleRelease() {
-        pObject_ = NULL;
-        pNext_ = NULL;
-    }
-
-    MapObject * getObject() { return pObject_; }
-    ObjectToDraw * getNext() { return pNext_; }
-
-    void setObject(MapObject *pObj) { pObject_ = pObj; }
-    void setNext(ObjectToDraw *pNext) {
-        pNext_ = pNext;
-    }
-    void insertNext(ObjectToDraw *pNext) {
-        pNext->setNext(pNext_);
-        pNext_ = pNext;
-    }
-
-
-private:
-    MapObject *pObject_;
-    ObjectToDraw *pNext_;
-};
-
-template<class T>
-class Pool {
-public:
-    Pool(int nbInitialRes) {
-        totalResourceCreated_ = 0;
-        for (int nbRes = 0; nbRes < nbInitialRes; nbRes++) {
-            pool_.push_back(new T());
-            totalResourceCreated_++;
-        }
-    }
-    ~Pool() {
-        for (typename std::list < T * >::iterator it = pool_.begin();
-         it != pool_.end(); it++) {
-             T * pRes = (*it);
-            delete pRes;
-            totalResourceCreated_--;
-        }
-
-        pool_.clear();
-
-        if (totalResourceCreated_ > 0) {
-            FSERR(Log::k_FLG_MEM, "Pool", "~Pool", ("There %d unfreed resource(s)", totalResourceCreated_));
-        }
-    };
-
-    T * getResource() {
-        T *pResource = NULL;
-
-        if (pool_.empty()) {
-            pResource = new T();
-            totalResourceCreated_++;
-        } else {
-            pResource = pool_.front();
-            pool_.pop_front();
-        }
-
-        pResource->setFree(false);
-        return pResource;
-    }
-
-    void releaseResource(T * pResource) {
-        if (!pResource->isFree()) {
-            pResource->handleRelease();
-            pool_.push_back(pResource);
-            pResource->setFree(true);
-        }
-    }
-
-private:
-    std::list<T *> pool_;
-    int totalResourceCreated_;
-};
+class Tile;
 
 class MapRenderer {
 public:
-    MapRenderer() : pool_(10) {}
+    MapRenderer() : drawCursor_(0), hasLastFrame_(false), mapVersion_(0) {}
 
     void init(Mission *pMission, SquadSelection *pSelection);
 
+    //! Draws the whole map area
     void render(const Point2D &worldPos);
+    //! Draws only what changed since the last frame
+    void renderChanges(const Point2D &worldPos);
+    //! Tells that something was drawn over the map after it was rendered
+    void invalidateArea(int x, int y, int width, int height);
+    //! The next frame does not reuse the pixels of the last one
+    void dropLastFrame() { hasLastFrame_ = false; }
 
 private:
-    /**
-     * Return a integer which is a hash for identifying easily
-     * a tile instead of use the 3 usual coordinates.
-     * \param tilePos
-     * \return int
+    /*!
+     * An object to draw with the key of the tile it is drawn with.
+     */
+    struct DrawEntry {
+        uint32 key;
+        MapObject *pObject;
+    };
+
+    /*!
+     * What an object looked like on screen.
      */
-    static int tileHashKey(const TilePoint & tilePos) {
-        return tilePos.tx | (tilePos.ty << 8) | (tilePos.tz << 16);
-    }
+    struct DrawnObject {
+        MapObject *pObject;
+        /*! Key of the tile it was drawn with.*/
+        uint32 key;
+        /*! Area drawn on screen.*/
+        int x, y, width, height;
+        /*! Identifies the sprites drawn (see Screen::measuredSignature()).*/
+        uint32 signature;
+
+        bool operator<(const DrawnObject &other) const {
+            return pObject < other.pObject;
+        }
+    };
 
-    //! Get the hashkey of the tile for the given object
-    static int tileHashKey(MapObject * m);
+    //! Returns the key giving the position of the tile in the drawing order
+    static bool drawKey(const TilePoint &tilePos, uint32 *pKey);
+    static void mergeRect(DirtyRect *pRect, const DirtyRect &other);
 
+    void drawArea(const Point2D &viewport, int x, int y, int width, int height);
+    void walkTiles(const Point2D &viewport, bool measuring);
+    void endFrame(const Point2D &viewport);
+    void measureObjects(const Point2D &viewport);
+    void findChangedAreas(int dx, int dy);
+    void addChangedArea(int x, int y, int width, int height);
     void listObjectsToDraw(const Point2D &viewport);
     bool isObjectInsideDrawingArea(MapObject *pObject, const Point2D &viewport);
-    int drawObjectsOnTile(const TilePoint & tilePos, const Point2D &screenPos);
+    int drawObjectsOnTile(const TilePoint & tilePos, const Point2D &screenPos,
+            bool measuring);
+    void clearCoverage();
+    void markCovered(int x, int y, int width, int height);
+    void drawTileInCoveredCells(Tile *pTile, int x, int y);
     void addObjectToDraw(MapObject *pObject);
-    void freeUnreleasedResources();
+    void sortObjectsToDraw();
+    void sortObjectsOnTile(size_t first, size_t last);
 
 private:
     Mission *pMission_;
     Map *pMap_;
     SquadSelection *pSelection_;
 
-    Pool<ObjectToDraw> pool_;
-    /*! This map contains for each tile the list of objects to draw.*/
-    std::map<int, ObjectToDraw *> objectsByTile_;
+    /*!
+     * Objects to draw during the current frame, sorted in the order
+     * of the tiles they are drawn with. The array is kept between frames
+     * to avoid allocations.
+     */
+    std::vector<DrawEntry> drawList_;
+    /*! Temporary array used by the radix sort.*/
+    std::vector<DrawEntry> sortBuffer_;
+    /*! Next entry of drawList_ to draw.*/
+    size_t drawCursor_;
+    /*! Objects of the current frame, sorted by address.*/
+    std::vector<DrawnObject> drawnObjects_;
+    /*! Objects of the last frame, sorted by address.*/
+    std::vector<DrawnObject> lastObjects_;
+    /*! True if lastObjects_ and lastViewport_ are set.*/
+    bool hasLastFrame_;
+    Point2D lastViewport_;
+    /*! Version of the map in the last frame.*/
+    uint32 mapVersion_;
+    /*! Maximum number of areas drawn separately by renderChanges().*/
+    static const size_t kMaxChangedAreas = 16;
+    /*! Areas of the screen to draw again.*/
+    std::vector<DirtyRect> changedAreas_;
+    /*! Areas of the map drawn over since the last frame.*/
+    std::vector<DirtyRect> overdrawnAreas_;
+    /*! Tiles without objects, drawn once and copied on each frame.*/
+    MapLayerCache layerCache_;
+    /*! Size in pixels of a cell of the coverage grid.*/
+    static const int kCoverCellSize = 16;
+    /*!
+     * Screen cells where an object has been drawn during the current
+     * frame : tiles drawn after it must be drawn again over it.
+     */
+    std::vector<bool> covered_;
+    /*! True if no cell is covered.*/
+    bool nothingCovered_;
+    /*! Area of the screen drawn by drawArea().*/
+    DirtyRect area_;
 };
 
 #endif  // MENUS_MAPRENDERER_H_
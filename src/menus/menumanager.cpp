@@ -28,6 +28,7 @@
 #include <assert.h>
 
 #include "menus/menumanager.h"
+#include "app.h"
 #include "appcontext.h"
 #include "system.h"
 #include "utils/configfile.h"
@@ -68,67 +69,50 @@ MenuManager::~MenuManager()
  * \param loadIntroFont If true loads the intro sprites and font
  */
 bool MenuManager::initialize(bool loadIntroFont) {
-    bool res = false;
-    int size = 0, tabSize = 0;
-    uint8 *data, *tabData;
-
-    // Loads menu sprites
-    LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("Loading menu sprites ..."))
-    tabData = File::loadOriginalFile("mspr-0.tab", tabSize);
-    if (!tabData) {
-        FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mspr-0.tab"));
+    if (!loadMenuSprites()) {
         return false;
     }
-    data = File::loadOriginalFile("mspr-0.dat", size);
-    if (!data) {
-        FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mspr-0.dat"));
-        delete[] tabData;
+
+    // loads intro sprites
+    if (loadIntroFont && !loadIntroFontSprites()) {
         return false;
     }
 
-    res = menuSprites_.loadSprites(tabData, tabSize, data, true);
-    delete[] tabData;
-    delete[] data;
-    if (res) {
-        LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("%d sprites loaded", tabSize / 6))
-    } else {
-        FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed loading menu sprites"));
+    return loadFonts();
+}
+
+/*!
+ * Loading methods don't use the screen : they can be called by another
+ * thread than the main one as long as menus are not used.
+ */
+bool MenuManager::loadMenuSprites() {
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadMenuSprites", ("Loading menu sprites ..."))
+    if (!menuSprites_.loadSprites("mspr-0.tab", "mspr-0.dat", true)) {
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadMenuSprites", ("Failed loading menu sprites"));
         return false;
     }
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadMenuSprites", ("%d sprites loaded", menuSprites_.spriteCount()))
+    return true;
+}
 
-    // loads intro sprites
-    if (loadIntroFont) {
-        LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("Loading intro sprites ..."))
-
-        tabData = File::loadOriginalFile("mfnt-0.tab", tabSize);
-        if (!tabData) {
-            FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mfnt-0.tab"));
-            return false;
-        }
-        data = File::loadOriginalFile("mfnt-0.dat", size);
-        if (!data) {
-            FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mfnt-0.dat"));
-            delete[] tabData;
-            return false;
-        }
+bool MenuManager::loadIntroFontSprites() {
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadIntroFontSprites", ("Loading intro sprites ..."))
 
-        pIntroFontSprites_ = new SpriteManager();
-        res = pIntroFontSprites_->loadSprites(tabData, tabSize, data, true);
-        delete[] tabData;
-        delete[] data;
-        if (res) {
-            LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("%d sprites loaded", tabSize / 6))
-        } else {
-            FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed loading intro sprites"));
-            return false;
-        }
+    pIntroFontSprites_ = new SpriteManager();
+    if (!pIntroFontSprites_->loadSprites("mfnt-0.tab", "mfnt-0.dat", true)) {
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadIntroFontSprites", ("Failed loading intro sprites"));
+        return false;
     }
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadIntroFontSprites", ("%d sprites loaded", pIntroFontSprites_->spriteCount()))
+    return true;
+}
 
-    // Loads fonts
-    LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("Loading fonts ..."))
-    res = fonts_.loadFonts(&menuSprites_, pIntroFontSprites_);
-
-    return res;
+/*!
+ * Menu sprites and intro sprites, if any, must be loaded.
+ */
+bool MenuManager::loadFonts() {
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadFonts", ("Loading fonts ..."))
+    return fonts_.loadFonts(&menuSprites_, pIntroFontSprites_);
 }
 
 /*!
@@ -298,6 +282,7 @@ void MenuManager::leaveMenu(Menu *pMenu) {
         int size;
         data = File::loadOriginalFile(pMenu->getLeaveAnimName(), size);
         fliPlayer.loadFliData(data);
+        g_App.waitForAssets(fs_game_assets::kAssetGameSounds);
         pGameSounds_->play(snd::MENU_CHANGE);
         fliPlayer.play();
         delete[] data;
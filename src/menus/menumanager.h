@@ -61,6 +61,12 @@ public:
     ~MenuManager();
 
     bool initialize(bool loadIntroFont);
+    //! Loads the menu sprites
+    bool loadMenuSprites();
+    //! Loads the sprites of the intro font
+    bool loadIntroFontSprites();
+    //! Creates the fonts from the sprites
+    bool loadFonts();
 
     //! Destroy all menus and resources
     void destroy();
@@ -30,6 +30,7 @@
 #include <assert.h>
 
 #include "selectmenu.h"
+#include "app.h"
 #include "menus/menumanager.h"
 #include "menus/gamemenuid.h"
 #include "core/gamecontroller.h"
@@ -355,6 +356,8 @@ void SelectMenu::drawSelectedModInfos(int x, int y)
 }
 
 void SelectMenu::handleShow() {
+    // agents are drawn with the game sprites
+    g_App.waitForAssets(fs_game_assets::kAssetGameSprites);
 
     menu_manager_->saveBackground();
 
@@ -350,7 +350,7 @@ bool SquadSelection::isTargetInRange(Mission *pMission, ShootableMapObject *pTar
             WeaponInstance *pWeapon = (*it)->selectedWeapon();
 
             uint8 blockRes = pMission->checkIfBlockersInShootingLine(
-                shooterPosW, &pTarget, NULL, false, false, pWeapon->range(), NULL, (*it));
+                shooterPosW, &pTarget, NULL, false, false, pWeapon->range(), NULL, (*it), true);
 
             if (blockRes == 1) {
                 return true;
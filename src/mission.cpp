@@ -29,12 +29,19 @@
 #include <string.h>
 #include <assert.h>
 #include <string>
+#include <algorithm>
 
 #include "mission.h"
 #include "gfx/screen.h"
 #include "app.h"
+#include "pathfinder.h"
+#include "pathrequests.h"
+#include "pathsectors.h"
+#include "objectgrid.h"
+#include "visibilitycache.h"
 #include "model/objectivedesc.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 #include "model/vehicle.h"
 #include "model/squad.h"
 #include "model/shot.h"
@@ -61,13 +68,18 @@ void MissionStats::init(int nbAgents) {
     nbOfHits_ = 0;
 }
 
-Mission::Mission(const LevelData::MapInfos & map_infos)
+/*!
+ * \param map_infos Map of the mission
+ * \param surfacesOnly True for a mission used only to compute surfaces
+ * and sectors : path search threads, object grid and visibility cache
+ * are not created.
+ */
+Mission::Mission(const LevelData::MapInfos & map_infos, bool surfacesOnly)
 {
     status_ = kMissionStatusRunning;
 
     mtsurfaces_ = NULL;
     mdpoints_ = NULL;
-    mdpoints_cp_ = NULL;
     i_map_id_ = READ_LE_UINT16(map_infos.map);
     p_map_ = NULL;
     min_x_= READ_LE_UINT16(map_infos.min_x) / 2;
@@ -77,10 +89,27 @@ Mission::Mission(const LevelData::MapInfos & map_infos)
     cur_objective_ = 0;
     p_minimap_ = NULL;
     p_squad_ = new Squad();
+    p_path_cache_ = new PathCache();
+    p_path_sectors_ = new PathSectors();
+    surfaces_version_ = 0;
+    grid_dirty_ = true;
+    grid_moved_ = false;
+    if (surfacesOnly) {
+        p_path_requests_ = NULL;
+        p_object_grid_ = NULL;
+        p_visibility_cache_ = NULL;
+    } else {
+        p_path_requests_ = new PathRequestQueue(this, g_Ctx.pathFinderAlgorithm(),
+            g_Ctx.pathThreads());
+        p_object_grid_ = new ObjectGrid();
+        p_visibility_cache_ = new VisibilityCache();
+    }
 }
 
 Mission::~Mission()
 {
+    // stop path searches before anything they read is destroyed
+    delete p_path_requests_;
     for (unsigned int i = 0; i < vehicles_.size(); i++)
         delete vehicles_[i];
     for (unsigned int i = 0; i < peds_.size(); i++)
@@ -106,6 +135,16 @@ Mission::~Mission()
     if (p_squad_) {
         delete p_squad_;
     }
+
+    delete p_path_cache_;
+    delete p_path_sectors_;
+    delete p_object_grid_;
+
+    if (p_visibility_cache_) {
+        LOG(Log::k_FLG_GAME, "Mission", "~Mission", ("Visibility cache : %u hits, %u misses",
+            p_visibility_cache_->hits(), p_visibility_cache_->misses()))
+        delete p_visibility_cache_;
+    }
 }
 
 void Mission::delPrjShot(size_t i) {
@@ -113,6 +152,80 @@ void Mission::delPrjShot(size_t i) {
     prj_shots_.erase((prj_shots_.begin() + i));
 }
 
+/*!
+ * The grid is rebuilt when objects were added or removed, else it is
+ * updated once per simulation step, when first used.
+ */
+ObjectGrid *Mission::objectGrid() {
+    if (grid_dirty_) {
+        p_object_grid_->build(this);
+        grid_dirty_ = false;
+        grid_moved_ = false;
+    } else if (grid_moved_) {
+        p_object_grid_->update(this);
+        grid_moved_ = false;
+    }
+    return p_object_grid_;
+}
+
+/*!
+ * Animates all objects of the mission for one simulation step.
+ * Dead sfx objects and projectiles are removed.
+ * \param elapsed Time elapsed since last step
+ * \return True if an object changed and the map needs to be redrawn
+ */
+bool Mission::animateObjects(int elapsed) {
+    bool change = false;
+    p_path_requests_->nextTick();
+    grid_moved_ = true;
+
+    {
+        ProfileScope scope(Profiler::kSectionStatics);
+        for (size_t i = 0; i < sfx_objects_.size(); i++) {
+            SFXObject *pSfx = sfx_objects_[i];
+            change |= pSfx->animate(elapsed);
+            if (pSfx->sfxLifeOver()) {
+                delSfxObject(i);
+                i--;
+            }
+        }
+    }
+
+    {
+        ProfileScope scope(Profiler::kSectionPeds);
+        for (size_t i = 0; i < peds_.size(); i++)
+            change |= peds_[i]->animate(elapsed, this);
+    }
+
+    {
+        ProfileScope scope(Profiler::kSectionVehicles);
+        for (size_t i = 0; i < vehicles_.size(); i++)
+            change |= vehicles_[i]->animate(elapsed);
+    }
+
+    {
+        ProfileScope scope(Profiler::kSectionStatics);
+        for (size_t i = 0; i < weaponsOnGround_.size(); i++)
+            change |= weaponsOnGround_[i]->animate(elapsed);
+
+        for (size_t i = 0; i < statics_.size(); i++)
+            change |= statics_[i]->animate(elapsed, this);
+    }
+
+    {
+        ProfileScope scope(Profiler::kSectionShots);
+        for (size_t i = 0; i < prj_shots_.size(); i++) {
+            change |= prj_shots_[i]->animate(elapsed, this);
+            if (prj_shots_[i]->isLifeOver()) {
+                delPrjShot(i);
+                i--;
+            }
+        }
+    }
+
+    return change;
+}
+
 /*!
  * Removes given ped from the list of armed peds.
  * \param pPed The ped to remove
@@ -360,12 +473,14 @@ void Mission::addWeaponToGround(WeaponInstance * w)
             return;
     }
     weaponsOnGround_.push_back(w);
+    grid_dirty_ = true;
 }
 
 void Mission::removeWeaponOnGround(WeaponInstance *pWeapon) {
     for (unsigned int i = 0; i < weaponsOnGround_.size(); i++) {
         if (weaponsOnGround_[i] == pWeapon) {
             weaponsOnGround_.erase(weaponsOnGround_.begin() + i);
+            grid_dirty_ = true;
         }
     }
 }
@@ -428,7 +543,37 @@ bool Mission::isStairs(char thisTile) {
     return thisTile > 0x00 && thisTile < 0x05;
 }
 
+/*!
+ * Computes walkable surfaces from the position of the peds.
+ */
 bool Mission::setSurfaces() {
+    std::vector<TilePoint> seeds;
+    getSurfaceSeeds(seeds);
+    return setSurfaces(seeds);
+}
+
+/*!
+ * Returns the tiles of the peds from which surfaces are flooded.
+ * Peds outside the map are put on its top level.
+ * \param seeds Tiles of living peds in the map
+ */
+void Mission::getSurfaceSeeds(std::vector<TilePoint> &seeds) {
+    for (unsigned int i = 0; i < peds_.size(); ++i) {
+        PedInstance *p = peds_[i];
+        int z = p->tileZ();
+        if (z >= mmax_z_ || z < 0 || p->isDead()) {
+            // TODO : check on all maps those peds correct position
+            p->setTileZ(mmax_z_ - 1);
+            continue;
+        }
+        seeds.push_back(TilePoint(p->tileX(), p->tileY(), z));
+    }
+}
+
+/*!
+ * \param seeds Tiles from which walkable surfaces are flooded
+ */
+bool Mission::setSurfaces(const std::vector<TilePoint> &seeds) {
 
     // Description: creates map of walkable surfaces, also
     // defines directions where movement is possible
@@ -444,8 +589,7 @@ bool Mission::setSurfaces() {
     int mmax_m_all = mmax_x_ * mmax_y_ * mmax_z_;
     mtsurfaces_ = (uint8 *)malloc(mmax_m_all * sizeof(uint8));
     mdpoints_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
-    mdpoints_cp_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
-    if(mtsurfaces_ == NULL || mdpoints_ == NULL || mdpoints_cp_ == NULL) {
+    if(mtsurfaces_ == NULL || mdpoints_ == NULL) {
         clrSurfaces();
         FSERR(Log::k_FLG_GAME, "Mission", "setSurfaces", ("Memory allocation error\n"));
         return false;
@@ -489,16 +633,10 @@ bool Mission::setSurfaces() {
     //printf("surface data size %i\n", sizeof(surfaceDesc) * mmax_m_all);
     //printf("flood data size %i\n", sizeof(floodPointDesc) * mmax_m_all);
 
-    for (unsigned int i = 0; i < peds_.size(); ++i) {
-        PedInstance *p = peds_[i];
-        int x = p->tileX();
-        int y = p->tileY();
-        int z = p->tileZ();
-        if (z >= mmax_z_ || z < 0 || p->isDead()) {
-            // TODO : check on all maps those peds correct position
-            p->setTileZ(mmax_z_ - 1);
-            continue;
-        }
+    for (unsigned int i = 0; i < seeds.size(); ++i) {
+        int x = seeds[i].tx;
+        int y = seeds[i].ty;
+        int z = seeds[i].tz;
         if (mdpoints_[x + y * mmax_x_ + z * mmax_m_xy].bfNodeDesc == m_fdNotDefined) {
             WorldPoint stodef;
             std::vector<WorldPoint> vtodefine;
@@ -2215,9 +2353,41 @@ bool Mission::setSurfaces() {
 
     printf("flood walkables %i\n", cw);
 #endif
+    p_path_sectors_->build(this);
+    invalidatePaths();
     return true;
 }
 
+/*!
+ * Finds a path on the calling thread.
+ * Tiles in different connected components are rejected at once.
+ * Requests toward a destination that was recently requested are answered
+ * by the path cache, others by the path finder.
+ * \param start Starting tile
+ * \param dest Destination tile
+ * \param path Tiles to go through, start excluded and destination included
+ * \return True if a path was found
+ */
+bool Mission::findPath(const TilePoint &start, const TilePoint &dest,
+        std::vector<TilePoint> &path) {
+    return p_path_requests_->findPath(start, dest, path);
+}
+
+/*!
+ * Takes the surfaces and sectors computed by another mission on the
+ * same map, which keeps the previous ones of this mission.
+ * \param pOther Mission whose setSurfaces() was called
+ */
+void Mission::takeSurfaces(Mission *pOther) {
+    assert(pOther->mmax_x_ == mmax_x_ && pOther->mmax_y_ == mmax_y_
+        && pOther->mmax_z_ == mmax_z_);
+    std::swap(mtsurfaces_, pOther->mtsurfaces_);
+    std::swap(mdpoints_, pOther->mdpoints_);
+    std::swap(p_path_sectors_, pOther->p_path_sectors_);
+    mmax_m_xy = pOther->mmax_m_xy;
+    invalidatePaths();
+}
+
 void Mission::clrSurfaces() {
 
     if(mtsurfaces_ != NULL) {
@@ -2228,10 +2398,6 @@ void Mission::clrSurfaces() {
         free(mdpoints_);
         mdpoints_ = NULL;
     }
-    if(mdpoints_cp_ != NULL) {
-        free(mdpoints_cp_);
-        mdpoints_cp_ = NULL;
-    }
 }
 
 /*!
@@ -2474,9 +2640,13 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
     WorldPoint blockEndPt;
     double closest = *dist;
     MapObject *pBlocker = NULL;
+    // only objects close to the line of fire are tested
+    ObjectGrid *pGrid = objectGrid();
+    std::vector<int> indexes;
 
-    for (unsigned int i = 0; i < statics_.size(); ++i) {
-        Static * s_blocker = statics_[i];
+    pGrid->findAlongSegment(ObjectGrid::kKindStatic, *pStartPt, *pEndPt, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        Static * s_blocker = statics_[indexes[n]];
         if (s_blocker->isExcludedFromBlockers())
             continue;
         if (s_blocker->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
@@ -2501,8 +2671,9 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
         const PedInstance *pPed = static_cast<const PedInstance *>(pOrigin);
         pShooterVehicle = pPed->inVehicle(); // can be null
     }
-    for (unsigned int i = 0; i < vehicles_.size(); ++i) {
-        Vehicle * pVehicle = vehicles_[i];
+    pGrid->findAlongSegment(ObjectGrid::kKindVehicle, *pStartPt, *pEndPt, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        Vehicle * pVehicle = vehicles_[indexes[n]];
         if (pVehicle != pShooterVehicle) {
             if (pVehicle->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
                 int cx = pStartPt->x - copyStartPt.x;
@@ -2521,8 +2692,9 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
         }
     }
 
-    for (unsigned int i = 0; i < peds_.size(); ++i) {
-        PedInstance * p_blocker = peds_[i];
+    pGrid->findAlongSegment(ObjectGrid::kKindPed, *pStartPt, *pEndPt, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        PedInstance * p_blocker = peds_[indexes[n]];
         if (p_blocker->isAlive() && p_blocker != pOrigin && p_blocker->inVehicle() == NULL) {
             if (p_blocker->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
                 int cx = pStartPt->x - copyStartPt.x;
@@ -2541,8 +2713,9 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
         }
     }
 
-    for (unsigned int i = 0; i < weaponsOnGround_.size(); ++i) {
-        WeaponInstance *pWeapon = weaponsOnGround_[i];
+    pGrid->findAlongSegment(ObjectGrid::kKindWeapon, *pStartPt, *pEndPt, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        WeaponInstance *pWeapon = weaponsOnGround_[indexes[n]];
         if (!pWeapon->hasOwner()) {
             if (pWeapon->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
                 int cx = pStartPt->x - copyStartPt.x;
@@ -2613,10 +2786,6 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
     if (distanceToTarget == 0)
         return block_mask;
 
-    double sx = (double) cx;
-    double sy = (double) cy;
-    double sz = (double) cz;
-
     if (distanceToTarget >= distanceMax) {
         // the distance we have to cross (distanceToTarget) is higher than the maximum
         // distance we are allowed to cross (distanceMax)
@@ -2634,86 +2803,109 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
         distanceToTarget = distanceMax;
     }
 
-    // NOTE: these values are less then 1.
-    // If they are incremented, time required to check range will be shorter but less precise check,
-    // If decremented longer but more precise.
-    // Increment is (n * 8)
-    double incrX = ((tmpTargetWLoc.x - cx) * 8) / distanceToTarget;
-    double incrY = ((tmpTargetWLoc.y - cy) * 8) / distanceToTarget;
-    double incrZ = ((tmpTargetWLoc.z - cz) * 8) / distanceToTarget;
-
-    int oldx = cx / 256;
-    int oldy = cy / 256;
-    int oldz = cz / 128;
-    double dist_close = distanceToTarget;
-    // look note before, should be same increment
-    double dist_dec = 1.0 * 8;
-
-    while (dist_close > dist_dec) {
-        int nx = (int)sx / 256;
-        int ny = (int)sy / 256;
-        int nz = (int)sz / 128;
-        unsigned char twd = mtsurfaces_[nx + ny * mmax_x_
-            + nz * mmax_m_xy];
-        if (oldx != nx || oldy != ny || oldz != nz
-            || (twd >= 0x01 && twd <= 0x04))
-        {
-            if (!(twd == 0x00 || twd == 0x0C || twd == 0x10)) {
-                bool is_blocked = false;
-                int offz = (int)sz % 128;
-                switch (twd) {
-                    case 0x01:
-                        if (offz <= (127 - (((int)sy % 256) >> 1)))
-                            is_blocked = true;
-                        break;
-                    case 0x02:
-                        if (offz <= (((int)sy % 256) >> 1))
-                            is_blocked = true;
-                        break;
-                    case 0x03:
-                        if (offz <= (((int)sx % 256) >> 1))
-                            is_blocked = true;
-                        break;
-                    case 0x04:
-                        if (offz <= (127 - (((int)sx % 256) >> 1)))
-                            is_blocked = true;
-                        break;
-                    default:
-                        is_blocked = true;
-                }
-                if (is_blocked) {
-                    sx -= incrX;
-                    sy -= incrY;
-                    sz -= incrZ;
-                    double dsx = sx - (double)cx;
-                    double dsy = sy - (double)cy;
-                    double dsz = sz - (double)cz;
-                    tmpTargetWLoc.x = (int)sx;
-                    tmpTargetWLoc.y = (int)sy;
-                    tmpTargetWLoc.z = (int)sz;
-                    dist_close = sqrt(dsx * dsx + dsy * dsy + dsz * dsz);
-                    // set mask to indicate path is blocked by a tile
-                    if (block_mask == 1)
-                        block_mask = 16;
-                    else
-                        block_mask |= 16;
-                    if (updateLoc) {
-                        pTargetPosW->x = (int)sx;
-                        pTargetPosW->y = (int)sy;
-                        pTargetPosW->z = (int)sz;
-                    }
-                    break;
-                }
+    // Tiles crossed by the line are visited in order, once each (voxel
+    // traversal by Amanatides and Woo). A point of the line is origin + t * d
+    // with t in [0, 1] and t is kept as a fraction num / den so that
+    // computations are exact.
+    const int tileSize[3] = {256, 256, 128};
+    const int tileMax[3] = {mmax_x_, mmax_y_, mmax_z_};
+    int origin[3] = {cx, cy, cz};
+    int64 d[3] = {tmpTargetWLoc.x - cx, tmpTargetWLoc.y - cy, tmpTargetWLoc.z - cz};
+    int64 absD[3];
+    // distance from origin to the next tile border on each axis
+    int64 next[3];
+    int step[3];
+    int tile[3];
+
+    for (int a = 0; a < 3; a++) {
+        tile[a] = origin[a] / tileSize[a];
+        absD[a] = d[a] < 0 ? -d[a] : d[a];
+        if (d[a] > 0) {
+            step[a] = 1;
+            next[a] = (int64) (tile[a] + 1) * tileSize[a] - origin[a];
+        } else if (d[a] < 0) {
+            step[a] = -1;
+            next[a] = origin[a] - (int64) tile[a] * tileSize[a];
+        } else {
+            step[a] = 0;
+            next[a] = 0;
+        }
+    }
+
+    int64 enterNum = 0, enterDen = 1;
+    bool originTile = true;
+    while (tile[0] >= 0 && tile[0] < tileMax[0] && tile[1] >= 0 && tile[1] < tileMax[1]
+        && tile[2] >= 0 && tile[2] < tileMax[2]) {
+        // find where the line leaves the tile : first border crossed or target
+        int axis = -1;
+        int64 exitNum = 1, exitDen = 1;
+        for (int a = 0; a < 3; a++) {
+            if (step[a] != 0 && next[a] * exitDen < exitNum * absD[a]) {
+                axis = a;
+                exitNum = next[a];
+                exitDen = absD[a];
             }
-            oldx = nx;
-            oldy = ny;
-            oldz = nz;
         }
-        sx += incrX;
-        sy += incrY;
-        sz += incrZ;
-        dist_close -= dist_dec;
-    } // end while
+
+        unsigned char twd = mtsurfaces_[tile[0] + tile[1] * mmax_x_
+            + tile[2] * mmax_m_xy];
+        bool is_blocked = false;
+        int64 hitNum = enterNum, hitDen = enterDen;
+        if (twd >= 0x01 && twd <= 0x04) {
+            // Stairs : the solid part is below a plane, whose equation is
+            // f = 2 * offz + k * offx|offy + c <= 0, and f is linear in t
+            int axisOff = (twd == 0x01 || twd == 0x02) ? 1 : 0;
+            int k = (twd == 0x01 || twd == 0x04) ? 1 : -1;
+            int64 c = (twd == 0x01 || twd == 0x04) ? -254 : 0;
+            int64 f0 = 2 * (origin[2] - tile[2] * 128)
+                + k * (origin[axisOff] - tile[axisOff] * 256) + c;
+            int64 fd = 2 * d[2] + k * d[axisOff];
+            if (f0 * enterDen + fd * enterNum <= 0) {
+                is_blocked = true;
+            } else if (f0 * exitDen + fd * exitNum <= 0) {
+                // line goes under the plane inside the tile
+                is_blocked = true;
+                hitNum = f0;
+                hitDen = -fd;
+            }
+        } else if (!originTile && !(twd == 0x00 || twd == 0x0C || twd == 0x10)) {
+            is_blocked = true;
+        }
+
+        if (is_blocked) {
+            // stop a little before the blocker so the point is outside of it
+            int64 len = (int64) distanceToTarget;
+            if (len < 1) {
+                len = 1;
+            }
+            int64 num = hitNum * len - 8 * hitDen;
+            int64 den = hitDen * len;
+            if (num < 0) {
+                num = 0;
+            }
+            // set mask to indicate path is blocked by a tile
+            if (block_mask == 1)
+                block_mask = 16;
+            else
+                block_mask |= 16;
+            if (updateLoc) {
+                pTargetPosW->x = cx + (int) (d[0] * num / den);
+                pTargetPosW->y = cy + (int) (d[1] * num / den);
+                pTargetPosW->z = cz + (int) (d[2] * num / den);
+            }
+            break;
+        }
+
+        if (axis == -1) {
+            // target is in this tile
+            break;
+        }
+        tile[axis] += step[axis];
+        next[axis] += tileSize[axis];
+        enterNum = exitNum;
+        enterDen = exitDen;
+        originTile = false;
+    }
 
     return block_mask;
 }
@@ -2739,7 +2931,7 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
 */
 uint8 Mission::checkIfBlockersInShootingLine(const WorldPoint & originLoc, ShootableMapObject ** pTarget,
     WorldPoint *pTargetPosW, bool setBlocker, bool checkTileOnly, double maxr,
-    double * distTo, const ShootableMapObject *pOrigin)
+    double * distTo, const ShootableMapObject *pOrigin, bool useVisibilityCache)
 {
     // search for a tile blocking the path towards the target
     // tmp will hold the updated position after that search
@@ -2750,7 +2942,12 @@ uint8 Mission::checkIfBlockersInShootingLine(const WorldPoint & originLoc, Shoot
         tmpPosW = *pTargetPosW;
     }
 
-    uint8 bfBlockerFound = checkBlockedByTile(originLoc, &tmpPosW, true, maxr, distTo);
+    uint8 bfBlockerFound;
+    if (useVisibilityCache) {
+        bfBlockerFound = p_visibility_cache_->checkBlockedByTile(this, originLoc, &tmpPosW, maxr, distTo);
+    } else {
+        bfBlockerFound = checkBlockedByTile(originLoc, &tmpPosW, true, maxr, distTo);
+    }
     if (bfBlockerFound == kBMaskBlockerTargetOutOfMap) {
         // coords are out of map limits
         return bfBlockerFound;
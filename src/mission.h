@@ -45,6 +45,11 @@ class Squad;
 class ProjectileShot;
 class GaussGunShot;
 class Weapon;
+class PathCache;
+class PathRequestQueue;
+class PathSectors;
+class ObjectGrid;
+class VisibilityCache;
 
 /*!
  * A class that holds mission statistics.
@@ -131,7 +136,7 @@ public:
     static const uint8 kBMaskBlockerTargetObjectUpdated;
     static const uint8 kBMaskBlockerTargetPosUpdated;
 
-    Mission(const LevelData::MapInfos & map_infos);
+    Mission(const LevelData::MapInfos & map_infos, bool surfacesOnly = false);
     virtual ~Mission();
 
     //*************************************
@@ -192,11 +197,17 @@ public:
     //*************************************
     size_t numPeds() { return peds_.size(); }
     PedInstance *ped(size_t i) { return peds_[i]; }
-    void addPed(PedInstance *p) { peds_.push_back(p); }
+    void addPed(PedInstance *p) {
+        peds_.push_back(p);
+        grid_dirty_ = true;
+    }
 
     size_t numVehicles() { return vehicles_.size(); }
     Vehicle *vehicle(size_t i) { return vehicles_[i]; }
-    void addVehicle(Vehicle *pVehicle) { vehicles_.push_back(pVehicle); }
+    void addVehicle(Vehicle *pVehicle) {
+        vehicles_.push_back(pVehicle);
+        grid_dirty_ = true;
+    }
 
     size_t numWeaponsOnGround() { return weaponsOnGround_.size(); }
     WeaponInstance *weaponOnGround(size_t i) { return weaponsOnGround_[i]; }
@@ -205,13 +216,17 @@ public:
 
     size_t numStatics() { return statics_.size(); }
     Static *statics(size_t i) { return statics_[i]; }
-    void addStatic(Static *pStatic) { statics_.push_back(pStatic); }
+    void addStatic(Static *pStatic) {
+        statics_.push_back(pStatic);
+        grid_dirty_ = true;
+    }
 
     size_t numSfxObjects() { return sfx_objects_.size(); }
     SFXObject *sfxObjects(size_t i) { return sfx_objects_[i]; }
 
     void addSfxObject(SFXObject *so) {
         sfx_objects_.push_back(so);
+        grid_dirty_ = true;
     }
     /*!
      * Removes SfxObject at given position in the list of sfxobjects.
@@ -224,6 +239,7 @@ public:
             delete sfx_objects_[i];
         }
         sfx_objects_.erase((sfx_objects_.begin() + i));
+        grid_dirty_ = true;
     }
 
     /*!
@@ -249,6 +265,9 @@ public:
      */
     void delPrjShot(size_t i);
 
+    //! Animates all mission objects
+    bool animateObjects(int elapsed);
+
     /*!
      * Adds the given PedInstance to the list of armed peds.
      * \param pPed The ped to add
@@ -272,6 +291,9 @@ public:
      */
     void removeArmedPed(PedInstance *pPed);
 
+    //! Returns the spatial index of map objects, rebuilt if needed
+    ObjectGrid *objectGrid();
+
     MapObject * findObjectWithNatureAtPos(int tilex, int tiley, int tilez,
         MapObject::ObjectNature *nature, int *searchIndex, bool only);
 
@@ -279,7 +301,26 @@ public:
     MissionStats *stats() { return &stats_; }
 
     bool setSurfaces();
+    //! Computes walkable surfaces flooded from the given tiles
+    bool setSurfaces(const std::vector<TilePoint> &seeds);
+    //! Returns the tiles from which setSurfaces() floods surfaces
+    void getSurfaceSeeds(std::vector<TilePoint> &seeds);
+    //! Uses the surfaces computed by another mission
+    void takeSurfaces(Mission *pOther);
     void clrSurfaces();
+    //! Finds a path between two walkable tiles
+    bool findPath(const TilePoint &start, const TilePoint &dest,
+            std::vector<TilePoint> &path);
+    //! Returns the path cache of this mission
+    PathCache *pathCache() { return p_path_cache_; }
+    //! Returns the queue of asynchronous path requests
+    PathRequestQueue *pathRequests() { return p_path_requests_; }
+    //! Returns the sectors and regions of walkable surfaces
+    PathSectors *pathSectors() { return p_path_sectors_; }
+    //! Returns a number that changes each time walkable surfaces change
+    uint32 surfacesVersion() { return surfaces_version_; }
+    //! Must be called when mdpoints_ is modified
+    void invalidatePaths() { surfaces_version_++; }
     bool getWalkable(TilePoint &mtp);
     bool getWalkableClosestByZ(TilePoint &mtp);
     bool getShootableTile(TilePoint *pLocT);
@@ -296,7 +337,10 @@ public:
     //! Check if tile or object blocks the line between originLoc and pTarget
     uint8 checkIfBlockersInShootingLine(const WorldPoint & originLoc, ShootableMapObject **pTarget,
         WorldPoint *pTargetPosW = NULL, bool setBlocker = false,
-        bool checkTileOnly = false, double maxr = -1.0, double * distTo = NULL, const ShootableMapObject *pOrigin = NULL);
+        bool checkTileOnly = false, double maxr = -1.0, double * distTo = NULL, const ShootableMapObject *pOrigin = NULL,
+        bool useVisibilityCache = false);
+    //! Returns the cache of tile checks used for lines of sight
+    VisibilityCache *visibilityCache() { return p_visibility_cache_; }
     //! Returns the distance between a ped and a object if a path exists between the two
     uint8 getPathLengthBetween(PedInstance *pPed, ShootableMapObject* objectToReach, double distanceMax, double *length);
 
@@ -304,8 +348,6 @@ public:
     uint8 *mtsurfaces_;
     // map-directions points
     floodPointDesc *mdpoints_;
-    // for copy in pathfinding
-    floodPointDesc *mdpoints_cp_;
     // initialized in set_map, used for in-class calculations
     // map maximum x,y,z values
     int mmax_x_, mmax_y_, mmax_z_;
@@ -327,6 +369,22 @@ protected:
 
 protected:
 
+    /*! Path searches, run by worker threads.*/
+    PathRequestQueue *p_path_requests_;
+    /*! Paths toward recent destinations.*/
+    PathCache *p_path_cache_;
+    /*! Sectors, regions and connected components of walkable surfaces.*/
+    PathSectors *p_path_sectors_;
+    /*! Incremented each time walkable surfaces change.*/
+    uint32 surfaces_version_;
+    /*! Spatial index of map objects.*/
+    ObjectGrid *p_object_grid_;
+    /*! True when lists of objects changed since grid was built.*/
+    bool grid_dirty_;
+    /*! True when objects may have moved since grid was updated.*/
+    bool grid_moved_;
+    /*! Results of tile checks on lines of sight.*/
+    VisibilityCache *p_visibility_cache_;
     /*! List of all vehicles, cars and train.*/
     std::vector<Vehicle *> vehicles_;
     std::vector<PedInstance *> peds_;
@@ -38,6 +38,7 @@
 #include "model/squad.h"
 #include "mission.h"
 #include "pedmanager.h"
+#include "agentmanager.h"
 
 /*!
  * Offset in the game data from the start to find the scenario section.
@@ -68,6 +69,111 @@ private:
 
 MissionManager::MissionManager()
 {
+    p_preload_ = NULL;
+    p_preload_thread_ = NULL;
+}
+
+MissionManager::~MissionManager()
+{
+    cancelPreload();
+}
+
+MissionManager::Preload::~Preload()
+{
+    delete pMission;
+}
+
+/*!
+ * Returns true if both lists have the same tiles in the same order.
+ */
+static bool sameTiles(const std::vector<TilePoint> &a, const std::vector<TilePoint> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].tx != b[i].tx || a[i].ty != b[i].ty || a[i].tz != b[i].tz) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int MissionManager::preloadMain(void *pData) {
+    Preload *pPreload = static_cast<Preload *>(pData);
+    pPreload->surfacesOk = pPreload->pMission->setSurfaces(pPreload->seeds);
+    return 0;
+}
+
+/*!
+ * Surfaces are flooded from statics and peds : statics are created now
+ * and the tiles of peds are guessed from the current squad.
+ * \param n Mission id
+ * \param level_data Content of the mission file
+ * \param pMap Map of the mission, which must stay in the map cache
+ */
+void MissionManager::startPreload(int n, const LevelData::LevelDataAll &level_data, Map *pMap) {
+    if (!g_App.waitForAssets(fs_game_assets::kAssetGameSprites)) {
+        return;
+    }
+
+    Preload *pPreload = new Preload();
+    pPreload->missionId = n;
+    pPreload->level_data = level_data;
+    // only surfaces are computed : no path threads nor caches
+    pPreload->pMission = new Mission(level_data.mapinfos, true);
+    pPreload->pMission->set_map(pMap);
+    createStatics(level_data, pPreload->pMission);
+
+    // Same tiles as Mission::getSurfaceSeeds() once peds are created
+    int maxZ = pPreload->pMission->mmax_z_;
+    for (uint16 i = 0; i < 256; i++) {
+        const LevelData::People & pedref = level_data.people[i];
+        bool activeAgent = i < AgentManager::kMaxSlot
+            && g_gameCtrl.agents().isSquadSlotActive(i);
+        if (!PedManager::isCreated(pedref, i, activeAgent)
+            || pedref.state == LevelData::kPeopleStateDead) {
+            continue;
+        }
+        TilePoint pos = PedManager::startPosition(pedref);
+        if (pos.tz < maxZ && pos.tz >= 0) {
+            pPreload->seeds.push_back(pos);
+        }
+    }
+
+    p_preload_ = pPreload;
+    p_preload_thread_ = SDL_CreateThread(preloadMain, pPreload);
+    if (p_preload_thread_ == NULL) {
+        FSERR(Log::k_FLG_GAME, "MissionManager", "startPreload",
+            ("Cannot create preload thread : %s\n", SDL_GetError()));
+    }
+}
+
+/*!
+ * \param n Mission id
+ * \return The preloaded mission or NULL if another mission was preloaded
+ */
+MissionManager::Preload *MissionManager::takePreload(int n) {
+    if (p_preload_thread_ != NULL) {
+        SDL_WaitThread(p_preload_thread_, NULL);
+        p_preload_thread_ = NULL;
+    }
+    if (p_preload_ == NULL || p_preload_->missionId != n) {
+        cancelPreload();
+        return NULL;
+    }
+
+    Preload *pPreload = p_preload_;
+    p_preload_ = NULL;
+    return pPreload;
+}
+
+void MissionManager::cancelPreload() {
+    if (p_preload_thread_ != NULL) {
+        SDL_WaitThread(p_preload_thread_, NULL);
+        p_preload_thread_ = NULL;
+    }
+    delete p_preload_;
+    p_preload_ = NULL;
 }
 
 /*!
@@ -76,6 +182,9 @@ MissionManager::MissionManager()
  * \return NULL if mission could not be loaded
  */
 MissionBriefing *MissionManager::loadBriefing(int n) {
+    // The map of the previous preload may be dropped from the cache
+    cancelPreload();
+
     char tmp[100];
     // Briefing file depends on the current language
     switch(g_Ctx.currLanguage()) {
@@ -112,12 +221,14 @@ MissionBriefing *MissionManager::loadBriefing(int n) {
     LevelData::LevelDataAll level_data;
     if (load_level_data(n, level_data)) {
         uint16 map_id = READ_LE_UINT16(level_data.mapinfos.map);
+        g_App.waitForAssets(fs_game_assets::kAssetTiles);
         Map *p_map = g_App.maps().loadMap(map_id);
         if (p_map == NULL) {
             delete p_mb;
             return NULL;
         }
         p_mb->init_minimap(p_map, level_data);
+        startPreload(n, level_data, p_map);
     }
 
     return p_mb;
@@ -133,27 +244,41 @@ MissionBriefing *MissionManager::loadBriefing(int n) {
 Mission *MissionManager::loadMission(int n)
 {
     LOG(Log::k_FLG_IO, "MissionManager", "loadMission()", ("loading mission %i", n));
+    g_App.waitForAssets(fs_game_assets::kAssetGameSprites | fs_game_assets::kAssetTiles);
 
+    Preload *pPreload = takePreload(n);
     // Initialize LevelData structure from data read in file
     LevelData::LevelDataAll level_data;
-    if (load_level_data(n, level_data)) {
+    if (pPreload != NULL) {
+        level_data = pPreload->level_data;
+    } else if (!load_level_data(n, level_data)) {
+        return NULL;
+    }
 
-        Mission *m = create_mission(level_data);
+    Mission *m = create_mission(level_data);
 
-        if (m) {
-            Map *p_map = g_App.maps().loadMap(m->mapId());
-            if (p_map == NULL) {
-                delete m;
-                return NULL;
-            }
-            m->set_map(p_map);
-            m->setSurfaces();
+    if (m) {
+        Map *p_map = g_App.maps().loadMap(m->mapId());
+        if (p_map == NULL) {
+            delete m;
+            delete pPreload;
+            return NULL;
+        }
+        m->set_map(p_map);
+
+        std::vector<TilePoint> seeds;
+        m->getSurfaceSeeds(seeds);
+        if (pPreload != NULL && pPreload->surfacesOk
+            && sameTiles(seeds, pPreload->seeds)) {
+            LOG(Log::k_FLG_IO, "MissionManager", "loadMission()", ("using preloaded surfaces"));
+            m->takeSurfaces(pPreload->pMission);
+        } else {
+            m->setSurfaces(seeds);
         }
-
-        return m;
     }
 
-    return NULL;
+    delete pPreload;
+    return m;
 }
 
 /*!
@@ -336,15 +461,7 @@ Mission * MissionManager::create_mission(LevelData::LevelDataAll &level_data) {
 
         createPeds(level_data, di, p_mission);
 
-        for (uint16 i = 0; i < 400; i++) {
-            LevelData::Statics & sref = level_data.statics[i];
-            if(sref.desc == 0)
-                continue;
-            Static *s = Static::loadInstance((uint8 *) & sref, i, p_mission->mapId());
-            if (s) {
-                p_mission->addStatic(s);
-            }
-        }
+        createStatics(level_data, p_mission);
 
         createWeapons(level_data, di, p_mission);
 
@@ -390,6 +507,18 @@ Mission * MissionManager::create_mission(LevelData::LevelDataAll &level_data) {
     }
 }
 
+void MissionManager::createStatics(const LevelData::LevelDataAll &level_data, Mission *pMission) {
+    for (uint16 i = 0; i < 400; i++) {
+        const LevelData::Statics & sref = level_data.statics[i];
+        if(sref.desc == 0)
+            continue;
+        Static *s = Static::loadInstance((uint8 *) & sref, i, pMission->mapId());
+        if (s) {
+            pMission->addStatic(s);
+        }
+    }
+}
+
 void MissionManager::createWeapons(const LevelData::LevelDataAll &level_data, DataIndex &di, Mission *pMission) {
     for (uint16 i = 0; i < 512; i++) {
         const LevelData::Weapons & wref = level_data.weapons[i];
@@ -26,11 +26,16 @@
 #define MISSIONMANAGER_H
 
 #include <map>
+#include <vector>
+
+#include <SDL.h>
 
 #include "common.h"
 #include "model/leveldata.h"
+#include "model/position.h"
 #include "ia/actions.h"
 
+class Map;
 class Mission;
 class MissionBriefing;
 class WeaponInstance;
@@ -40,16 +45,47 @@ class PedInstance;
 /*!
  * Mission manager class.
  * Stores information about all missions.
+ * While the briefing of a mission is shown, the walkable surfaces of the
+ * mission are computed by a thread so that loading the mission is quick.
  */
 class MissionManager {
 public:
     MissionManager();
+    ~MissionManager();
     //! Loads mission for the given mission id
     Mission *loadMission(int n);
     //! Loads briefing for the given mission id
     MissionBriefing *loadBriefing(int n);
+    //! Waits for the mission being prepared and drops it
+    void cancelPreload();
 
 private:
+    /*!
+     * A mission prepared in background.
+     * Peds depend on the squad, which can change until the mission is
+     * loaded : surfaces are flooded from the expected tiles of peds and
+     * are used only if the loaded peds are on the same tiles.
+     */
+    struct Preload {
+        Preload() : pMission(NULL), surfacesOk(false) {}
+        ~Preload();
+
+        int missionId;
+        LevelData::LevelDataAll level_data;
+        /*! Mission with only statics, whose surfaces are computed.*/
+        Mission *pMission;
+        /*! Tiles from which surfaces are flooded.*/
+        std::vector<TilePoint> seeds;
+        /*! True if surfaces were computed.*/
+        bool surfacesOk;
+    };
+
+    //! Starts computing the surfaces of the mission in background
+    void startPreload(int n, const LevelData::LevelDataAll &level_data, Map *pMap);
+    //! Waits for the preload of the given mission and returns it
+    Preload *takePreload(int n);
+    static int preloadMain(void *pData);
+
     /*!
      * NOTE: Original objects data is based on offsets, but our objects are different
      * in size and are not in a single memory block.
@@ -95,9 +131,17 @@ private:
     //! Creates objectives
     void createObjectives(const LevelData::LevelDataAll &level_data,
                             DataIndex &di, Mission *pMission);
+    //! Creates all statics
+    void createStatics(const LevelData::LevelDataAll &level_data, Mission *pMission);
 
     //! Export data for debug (will be moved in editor)
     void exportMissionData(LevelData::LevelDataAll &level_data, Mission *pMission);
+
+private:
+    /*! Mission being prepared, NULL if none.*/
+    Preload *p_preload_;
+    /*! Thread computing the surfaces of the preloaded mission.*/
+    SDL_Thread *p_preload_thread_;
 };
 
 #endif
@@ -0,0 +1,176 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+/*
+ * Runs missions without any window, sound or player input.
+ * Each mission is loaded and animated with the same update order as the
+ * gameplay screen, as fast as possible, for a given amount of simulated
+ * time. The random generator is reseeded before each mission so that two
+ * runs with the same parameters give the same simulation.
+ */
+
+#include <memory>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "common.h"
+#include "app.h"
+#include "appcontext.h"
+#include "mission.h"
+#include "core/gamecontroller.h"
+#include "core/gamesession.h"
+#include "utils/log.h"
+
+#ifdef SYSTEM_SDL
+#ifdef _WIN32
+#undef main
+#else
+#include <SDL_main.h>           //This is required on OSX for remapping of main()
+#endif
+#endif
+
+void print_usage() {
+    printf("usage: missionrunner [options...]\n");
+    printf("    -h, --help            display this help and exit.\n");
+    printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
+    printf("    -m, --mission <num>   run only the given mission (block index from 0 to 49).\n");
+    printf("                          by default all missions are run.\n");
+    printf("    -t, --time <minutes>  simulated time for each mission (default: 5).\n");
+    printf("    -s, --seed <num>      seed for the random generator (default: 0).\n");
+}
+
+/*!
+ * Runs the mission in the given block for the given number of steps.
+ * \return False if mission could not be loaded.
+ */
+bool runMission(int blockId, int nbSteps, int step, unsigned int seed) {
+    // Start each mission with a fresh game so results don't depend
+    // on the previous missions
+    if (!g_App.reset()) {
+        return false;
+    }
+
+    int misId = g_Session.getBlock(blockId).mis_id;
+    srand(seed);
+
+    clock_t loadStart = clock();
+    Mission *pMission = g_gameCtrl.missions().loadMission(misId);
+    if (pMission == NULL) {
+        printf("mission %2d (block %2d) : failed to load\n", misId, blockId);
+        return false;
+    }
+    g_Session.setSelectedBlockId(blockId);
+    g_Session.setMission(pMission);
+    pMission->start();
+    double loadTime = (double) (clock() - loadStart) / CLOCKS_PER_SEC;
+
+    // Same update order as GameplayMenu::handleTick()
+    clock_t runStart = clock();
+    for (int i = 0; i < nbSteps; i++) {
+        if (!pMission->completed() && !pMission->failed()) {
+            pMission->stats()->incrMissionDuration(step);
+            pMission->checkObjectives();
+        }
+
+        pMission->animateObjects(step);
+    }
+    double runTime = (double) (clock() - runStart) / CLOCKS_PER_SEC;
+
+    printf("mission %2d (block %2d) : load %6.3fs, %d ticks in %7.3fs, %10.1f ticks/s, %4d peds, status %d\n",
+        misId, blockId, loadTime, nbSteps, runTime,
+        runTime > 0 ? nbSteps / runTime : 0.0,
+        (int) pMission->numPeds(), (int) pMission->getStatus());
+
+    // Destroys the mission
+    g_Session.setMission(NULL);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    std::string iniPath;
+    int blockId = -1;
+    int minutes = 5;
+    unsigned int seed = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-h", argv[i]) || 0 == strcmp("--help", argv[i])) {
+            print_usage();
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        if (0 == strcmp("-i", argv[i]) || 0 == strcmp("--ini", argv[i])) {
+            iniPath = argv[++i];
+        } else if (0 == strcmp("-m", argv[i]) || 0 == strcmp("--mission", argv[i])) {
+            blockId = atoi(argv[++i]);
+            if (blockId < 0 || blockId >= 50) {
+                print_usage();
+                return 1;
+            }
+        } else if (0 == strcmp("-t", argv[i]) || 0 == strcmp("--time", argv[i])) {
+            minutes = atoi(argv[++i]);
+        } else if (0 == strcmp("-s", argv[i]) || 0 == strcmp("--seed", argv[i])) {
+            seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (iniPath.size() == 0) {
+        iniPath.assign(App::defaultIniFolder());
+        iniPath.append("/freesynd.ini");
+    }
+
+    std::auto_ptr<App> app(new App(true));
+    if (!app->initializeHeadless(iniPath)) {
+        printf("Failed to initialize application with %s\n", iniPath.c_str());
+        return 1;
+    }
+
+    int step = g_Ctx.tickStep();
+    int nbSteps = minutes * 60 * 1000 / step;
+    printf("Running %d simulated minutes per mission (%d ticks of %d ms), seed %u\n",
+        minutes, nbSteps, step, seed);
+
+    int failures = 0;
+    int first = blockId == -1 ? 0 : blockId;
+    int last = blockId == -1 ? 49 : blockId;
+    clock_t start = clock();
+    for (int blk = first; blk <= last; blk++) {
+        if (!runMission(blk, nbSteps, step, seed)) {
+            failures++;
+        }
+    }
+    double total = (double) (clock() - start) / CLOCKS_PER_SEC;
+    int nbMissions = last - first + 1 - failures;
+    printf("%d missions run in %.3fs, %.1f ticks/s\n", nbMissions, total,
+        total > 0 ? (double) nbMissions * nbSteps / total : 0.0);
+
+    app->destroy();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -30,6 +30,7 @@
 #include "app.h"
 #include "model/shot.h"
 #include "mission.h"
+#include "objectgrid.h"
 #include "ped.h"
 #include "vehicle.h"
 
@@ -337,9 +338,13 @@ void Explosion::generateFlameWaves(Mission *pMission, WorldPoint *pOrigin, doubl
 void Explosion::getAllShootablesWithinRange(Mission *pMission,
                                        const WorldPoint &originLocW,
                                        std::vector<ShootableMapObject *> &objInRangeVec) {
+    ObjectGrid *pGrid = pMission->objectGrid();
+    std::vector<int> indexes;
+
     // Look at all peds alive, in range of explosion and not in a vehicle
-    for (size_t i = 0; i < pMission->numPeds(); ++i) {
-        PedInstance *p = pMission->ped(i);
+    pGrid->findInRange(ObjectGrid::kKindPed, originLocW, dmg_.range, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        PedInstance *p = pMission->ped(indexes[n]);
         if (p->isAlive() && p->isCloseTo(originLocW, dmg_.range) && p->inVehicle() == NULL) {
             WorldPoint pedPosW(p->position());
             if (pMission->checkBlockedByTile(originLocW, &pedPosW, false, dmg_.range) == 1) {
@@ -348,8 +353,9 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
         }
     }
 
-    for (size_t i = 0; i < pMission->numStatics(); ++i) {
-        Static *st = pMission->statics(i);
+    pGrid->findInRange(ObjectGrid::kKindStatic, originLocW, dmg_.range, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        Static *st = pMission->statics(indexes[n]);
         if (!st->isExcludedFromBlockers() && st->isAlive() && st->isCloseTo(originLocW, dmg_.range)) {
             WorldPoint staticPosW(st->position());
             if (pMission->checkBlockedByTile(originLocW, &staticPosW, false, dmg_.range) == 1) {
@@ -359,8 +365,9 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
     }
 
     // look at all vehicles
-    for (size_t i = 0; i < pMission->numVehicles(); ++i) {
-        ShootableMapObject *v = pMission->vehicle(i);
+    pGrid->findInRange(ObjectGrid::kKindVehicle, originLocW, dmg_.range, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        ShootableMapObject *v = pMission->vehicle(indexes[n]);
         if (v->isAlive() && v->isCloseTo(originLocW, dmg_.range)) {
             WorldPoint vehiclePosW(v->position());
             if (pMission->checkBlockedByTile(originLocW, &vehiclePosW, false, dmg_.range) == 1) {
@@ -370,8 +377,9 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
     }
 
     // look at all bombs on the ground except the weapon that generated the shot
-    for (size_t i = 0; i < pMission->numWeaponsOnGround(); ++i) {
-        WeaponInstance *w = pMission->weaponOnGround(i);
+    pGrid->findInRange(ObjectGrid::kKindWeapon, originLocW, dmg_.range, indexes);
+    for (size_t n = 0; n < indexes.size(); ++n) {
+        WeaponInstance *w = pMission->weaponOnGround(indexes[n]);
         if (w->isInstanceOf(Weapon::TimeBomb) && w != dmg_.pWeapon && !w->hasOwner() && w->isAlive()) {
             WorldPoint weaponPosW(w->position());
             if (pMission->checkBlockedByTile(originLocW, &weaponPosW, false, dmg_.range) == 1) {
@@ -684,7 +684,8 @@ bool GenericCar::findPathToNearestWalkableTile(Map *pMap, const TilePoint &start
 bool GenericCar::doMove(int elapsed, Mission *m)
 {
     bool updated = false;
-    int used_time = elapsed;
+    double used_time = elapsed + move_time_carry_;
+    move_time_carry_ = 0.0;
 
     while ((!dest_path_.empty()) && used_time != 0) {
         if (hold_on_.wayFree == 1) { // Must wait
@@ -735,19 +736,22 @@ bool GenericCar::doMove(int elapsed, Mission *m)
 
             // Updates the available time
             if (dx || dy) {
-                int prv_time = used_time;
+                double prv_time = used_time;
                 if (dx) {
-                    used_time -= (int)(((double) dx * 1000.0 * d)
-                        / (double)(diffx * speed_));
+                    used_time -= ((double) dx * 1000.0 * d)
+                        / (double)(diffx * speed_);
                 } else if (dy) {
-                    used_time -= (int)(((double) dy * 1000.0 * d)
-                        / (double)(diffy * speed_));
+                    used_time -= ((double) dy * 1000.0 * d)
+                        / (double)(diffy * speed_);
                 } else
                     used_time = 0;
                 if (used_time < 0 || prv_time == used_time)
                     used_time = 0;
-            } else
+            } else {
+                // not enough time to move, keep it for next tick
+                move_time_carry_ = used_time;
                 used_time = 0;
+            }
 
             // Moves vehicle
             addOffsetToPosition(dx, dy);
@@ -0,0 +1,266 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "objectgrid.h"
+#include "mission.h"
+#include "ped.h"
+#include "model/vehicle.h"
+
+ObjectGrid::ObjectGrid() {
+    nb_cells_x_ = 0;
+    nb_cells_y_ = 0;
+    mark_ = 0;
+}
+
+/*!
+ * Objects outside the map are put in the closest cell.
+ */
+int ObjectGrid::cellOf(int tileX, int tileY) {
+    int cx = tileX / kCellSize;
+    int cy = tileY / kCellSize;
+    if (cx < 0) {
+        cx = 0;
+    } else if (cx >= nb_cells_x_) {
+        cx = nb_cells_x_ - 1;
+    }
+    if (cy < 0) {
+        cy = 0;
+    } else if (cy >= nb_cells_y_) {
+        cy = nb_cells_y_ - 1;
+    }
+    return cx + cy * nb_cells_x_;
+}
+
+/*!
+ * Objects must be added in increasing index for each kind.
+ */
+void ObjectGrid::addObject(ObjectKind kind, int index, const TilePoint &pos) {
+    int cell = cellOf(pos.tx, pos.ty);
+    object_cells_[kind].push_back(cell);
+    objects_[kind * nb_cells_x_ * nb_cells_y_ + cell].push_back(index);
+}
+
+/*!
+ * The object is inserted at its place so the cell stays sorted.
+ */
+void ObjectGrid::moveObject(ObjectKind kind, int index, const TilePoint &pos) {
+    int cell = cellOf(pos.tx, pos.ty);
+    int oldCell = object_cells_[kind][index];
+    if (cell == oldCell) {
+        return;
+    }
+
+    int base = kind * nb_cells_x_ * nb_cells_y_;
+    std::vector<int> &from = objects_[base + oldCell];
+    from.erase(std::lower_bound(from.begin(), from.end(), index));
+    std::vector<int> &to = objects_[base + cell];
+    to.insert(std::lower_bound(to.begin(), to.end(), index), index);
+    object_cells_[kind][index] = cell;
+}
+
+/*!
+ * Objects are added in the order of the mission lists so each cell keeps
+ * its objects in increasing index. Cell lists keep their memory between
+ * builds.
+ * \param pMission The mission whose objects are indexed
+ */
+void ObjectGrid::build(Mission *pMission) {
+    nb_cells_x_ = (pMission->mmax_x_ + kCellSize - 1) / kCellSize;
+    nb_cells_y_ = (pMission->mmax_y_ + kCellSize - 1) / kCellSize;
+    if (nb_cells_x_ < 1) {
+        nb_cells_x_ = 1;
+    }
+    if (nb_cells_y_ < 1) {
+        nb_cells_y_ = 1;
+    }
+    int nbCells = nb_cells_x_ * nb_cells_y_;
+
+    objects_.resize(kNbKinds * nbCells);
+    for (size_t i = 0; i < objects_.size(); i++) {
+        objects_[i].clear();
+    }
+    for (int k = 0; k < kNbKinds; k++) {
+        object_cells_[k].clear();
+    }
+
+    for (size_t i = 0; i < pMission->numPeds(); i++) {
+        addObject(kKindPed, i, pMission->ped(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numVehicles(); i++) {
+        addObject(kKindVehicle, i, pMission->vehicle(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numStatics(); i++) {
+        addObject(kKindStatic, i, pMission->statics(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numWeaponsOnGround(); i++) {
+        addObject(kKindWeapon, i, pMission->weaponOnGround(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numSfxObjects(); i++) {
+        addObject(kKindSfx, i, pMission->sfxObjects(i)->position());
+    }
+
+    if (cell_marks_.size() != (size_t) nbCells) {
+        cell_marks_.assign(nbCells, 0);
+        mark_ = 0;
+    }
+}
+
+/*!
+ * Positions are read again rather than followed on each move : ped
+ * movement writes tiles directly in many places. Only the objects that
+ * crossed a cell border cost more than a comparison.
+ * Lists of the mission must not have changed since last build.
+ * \param pMission The mission whose objects are indexed
+ */
+void ObjectGrid::update(Mission *pMission) {
+    for (size_t i = 0; i < pMission->numPeds(); i++) {
+        moveObject(kKindPed, i, pMission->ped(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numVehicles(); i++) {
+        moveObject(kKindVehicle, i, pMission->vehicle(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numStatics(); i++) {
+        moveObject(kKindStatic, i, pMission->statics(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numWeaponsOnGround(); i++) {
+        moveObject(kKindWeapon, i, pMission->weaponOnGround(i)->position());
+    }
+    for (size_t i = 0; i < pMission->numSfxObjects(); i++) {
+        moveObject(kKindSfx, i, pMission->sfxObjects(i)->position());
+    }
+}
+
+void ObjectGrid::newQuery() {
+    cells_.clear();
+    mark_++;
+    if (mark_ == 0) {
+        // counter wrapped : old marks could be taken for new ones
+        std::fill(cell_marks_.begin(), cell_marks_.end(), 0);
+        mark_ = 1;
+    }
+}
+
+/*!
+ * Selects cells that cover the given tiles plus one cell around them.
+ */
+void ObjectGrid::markCells(int minTileX, int minTileY, int maxTileX, int maxTileY) {
+    int minX = (minTileX < 0 ? 0 : minTileX / kCellSize) - 1;
+    int minY = (minTileY < 0 ? 0 : minTileY / kCellSize) - 1;
+    int maxX = (maxTileX < 0 ? 0 : maxTileX / kCellSize) + 1;
+    int maxY = (maxTileY < 0 ? 0 : maxTileY / kCellSize) + 1;
+
+    if (minX < 0) {
+        minX = 0;
+    }
+    if (minY < 0) {
+        minY = 0;
+    }
+    if (maxX >= nb_cells_x_) {
+        maxX = nb_cells_x_ - 1;
+    }
+    if (maxY >= nb_cells_y_) {
+        maxY = nb_cells_y_ - 1;
+    }
+
+    for (int cy = minY; cy <= maxY; cy++) {
+        for (int cx = minX; cx <= maxX; cx++) {
+            int cell = cx + cy * nb_cells_x_;
+            if (cell_marks_[cell] != mark_) {
+                cell_marks_[cell] = mark_;
+                cells_.push_back(cell);
+            }
+        }
+    }
+}
+
+/*!
+ * Copies the objects of the selected cells in indexes and sorts them.
+ */
+void ObjectGrid::gather(ObjectKind kind, std::vector<int> &indexes) {
+    indexes.clear();
+    int base = kind * nb_cells_x_ * nb_cells_y_;
+    for (size_t i = 0; i < cells_.size(); i++) {
+        const std::vector<int> &objects = objects_[base + cells_[i]];
+        indexes.insert(indexes.end(), objects.begin(), objects.end());
+    }
+    std::sort(indexes.begin(), indexes.end());
+}
+
+/*!
+ * \param kind Kind of objects to look for
+ * \param center Center of the search
+ * \param range Distance in world coordinates
+ * \param indexes Indexes of objects in the mission list, at least all
+ * objects in range
+ */
+void ObjectGrid::findInRange(ObjectKind kind, const WorldPoint &center, int range,
+        std::vector<int> &indexes) {
+    if (range < 0) {
+        range = 0;
+    }
+    newQuery();
+    markCells((center.x - range) / 256, (center.y - range) / 256,
+        (center.x + range) / 256, (center.y + range) / 256);
+    gather(kind, indexes);
+}
+
+/*!
+ * The segment is sampled every half cell and cells around each sample
+ * are selected.
+ * \param kind Kind of objects to look for
+ * \param from First end of the segment
+ * \param to Second end of the segment
+ * \param indexes Indexes of objects in the mission list, at least all
+ * objects whose tile is crossed by the segment
+ */
+void ObjectGrid::findAlongSegment(ObjectKind kind, const WorldPoint &from,
+        const WorldPoint &to, std::vector<int> &indexes) {
+    newQuery();
+    int dx = to.x - from.x;
+    int dy = to.y - from.y;
+    int length = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+    int nbSteps = length / (kCellSize * 128) + 1;
+
+    for (int i = 0; i <= nbSteps; i++) {
+        int tx = (from.x + dx * i / nbSteps) / 256;
+        int ty = (from.y + dy * i / nbSteps) / 256;
+        markCells(tx, ty, tx, ty);
+    }
+    gather(kind, indexes);
+}
+
+/*!
+ * \param kind Kind of objects to look for
+ * \param minTileX Lower X tile of the rectangle
+ * \param minTileY Lower Y tile of the rectangle
+ * \param maxTileX Upper X tile of the rectangle
+ * \param maxTileY Upper Y tile of the rectangle
+ * \param indexes Indexes of objects in the mission list, at least all
+ * objects in the rectangle
+ */
+void ObjectGrid::findInTiles(ObjectKind kind, int minTileX, int minTileY,
+        int maxTileX, int maxTileY, std::vector<int> &indexes) {
+    newQuery();
+    markCells(minTileX, minTileY, maxTileX, maxTileY);
+    gather(kind, indexes);
+}
@@ -0,0 +1,103 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef OBJECTGRID_H
+#define OBJECTGRID_H
+
+#include <vector>
+
+#include "common.h"
+#include "model/position.h"
+
+class Mission;
+
+/*!
+ * Uniform grid of the map objects of a mission.
+ * The map is cut into square cells of kCellSize tiles and each cell lists
+ * the objects whose position is in it. Queries return the indexes of the
+ * objects in the lists of the mission, in increasing order, so a caller
+ * that loops on the result visits objects in the same order as a loop on
+ * the whole list.
+ * The grid is a snapshot of positions : objects keep on moving after it is
+ * built, so queries look one cell further than needed and callers must
+ * still check the exact position of the objects returned.
+ * The grid is built when the lists of the mission change ; when only
+ * positions have changed, update() moves the objects that changed cell.
+ */
+class ObjectGrid {
+public:
+    /*! Size of a cell in tiles.*/
+    static const int kCellSize = 4;
+
+    /*!
+     * Lists of the mission indexed by the grid.
+     */
+    enum ObjectKind {
+        kKindPed = 0,
+        kKindVehicle = 1,
+        kKindStatic = 2,
+        kKindWeapon = 3,
+        kKindSfx = 4,
+        kNbKinds = 5
+    };
+
+    ObjectGrid();
+
+    //! Puts all objects of the mission in the grid
+    void build(Mission *pMission);
+    //! Moves objects whose cell changed since last build or update
+    void update(Mission *pMission);
+
+    //! Finds objects of the given kind in a range around a point
+    void findInRange(ObjectKind kind, const WorldPoint &center, int range,
+            std::vector<int> &indexes);
+    //! Finds objects of the given kind close to a segment
+    void findAlongSegment(ObjectKind kind, const WorldPoint &from,
+            const WorldPoint &to, std::vector<int> &indexes);
+    //! Finds objects of the given kind in a rectangle of tiles
+    void findInTiles(ObjectKind kind, int minTileX, int minTileY,
+            int maxTileX, int maxTileY, std::vector<int> &indexes);
+
+protected:
+    int cellOf(int tileX, int tileY);
+    void newQuery();
+    void addObject(ObjectKind kind, int index, const TilePoint &pos);
+    void moveObject(ObjectKind kind, int index, const TilePoint &pos);
+    void markCells(int minTileX, int minTileY, int maxTileX, int maxTileY);
+    void gather(ObjectKind kind, std::vector<int> &indexes);
+
+protected:
+    /*! Number of cells on X and Y axis.*/
+    int nb_cells_x_, nb_cells_y_;
+    /*!
+     * Indexes of objects of kind k in cell c, in increasing order, are
+     * in objects_[k * nbCells + c].
+     */
+    std::vector<std::vector<int> > objects_;
+    /*! Cell of each object, by kind.*/
+    std::vector<int> object_cells_[kNbKinds];
+    /*! Cells selected by the current query.*/
+    std::vector<int> cells_;
+    /*! A cell is already selected when its mark equals mark_.*/
+    std::vector<uint32> cell_marks_;
+    uint32 mark_;
+};
+
+#endif  // OBJECTGRID_H
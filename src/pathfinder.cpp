@@ -0,0 +1,446 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <algorithm>
+#include <functional>
+
+#include "pathfinder.h"
+#include "mission.h"
+
+const uint32 AStarPathFinder::kCostStraight = 10;
+const uint32 AStarPathFinder::kCostDiagonal = 14;
+
+/*!
+ * \param algorithm One of the PathFinder::Algorithm values. If unknown,
+ * the flood algorithm is used.
+ */
+PathFinder *PathFinder::create(int algorithm) {
+    if (algorithm == kAlgoAStar) {
+        return new AStarPathFinder();
+    } else if (algorithm == kAlgoHierarchical) {
+        return new HierarchicalPathFinder();
+    }
+
+    return new FloodPathFinder();
+}
+
+AStarPathFinder::AStarPathFinder() {
+    generation_ = 0;
+}
+
+uint32 AStarPathFinder::heuristic(int x, int y, int destX, int destY) {
+    uint32 dx = x > destX ? x - destX : destX - x;
+    uint32 dy = y > destY ? y - destY : destY - y;
+
+    if (dx > dy) {
+        return kCostStraight * (dx - dy) + kCostDiagonal * dy;
+    }
+    return kCostStraight * (dy - dx) + kCostDiagonal * dx;
+}
+
+AStarPathFinder::NodeState &AStarPathFinder::node(int index) {
+    NodeState &state = nodes_[index];
+    if (state.generation != generation_) {
+        state.generation = generation_;
+        state.cost = 0xFFFFFFFF;
+        state.parent = -1;
+        state.closed = false;
+    }
+
+    return state;
+}
+
+bool AStarPathFinder::findPath(Mission *m, const TilePoint &start,
+        const TilePoint &dest, std::vector<TilePoint> &path) {
+    size_t nbNodes = m->mmax_x_ * m->mmax_y_ * m->mmax_z_;
+    if (nodes_.size() != nbNodes) {
+        NodeState empty;
+        empty.generation = 0;
+        nodes_.assign(nbNodes, empty);
+        generation_ = 0;
+    }
+
+    // a new generation invalidates all nodes of the previous search
+    generation_++;
+    if (generation_ == 0) {
+        for (size_t i = 0; i < nodes_.size(); i++) {
+            nodes_[i].generation = 0;
+        }
+        generation_ = 1;
+    }
+
+    int startIndex = start.tx + start.ty * m->mmax_x_ + start.tz * m->mmax_m_xy;
+    int destIndex = dest.tx + dest.ty * m->mmax_x_ + dest.tz * m->mmax_m_xy;
+
+    std::greater<OpenEntry> cmp;
+    open_.clear();
+
+    NodeState &startState = node(startIndex);
+    startState.cost = 0;
+    open_.push_back(OpenEntry(heuristic(start.tx, start.ty, dest.tx, dest.ty), startIndex));
+
+    bool found = false;
+    while (!open_.empty()) {
+        std::pop_heap(open_.begin(), open_.end(), cmp);
+        int cindx = open_.back().second;
+        open_.pop_back();
+
+        NodeState &current = node(cindx);
+        if (current.closed) {
+            // an entry with a better cost has already been expanded
+            continue;
+        }
+        current.closed = true;
+
+        if (cindx == destIndex) {
+            found = true;
+            break;
+        }
+
+        int x = cindx % m->mmax_x_;
+        int y = (cindx / m->mmax_x_) % m->mmax_y_;
+        int z = cindx / m->mmax_m_xy;
+        floodPointDesc *pfdp = &(m->mdpoints_[cindx]);
+        // directions for upper, same and lower levels
+        uint8 dirs[3] = { pfdp->dirh, pfdp->dirm, pfdp->dirl };
+        int dz[3] = { 1, 0, -1 };
+
+        for (int lvl = 0; lvl < 3; lvl++) {
+            if (dirs[lvl] == 0) {
+                continue;
+            }
+            for (int bit = 0; bit < 8; bit++) {
+                if ((dirs[lvl] & (1 << bit)) == 0) {
+                    continue;
+                }
+                int nx = x + floodPointDesc::kDirOffsetX[bit];
+                int ny = y + floodPointDesc::kDirOffsetY[bit];
+                int nz = z + dz[lvl];
+                int nindx = nx + ny * m->mmax_x_ + nz * m->mmax_m_xy;
+                if ((m->mdpoints_[nindx].bfNodeDesc & m_fdWalkable) == 0
+                    || !isNodeAllowed(nindx)) {
+                    continue;
+                }
+
+                NodeState &next = node(nindx);
+                if (next.closed) {
+                    continue;
+                }
+                // odd bits are diagonals
+                uint32 cost = current.cost
+                    + ((bit & 1) ? kCostDiagonal : kCostStraight);
+                if (cost < next.cost) {
+                    next.cost = cost;
+                    next.parent = cindx;
+                    open_.push_back(OpenEntry(cost + heuristic(nx, ny, dest.tx, dest.ty), nindx));
+                    std::push_heap(open_.begin(), open_.end(), cmp);
+                }
+            }
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    // walk back from destination to start
+    size_t first = path.size();
+    for (int indx = destIndex; indx != startIndex; indx = nodes_[indx].parent) {
+        path.push_back(TilePoint(indx % m->mmax_x_,
+            (indx / m->mmax_x_) % m->mmax_y_, indx / m->mmax_m_xy));
+    }
+    std::reverse(path.begin() + first, path.end());
+
+    return true;
+}
+
+HierarchicalPathFinder::HierarchicalPathFinder() {
+    p_sectors_ = NULL;
+    corridor_mark_ = 0;
+    restricted_ = false;
+}
+
+bool HierarchicalPathFinder::isNodeAllowed(int index) {
+    return !restricted_ || corridor_[p_sectors_->regionAt(index)] == corridor_mark_;
+}
+
+bool HierarchicalPathFinder::findPath(Mission *m, const TilePoint &start,
+        const TilePoint &dest, std::vector<TilePoint> &path) {
+    p_sectors_ = m->pathSectors();
+    int startIndex = start.tx + start.ty * m->mmax_x_ + start.tz * m->mmax_m_xy;
+    int destIndex = dest.tx + dest.ty * m->mmax_x_ + dest.tz * m->mmax_m_xy;
+
+    region_path_.clear();
+    if (p_sectors_->findRegionPath(startIndex, destIndex, region_path_, region_search_)) {
+        if (corridor_.size() != p_sectors_->numRegions()) {
+            corridor_.assign(p_sectors_->numRegions(), 0);
+            corridor_mark_ = 0;
+        }
+        corridor_mark_++;
+        if (corridor_mark_ == 0) {
+            corridor_.assign(corridor_.size(), 0);
+            corridor_mark_ = 1;
+        }
+        for (size_t i = 0; i < region_path_.size(); i++) {
+            corridor_[region_path_[i]] = corridor_mark_;
+        }
+
+        restricted_ = true;
+        bool found = AStarPathFinder::findPath(m, start, dest, path);
+        restricted_ = false;
+        if (found) {
+            return true;
+        }
+    }
+
+    return AStarPathFinder::findPath(m, start, dest, path);
+}
+
+DestinationField::DestinationField() {
+    dest_index_ = -1;
+    generation_ = 0;
+    p_mutex_ = SDL_CreateMutex();
+}
+
+DestinationField::~DestinationField() {
+    SDL_DestroyMutex(p_mutex_);
+}
+
+DestinationField::NodeState &DestinationField::node(int index) {
+    NodeState &state = nodes_[index];
+    if (state.generation != generation_) {
+        state.generation = generation_;
+        state.cost = 0xFFFFFFFF;
+        state.next = -1;
+        state.closed = false;
+    }
+
+    return state;
+}
+
+/*!
+ * Previous search is dropped, nothing is computed until a path is requested.
+ * \param m The mission that holds surfaces data
+ * \param destIndex Index of the destination in Mission::mdpoints_
+ */
+void DestinationField::reset(Mission *m, int destIndex) {
+    size_t nbNodes = m->mmax_x_ * m->mmax_y_ * m->mmax_z_;
+    if (nodes_.size() != nbNodes) {
+        NodeState empty;
+        empty.generation = 0;
+        nodes_.assign(nbNodes, empty);
+        generation_ = 0;
+    }
+
+    generation_++;
+    if (generation_ == 0) {
+        for (size_t i = 0; i < nodes_.size(); i++) {
+            nodes_[i].generation = 0;
+        }
+        generation_ = 1;
+    }
+
+    dest_index_ = destIndex;
+    open_.clear();
+    NodeState &destState = node(destIndex);
+    destState.cost = 0;
+    open_.push_back(OpenEntry(0, destIndex));
+}
+
+/*!
+ * The search goes backward : a node is added only if it can move to
+ * the node being expanded, so the direction masks are read from the
+ * neighbour with the opposite direction.
+ * \return True if node is reachable from the destination
+ */
+bool DestinationField::settle(Mission *m, int index) {
+    std::greater<OpenEntry> cmp;
+    // masks seen from the neighbour : upper level neighbour goes down
+    // and lower level neighbour goes up
+    int dz[3] = { 1, 0, -1 };
+
+    while (!node(index).closed) {
+        if (open_.empty()) {
+            return false;
+        }
+
+        std::pop_heap(open_.begin(), open_.end(), cmp);
+        int cindx = open_.back().second;
+        open_.pop_back();
+
+        NodeState &current = node(cindx);
+        if (current.closed) {
+            continue;
+        }
+        current.closed = true;
+
+        int x = cindx % m->mmax_x_;
+        int y = (cindx / m->mmax_x_) % m->mmax_y_;
+        int z = cindx / m->mmax_m_xy;
+        floodPointDesc *pfdp = &(m->mdpoints_[cindx]);
+        uint8 dirs[3] = { pfdp->dirh, pfdp->dirm, pfdp->dirl };
+
+        for (int lvl = 0; lvl < 3; lvl++) {
+            if (dirs[lvl] == 0) {
+                continue;
+            }
+            for (int bit = 0; bit < 8; bit++) {
+                if ((dirs[lvl] & (1 << bit)) == 0) {
+                    continue;
+                }
+                int nindx = (x + floodPointDesc::kDirOffsetX[bit])
+                    + (y + floodPointDesc::kDirOffsetY[bit]) * m->mmax_x_
+                    + (z + dz[lvl]) * m->mmax_m_xy;
+                floodPointDesc *pnfdp = &(m->mdpoints_[nindx]);
+                if ((pnfdp->bfNodeDesc & m_fdWalkable) == 0) {
+                    continue;
+                }
+                uint8 back = lvl == 0 ? pnfdp->dirl
+                    : (lvl == 1 ? pnfdp->dirm : pnfdp->dirh);
+                if ((back & (1 << ((bit + 4) & 7))) == 0) {
+                    continue;
+                }
+
+                NodeState &prev = node(nindx);
+                if (prev.closed) {
+                    continue;
+                }
+                uint32 cost = current.cost + ((bit & 1) ?
+                    AStarPathFinder::kCostDiagonal : AStarPathFinder::kCostStraight);
+                if (cost < prev.cost) {
+                    prev.cost = cost;
+                    prev.next = cindx;
+                    open_.push_back(OpenEntry(cost, nindx));
+                    std::push_heap(open_.begin(), open_.end(), cmp);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \param m The mission that holds surfaces data
+ * \param start Starting tile
+ * \param path Tiles to go through, start excluded and destination included
+ * \return True if a path was found
+ */
+bool DestinationField::pathFrom(Mission *m, const TilePoint &start,
+        std::vector<TilePoint> &path) {
+    int startIndex = start.tx + start.ty * m->mmax_x_ + start.tz * m->mmax_m_xy;
+    SDL_LockMutex(p_mutex_);
+    bool found = settle(m, startIndex);
+    if (found) {
+        for (int indx = nodes_[startIndex].next; indx != -1; indx = nodes_[indx].next) {
+            path.push_back(TilePoint(indx % m->mmax_x_,
+                (indx / m->mmax_x_) % m->mmax_y_, indx / m->mmax_m_xy));
+        }
+    }
+    SDL_UnlockMutex(p_mutex_);
+
+    return found;
+}
+
+PathCache::PathCache() {
+    for (int i = 0; i < kMaxDestinations; i++) {
+        entries_[i].destIndex = -1;
+        entries_[i].version = 0;
+        entries_[i].lastUse = 0;
+        entries_[i].shared = false;
+        entries_[i].pField = NULL;
+    }
+    use_counter_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+}
+
+PathCache::~PathCache() {
+    for (int i = 0; i < kMaxDestinations; i++) {
+        delete entries_[i].pField;
+    }
+}
+
+/*!
+ * Fields are kept allocated to be reused by next destinations.
+ */
+void PathCache::clear() {
+    for (int i = 0; i < kMaxDestinations; i++) {
+        entries_[i].destIndex = -1;
+        entries_[i].shared = false;
+    }
+}
+
+/*!
+ * A destination that is not in the cache takes the place of the least
+ * recently used one.
+ * \param m The mission that holds surfaces data
+ * \param dest Destination tile
+ * \return Index of the entry or -1 if the path finder must be used
+ */
+int PathCache::lookup(Mission *m, const TilePoint &dest) {
+    int destIndex = dest.tx + dest.ty * m->mmax_x_ + dest.tz * m->mmax_m_xy;
+    use_counter_++;
+
+    Entry *pLru = &entries_[0];
+    for (int i = 0; i < kMaxDestinations; i++) {
+        Entry &entry = entries_[i];
+        if (entry.destIndex == destIndex && entry.version == m->surfacesVersion()) {
+            entry.lastUse = use_counter_;
+            hits_++;
+            return i;
+        }
+
+        if (entry.destIndex == -1 || entry.version != m->surfacesVersion()) {
+            // Free entries are used first
+            pLru = &entry;
+            pLru->lastUse = 0;
+        } else if (entry.lastUse < pLru->lastUse) {
+            pLru = &entry;
+        }
+    }
+
+    pLru->destIndex = destIndex;
+    pLru->version = m->surfacesVersion();
+    pLru->lastUse = use_counter_;
+    pLru->shared = false;
+
+    misses_++;
+    return -1;
+}
+
+/*!
+ * The field is built on the second request for a destination. As fields
+ * are reused, no path request must be using the field when it is built.
+ * \param m The mission that holds surfaces data
+ * \param entry Index returned by lookup()
+ */
+DestinationField *PathCache::field(Mission *m, int entry) {
+    Entry &e = entries_[entry];
+    if (!e.shared) {
+        if (e.pField == NULL) {
+            e.pField = new DestinationField();
+        }
+        e.pField->reset(m, e.destIndex);
+        e.shared = true;
+    }
+
+    return e.pField;
+}
@@ -0,0 +1,296 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include <vector>
+#include <utility>
+
+#include <SDL.h>
+
+#include "common.h"
+#include "pathsurfaces.h"
+#include "pathsectors.h"
+
+class Mission;
+
+/*!
+ * Abstract class for path finding algorithms.
+ * A path finder works on the walkable surfaces and directions computed
+ * by Mission::setSurfaces().
+ */
+class PathFinder {
+public:
+    /*!
+     * List of available algorithms.
+     */
+    enum Algorithm {
+        /*! Bidirectional flood of the map.*/
+        kAlgoFlood = 0,
+        /*! A* with an octile heuristic.*/
+        kAlgoAStar = 1,
+        /*! A* on regions then A* limited to the regions found.*/
+        kAlgoHierarchical = 2
+    };
+
+    virtual ~PathFinder() {}
+
+    /*!
+     * Finds a path between two walkable tiles.
+     * \param pMission The mission that holds surfaces data
+     * \param start Starting tile
+     * \param dest Destination tile
+     * \param path Tiles to go through, start excluded and destination included
+     * \return True if a path was found
+     */
+    virtual bool findPath(Mission *pMission, const TilePoint &start,
+            const TilePoint &dest, std::vector<TilePoint> &path) = 0;
+
+    //! Creates a path finder for the given algorithm
+    static PathFinder *create(int algorithm);
+};
+
+/*!
+ * The original path finding algorithm : it floods the map from both the
+ * start and the destination until the two fronts meet, then removes
+ * unrelated tiles and builds the path.
+ */
+class FloodPathFinder : public PathFinder {
+public:
+    FloodPathFinder();
+
+    bool findPath(Mission *pMission, const TilePoint &start,
+            const TilePoint &dest, std::vector<TilePoint> &path);
+
+private:
+    void restoreMirror(Mission *m, const std::vector<toSetDesc> &nodes);
+    bool floodMap(Mission *m, const TilePoint &start, const TilePoint &clippedDestPt,
+        floodPointDesc *mdpmirror, std::vector <toSetDesc> &bv, std::vector <toSetDesc> &tv);
+    void removeTilesWithNoChildsFromBase(Mission *m, unsigned short blvl, std::vector <toSetDesc> &bv, std::vector <lvlNodesDesc> &bn, floodPointDesc *mdpmirror);
+    void removeTilesWithNoChildsFromTarget(Mission *m, unsigned short tlvl, std::vector <toSetDesc> &tv, std::vector <lvlNodesDesc> &tn, floodPointDesc *mdpmirror);
+    void createPath(Mission *m, const TilePoint &start, floodPointDesc *mdpmirror, std::vector<TilePoint> &cdestpath);
+
+private:
+    /*! Copy of Mission::mdpoints_ marked during a search.*/
+    std::vector<floodPointDesc> mirror_;
+    /*! Surfaces version of the mission when mirror was copied.*/
+    uint32 mirror_version_;
+};
+
+/*!
+ * A* search over the direction masks of the map nodes.
+ * Straight moves cost kCostStraight and diagonal moves kCostDiagonal,
+ * the heuristic is the octile distance on the X/Y plane.
+ * Search state is kept between searches and invalidated with a
+ * generation counter so nothing is cleared before a new search.
+ */
+class AStarPathFinder : public PathFinder {
+public:
+    AStarPathFinder();
+
+    bool findPath(Mission *pMission, const TilePoint &start,
+            const TilePoint &dest, std::vector<TilePoint> &path);
+
+    /*! Cost of a move along X or Y axis.*/
+    static const uint32 kCostStraight;
+    /*! Cost of a diagonal move.*/
+    static const uint32 kCostDiagonal;
+
+protected:
+
+    /*!
+     * Search state of a node.
+     */
+    struct NodeState {
+        /*! Node is valid only if equal to the current generation.*/
+        uint32 generation;
+        /*! Cost from start.*/
+        uint32 cost;
+        /*! Index of the previous node on the path.*/
+        int parent;
+        /*! True when node has been expanded.*/
+        bool closed;
+    };
+
+    /*! An entry in the open list : (estimated cost, node index).*/
+    typedef std::pair<uint32, int> OpenEntry;
+
+    //! Returns the octile distance between two tiles
+    uint32 heuristic(int x, int y, int destX, int destY);
+    //! Returns the state for the node at index, resetting it if needed
+    NodeState &node(int index);
+    //! Returns false if the search must not go through node at index
+    virtual bool isNodeAllowed(int index) { return true; }
+
+protected:
+    /*! State of all nodes of the map.*/
+    std::vector<NodeState> nodes_;
+    /*! Current search generation.*/
+    uint32 generation_;
+    /*! Storage of the open list, reused between searches.*/
+    std::vector<OpenEntry> open_;
+};
+
+/*!
+ * Hierarchical search : a route is first found on the graph of regions
+ * computed by PathSectors, then the A* search is limited to the regions
+ * of this route. If the limited search fails, as region links are only an
+ * approximation of the real moves, a full A* search is run.
+ */
+class HierarchicalPathFinder : public AStarPathFinder {
+public:
+    HierarchicalPathFinder();
+
+    bool findPath(Mission *pMission, const TilePoint &start,
+            const TilePoint &dest, std::vector<TilePoint> &path);
+
+protected:
+    bool isNodeAllowed(int index);
+
+protected:
+    /*! Sectors of the current search.*/
+    PathSectors *p_sectors_;
+    /*! State of the search on regions.*/
+    PathSectors::SearchState region_search_;
+    /*! Regions on the route of the current search.*/
+    std::vector<int> region_path_;
+    /*! A region is allowed when its value equals corridor_mark_.*/
+    std::vector<uint32> corridor_;
+    uint32 corridor_mark_;
+    /*! True when the search is limited to the corridor.*/
+    bool restricted_;
+};
+
+/*!
+ * Shortest paths from any tile toward a single destination.
+ * The field is a Dijkstra search run backward from the destination : each
+ * settled node knows the next node on its way to the destination.
+ * The search is resumed only when a path is requested from a tile that
+ * has not been settled yet, so peds sharing a destination share the work.
+ */
+class DestinationField {
+public:
+    DestinationField();
+    ~DestinationField();
+
+    //! Starts a new field toward the given node
+    void reset(Mission *pMission, int destIndex);
+    //! Gets the path from start to the destination of the field
+    bool pathFrom(Mission *pMission, const TilePoint &start,
+            std::vector<TilePoint> &path);
+
+protected:
+    /*!
+     * Search state of a node.
+     */
+    struct NodeState {
+        /*! Node is valid only if equal to the current generation.*/
+        uint32 generation;
+        /*! Cost to the destination.*/
+        uint32 cost;
+        /*! Index of the next node toward the destination.*/
+        int next;
+        /*! True when cost is final.*/
+        bool closed;
+    };
+
+    /*! An entry in the open list : (cost, node index).*/
+    typedef std::pair<uint32, int> OpenEntry;
+
+    //! Returns the state for the node at index, resetting it if needed
+    NodeState &node(int index);
+    //! Expands the search until node at index is settled
+    bool settle(Mission *pMission, int index);
+
+protected:
+    /*! Index of the destination node.*/
+    int dest_index_;
+    /*! State of all nodes of the map.*/
+    std::vector<NodeState> nodes_;
+    /*! Current field generation.*/
+    uint32 generation_;
+    /*! Storage of the open list, kept between requests.*/
+    std::vector<OpenEntry> open_;
+    /*! Path requests may read the field from several threads.*/
+    SDL_mutex *p_mutex_;
+};
+
+/*!
+ * Cache of paths toward recently requested destinations.
+ * The first request toward a destination goes to a path finder.
+ * When another request targets the same tile (a squad sent to the same
+ * place, police converging on the same ped), a DestinationField is built
+ * for that tile and answers all following requests, whatever their start.
+ * Entries are tagged with the surfaces version of the mission and are
+ * dropped when walkable surfaces change. Doors don't change surfaces :
+ * paths go through them and peds wait until they open, so the cache
+ * doesn't depend on their state.
+ * The cache is not used with the flood algorithm, whose paths differ.
+ * Entries are looked up from the main thread only, so the choice between
+ * the field and the path finder doesn't depend on threads.
+ */
+class PathCache {
+public:
+    /*! Number of destinations kept in the cache.*/
+    static const int kMaxDestinations = 4;
+
+    PathCache();
+    ~PathCache();
+
+    //! Returns the entry for the destination, -1 if it was not requested recently
+    int lookup(Mission *pMission, const TilePoint &dest);
+    //! Returns true if the field of the entry must be built before use
+    bool needsBuild(int entry) { return !entries_[entry].shared; }
+    //! Returns the field of the entry, building it if needed
+    DestinationField *field(Mission *pMission, int entry);
+    //! Forgets all destinations
+    void clear();
+
+    //! Returns the number of requests answered by a field
+    uint32 hits() { return hits_; }
+    //! Returns the number of requests sent to the path finder
+    uint32 misses() { return misses_; }
+
+protected:
+    /*!
+     * A destination in the cache.
+     */
+    struct Entry {
+        /*! Index of the destination node, -1 if entry is free.*/
+        int destIndex;
+        /*! Surfaces version when entry was created.*/
+        uint32 version;
+        /*! Value of the use counter at last request.*/
+        uint32 lastUse;
+        /*! True when field has been built for this destination.*/
+        bool shared;
+        /*! Field, kept allocated when the entry is reused.*/
+        DestinationField *pField;
+    };
+
+    Entry entries_[kMaxDestinations];
+    /*! Incremented on each request to find least recently used entry.*/
+    uint32 use_counter_;
+    uint32 hits_;
+    uint32 misses_;
+};
+
+#endif  // PATHFINDER_H
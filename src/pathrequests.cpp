@@ -0,0 +1,330 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "pathrequests.h"
+#include "pathfinder.h"
+#include "pathsectors.h"
+#include "mission.h"
+#include "utils/log.h"
+
+/*!
+ * \param pMission The mission whose surfaces are searched
+ * \param algorithm Path finding algorithm (see PathFinder::Algorithm)
+ * \param nbThreads Number of worker threads, 0 to search on the main thread
+ */
+PathRequestQueue::PathRequestQueue(Mission *pMission, int algorithm, int nbThreads) {
+    p_mission_ = pMission;
+    // the original flood doesn't give the same paths as the fields
+    // of the cache, they would replace its paths on repeated destinations
+    use_cache_ = algorithm != PathFinder::kAlgoFlood;
+    p_finder_ = PathFinder::create(algorithm);
+    last_ticket_ = 0;
+    tick_ = 0;
+    busy_ = 0;
+    stopping_ = false;
+    p_mutex_ = SDL_CreateMutex();
+    p_work_cond_ = SDL_CreateCond();
+    p_done_cond_ = SDL_CreateCond();
+
+    if (nbThreads > kMaxThreads) {
+        nbThreads = kMaxThreads;
+    }
+    // Workers keep a pointer on their entry so vector must not move
+    workers_.reserve(nbThreads);
+    for (int i = 0; i < nbThreads; i++) {
+        Worker worker;
+        worker.pQueue = this;
+        worker.pFinder = PathFinder::create(algorithm);
+        worker.pThread = NULL;
+        workers_.push_back(worker);
+    }
+
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i].pThread = SDL_CreateThread(workerMain, &workers_[i]);
+        if (workers_[i].pThread == NULL) {
+            FSERR(Log::k_FLG_GAME, "PathRequestQueue", "PathRequestQueue",
+                ("Cannot create path worker thread : %s\n", SDL_GetError()));
+        }
+    }
+}
+
+PathRequestQueue::~PathRequestQueue() {
+    SDL_LockMutex(p_mutex_);
+    stopping_ = true;
+    // Requests not started are dropped
+    while (!queue_.empty()) {
+        queue_.pop_front();
+        busy_--;
+    }
+    SDL_CondBroadcast(p_work_cond_);
+    SDL_UnlockMutex(p_mutex_);
+
+    for (size_t i = 0; i < workers_.size(); i++) {
+        if (workers_[i].pThread != NULL) {
+            SDL_WaitThread(workers_[i].pThread, NULL);
+        }
+        delete workers_[i].pFinder;
+    }
+
+    for (std::map<int, Request *>::iterator it = requests_.begin();
+        it != requests_.end(); ++it) {
+        delete it->second;
+    }
+
+    SDL_DestroyCond(p_done_cond_);
+    SDL_DestroyCond(p_work_cond_);
+    SDL_DestroyMutex(p_mutex_);
+    delete p_finder_;
+}
+
+int PathRequestQueue::workerMain(void *pData) {
+    Worker *pWorker = static_cast<Worker *>(pData);
+    pWorker->pQueue->run(pWorker->pFinder);
+    return 0;
+}
+
+/*!
+ * Main loop of a worker thread.
+ */
+void PathRequestQueue::run(PathFinder *pFinder) {
+    SDL_LockMutex(p_mutex_);
+    while (true) {
+        while (queue_.empty() && !stopping_) {
+            SDL_CondWait(p_work_cond_, p_mutex_);
+        }
+        if (stopping_) {
+            break;
+        }
+
+        Request *pRequest = queue_.front();
+        queue_.pop_front();
+        SDL_UnlockMutex(p_mutex_);
+
+        bool found = search(pFinder, pRequest);
+
+        SDL_LockMutex(p_mutex_);
+        pRequest->found = found;
+        pRequest->done = true;
+        busy_--;
+        if (pRequest->cancelled) {
+            delete pRequest;
+        }
+        SDL_CondBroadcast(p_done_cond_);
+    }
+    SDL_UnlockMutex(p_mutex_);
+}
+
+/*!
+ * Uses the connected components of the mission to reject a request.
+ */
+bool PathRequestQueue::isConnected(const TilePoint &start, const TilePoint &dest) {
+    Mission *m = p_mission_;
+    return m->pathSectors()->mayBeConnected(
+        start.tx + start.ty * m->mmax_x_ + start.tz * m->mmax_m_xy,
+        dest.tx + dest.ty * m->mmax_x_ + dest.tz * m->mmax_m_xy);
+}
+
+/*!
+ * Looks for the destination in the path cache of the mission.
+ * The cache is not used with the flood algorithm.
+ * Must be called from the main thread.
+ * \return The field to read the path from or NULL if a path finder must be used
+ */
+DestinationField *PathRequestQueue::prepare(const TilePoint &dest) {
+    if (!use_cache_) {
+        return NULL;
+    }
+
+    PathCache *pCache = p_mission_->pathCache();
+    int entry = pCache->lookup(p_mission_, dest);
+    if (entry == -1) {
+        return NULL;
+    }
+
+    if (pCache->needsBuild(entry)) {
+        // the field may be reused from another destination
+        // so wait for requests that could be reading it
+        waitIdle();
+    }
+    return pCache->field(p_mission_, entry);
+}
+
+bool PathRequestQueue::search(PathFinder *pFinder, Request *pRequest) {
+    if (pRequest->pField != NULL) {
+        return pRequest->pField->pathFrom(p_mission_, pRequest->start, pRequest->path);
+    }
+    return pFinder->findPath(p_mission_, pRequest->start, pRequest->dest, pRequest->path);
+}
+
+void PathRequestQueue::waitIdle() {
+    SDL_LockMutex(p_mutex_);
+    while (busy_ > 0) {
+        SDL_CondWait(p_done_cond_, p_mutex_);
+    }
+    SDL_UnlockMutex(p_mutex_);
+}
+
+/*!
+ * \param start Starting tile
+ * \param dest Destination tile
+ * \return A ticket to give to poll() or cancel()
+ */
+int PathRequestQueue::submit(const TilePoint &start, const TilePoint &dest) {
+    Request *pRequest = new Request();
+    pRequest->start = start;
+    pRequest->dest = dest;
+    pRequest->pField = NULL;
+    pRequest->done = false;
+    pRequest->found = false;
+    pRequest->cancelled = false;
+
+    if (!isConnected(start, dest)) {
+        pRequest->done = true;
+    } else {
+        pRequest->pField = prepare(dest);
+        if (workers_.empty()) {
+            pRequest->found = search(p_finder_, pRequest);
+            pRequest->done = true;
+        }
+    }
+
+    SDL_LockMutex(p_mutex_);
+    last_ticket_++;
+    if (last_ticket_ <= 0) {
+        last_ticket_ = 1;
+    }
+    int ticket = last_ticket_;
+    pRequest->tick = tick_;
+    requests_[ticket] = pRequest;
+    if (!pRequest->done) {
+        queue_.push_back(pRequest);
+        busy_++;
+        SDL_CondSignal(p_work_cond_);
+    }
+    SDL_UnlockMutex(p_mutex_);
+
+    return ticket;
+}
+
+/*!
+ * During the tick of the submission, the request is always pending.
+ * After, this method waits for the search to be over.
+ * Once the result has been returned, the ticket is no longer valid.
+ * \param ticket Ticket returned by submit()
+ * \param path Tiles to go through, start excluded and destination included
+ * \return The status of the request
+ */
+PathRequestQueue::Status PathRequestQueue::poll(int ticket, std::vector<TilePoint> &path) {
+    SDL_LockMutex(p_mutex_);
+    std::map<int, Request *>::iterator it = requests_.find(ticket);
+    if (it == requests_.end()) {
+        SDL_UnlockMutex(p_mutex_);
+        return kRequestUnknown;
+    }
+
+    Request *pRequest = it->second;
+    if (pRequest->tick == tick_) {
+        SDL_UnlockMutex(p_mutex_);
+        return kRequestPending;
+    }
+
+    while (!pRequest->done) {
+        SDL_CondWait(p_done_cond_, p_mutex_);
+    }
+    requests_.erase(it);
+    SDL_UnlockMutex(p_mutex_);
+
+    Status status = pRequest->found ? kRequestFound : kRequestNotFound;
+    path.insert(path.end(), pRequest->path.begin(), pRequest->path.end());
+    delete pRequest;
+    return status;
+}
+
+void PathRequestQueue::cancel(int ticket) {
+    SDL_LockMutex(p_mutex_);
+    std::map<int, Request *>::iterator it = requests_.find(ticket);
+    if (it != requests_.end()) {
+        Request *pRequest = it->second;
+        requests_.erase(it);
+        if (pRequest->done) {
+            delete pRequest;
+        } else {
+            bool queued = false;
+            for (std::deque<Request *>::iterator qit = queue_.begin();
+                qit != queue_.end(); ++qit) {
+                if (*qit == pRequest) {
+                    queue_.erase(qit);
+                    queued = true;
+                    break;
+                }
+            }
+
+            if (queued) {
+                busy_--;
+                delete pRequest;
+                SDL_CondBroadcast(p_done_cond_);
+            } else {
+                // a worker is running it and will delete it
+                pRequest->cancelled = true;
+            }
+        }
+    }
+    SDL_UnlockMutex(p_mutex_);
+}
+
+/*!
+ * \param start Starting tile
+ * \param dest Destination tile
+ * \param path Tiles to go through, start excluded and destination included
+ * \return True if a path was found
+ */
+bool PathRequestQueue::findPath(const TilePoint &start, const TilePoint &dest,
+        std::vector<TilePoint> &path) {
+    if (!isConnected(start, dest)) {
+        // no need to search : tiles are not connected at all
+        return false;
+    }
+
+    DestinationField *pField = prepare(dest);
+    if (pField != NULL) {
+        return pField->pathFrom(p_mission_, start, path);
+    }
+    return p_finder_->findPath(p_mission_, start, dest, path);
+}
+
+/*!
+ * Results that were not read for kMaxResultAge ticks are dropped : their
+ * requester has probably been destroyed.
+ */
+void PathRequestQueue::nextTick() {
+    SDL_LockMutex(p_mutex_);
+    tick_++;
+    std::map<int, Request *>::iterator it = requests_.begin();
+    while (it != requests_.end()) {
+        Request *pRequest = it->second;
+        if (pRequest->done && tick_ - pRequest->tick > kMaxResultAge) {
+            delete pRequest;
+            requests_.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    SDL_UnlockMutex(p_mutex_);
+}
@@ -0,0 +1,145 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef PATHREQUESTS_H
+#define PATHREQUESTS_H
+
+#include <vector>
+#include <deque>
+#include <map>
+
+#include <SDL.h>
+
+#include "common.h"
+#include "model/position.h"
+
+class Mission;
+class PathFinder;
+class DestinationField;
+
+/*!
+ * Queue of path searches run by worker threads.
+ * A request is submitted during a game tick and its result is delivered
+ * from the next tick : if the search is not finished then, poll() waits
+ * for it. This way the game gives the same results whatever the number
+ * of threads and the speed of the machine.
+ * Searches only read the surfaces of the mission, which don't change
+ * while a mission is played.
+ * With no worker thread, searches are run at submit time.
+ */
+class PathRequestQueue {
+public:
+    /*!
+     * Status of a request.
+     */
+    enum Status {
+        /*! Result is not available yet.*/
+        kRequestPending,
+        /*! A path was found.*/
+        kRequestFound,
+        /*! There is no path.*/
+        kRequestNotFound,
+        /*! Ticket is not known : request was cancelled or too old.*/
+        kRequestUnknown
+    };
+
+    /*! Number of ticks a result is kept if nobody reads it.*/
+    static const uint32 kMaxResultAge = 300;
+    /*! Maximum number of worker threads.*/
+    static const int kMaxThreads = 8;
+
+    PathRequestQueue(Mission *pMission, int algorithm, int nbThreads);
+    ~PathRequestQueue();
+
+    //! Adds a path search to the queue and returns its ticket
+    int submit(const TilePoint &start, const TilePoint &dest);
+    //! Returns the status of the request and the path if search is over
+    Status poll(int ticket, std::vector<TilePoint> &path);
+    //! Drops the request
+    void cancel(int ticket);
+    //! Finds a path now, on the calling thread
+    bool findPath(const TilePoint &start, const TilePoint &dest,
+            std::vector<TilePoint> &path);
+    //! Must be called at the beginning of each game tick
+    void nextTick();
+
+protected:
+    /*!
+     * A path search.
+     */
+    struct Request {
+        /*! Tick when the request was submitted.*/
+        uint32 tick;
+        TilePoint start;
+        TilePoint dest;
+        /*! If not null, the path is read from this field.*/
+        DestinationField *pField;
+        /*! True when search is over.*/
+        bool done;
+        /*! True if a path was found.*/
+        bool found;
+        /*! True if request was cancelled while a worker was running it.*/
+        bool cancelled;
+        std::vector<TilePoint> path;
+    };
+
+    /*!
+     * A worker thread with its own path finder.
+     */
+    struct Worker {
+        PathRequestQueue *pQueue;
+        PathFinder *pFinder;
+        SDL_Thread *pThread;
+    };
+
+    static int workerMain(void *pData);
+    void run(PathFinder *pFinder);
+    bool isConnected(const TilePoint &start, const TilePoint &dest);
+    DestinationField *prepare(const TilePoint &dest);
+    bool search(PathFinder *pFinder, Request *pRequest);
+    void waitIdle();
+
+protected:
+    Mission *p_mission_;
+    /*! False when paths must come from the path finder only.*/
+    bool use_cache_;
+    /*! Path finder used on the main thread.*/
+    PathFinder *p_finder_;
+    std::vector<Worker> workers_;
+    /*! Requests waiting for a worker.*/
+    std::deque<Request *> queue_;
+    /*! All requests not yet delivered, by ticket.*/
+    std::map<int, Request *> requests_;
+    int last_ticket_;
+    /*! Current game tick.*/
+    uint32 tick_;
+    /*! Number of requests queued or running.*/
+    int busy_;
+    /*! True when workers must stop.*/
+    bool stopping_;
+    /*! Protects all the fields above.*/
+    SDL_mutex *p_mutex_;
+    /*! Signaled when a request is queued.*/
+    SDL_cond *p_work_cond_;
+    /*! Signaled when a request is done.*/
+    SDL_cond *p_done_cond_;
+};
+
+#endif  // PATHREQUESTS_H
@@ -0,0 +1,267 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <algorithm>
+#include <functional>
+
+#include "pathsectors.h"
+#include "pathfinder.h"
+#include "mission.h"
+#include "utils/log.h"
+
+int PathSectors::findRoot(std::vector<int> &roots, int index) {
+    int root = index;
+    while (roots[root] != root) {
+        root = roots[root];
+    }
+    // compress path so next searches are shorter
+    while (roots[index] != root) {
+        int next = roots[index];
+        roots[index] = root;
+        index = next;
+    }
+    return root;
+}
+
+void PathSectors::join(std::vector<int> &roots, int a, int b) {
+    int ra = findRoot(roots, a);
+    int rb = findRoot(roots, b);
+    if (ra != rb) {
+        // keep the lowest index as root so ids follow map order
+        if (ra < rb) {
+            roots[rb] = ra;
+        } else {
+            roots[ra] = rb;
+        }
+    }
+}
+
+/*!
+ * Must be called once the directions of Mission::mdpoints_ are set.
+ * Two nodes are in the same component or region if a move exists between
+ * them in any way. Components are then only used to tell that there's
+ * no path : a path finder must still be run to find one.
+ * \param m The mission that holds surfaces data
+ */
+void PathSectors::build(Mission *m) {
+    int nbNodes = m->mmax_x_ * m->mmax_y_ * m->mmax_z_;
+    std::vector<int> compRoots(nbNodes);
+    std::vector<int> regionRoots(nbNodes);
+    for (int i = 0; i < nbNodes; i++) {
+        compRoots[i] = i;
+        regionRoots[i] = i;
+    }
+
+    int dz[3] = { 1, 0, -1 };
+    // links between regions of different sectors : (from node, to node)
+    std::vector<std::pair<int, int> > portals;
+
+    for (int indx = 0; indx < nbNodes; indx++) {
+        floodPointDesc *pfdp = &(m->mdpoints_[indx]);
+        if ((pfdp->bfNodeDesc & m_fdWalkable) == 0) {
+            continue;
+        }
+        int x = indx % m->mmax_x_;
+        int y = (indx / m->mmax_x_) % m->mmax_y_;
+        int z = indx / m->mmax_m_xy;
+        uint8 dirs[3] = { pfdp->dirh, pfdp->dirm, pfdp->dirl };
+
+        for (int lvl = 0; lvl < 3; lvl++) {
+            for (int bit = 0; bit < 8; bit++) {
+                if ((dirs[lvl] & (1 << bit)) == 0) {
+                    continue;
+                }
+                int nx = x + floodPointDesc::kDirOffsetX[bit];
+                int ny = y + floodPointDesc::kDirOffsetY[bit];
+                int nindx = nx + ny * m->mmax_x_ + (z + dz[lvl]) * m->mmax_m_xy;
+                if ((m->mdpoints_[nindx].bfNodeDesc & m_fdWalkable) == 0) {
+                    continue;
+                }
+
+                join(compRoots, indx, nindx);
+                if (x / kSectorSize == nx / kSectorSize
+                    && y / kSectorSize == ny / kSectorSize) {
+                    join(regionRoots, indx, nindx);
+                } else {
+                    portals.push_back(std::pair<int, int>(indx, nindx));
+                }
+            }
+        }
+    }
+
+    // Give a number to each component and region
+    components_.assign(nbNodes, 0);
+    regions_.assign(nbNodes, -1);
+    regionsDesc_.clear();
+    std::vector<int> sumX, sumY, sumZ, count;
+    uint32 nbComponents = 0;
+    for (int indx = 0; indx < nbNodes; indx++) {
+        if ((m->mdpoints_[indx].bfNodeDesc & m_fdWalkable) == 0) {
+            continue;
+        }
+
+        // roots have the lowest index so they are numbered first
+        int croot = findRoot(compRoots, indx);
+        if (croot == indx) {
+            components_[indx] = ++nbComponents;
+        } else {
+            components_[indx] = components_[croot];
+        }
+
+        int rroot = findRoot(regionRoots, indx);
+        if (rroot == indx) {
+            regions_[indx] = regionsDesc_.size();
+            regionsDesc_.push_back(Region());
+            sumX.push_back(0);
+            sumY.push_back(0);
+            sumZ.push_back(0);
+            count.push_back(0);
+        } else {
+            regions_[indx] = regions_[rroot];
+        }
+
+        int r = regions_[indx];
+        sumX[r] += indx % m->mmax_x_;
+        sumY[r] += (indx / m->mmax_x_) % m->mmax_y_;
+        sumZ[r] += indx / m->mmax_m_xy;
+        count[r]++;
+    }
+
+    for (size_t r = 0; r < regionsDesc_.size(); r++) {
+        regionsDesc_[r].x = sumX[r] / count[r];
+        regionsDesc_[r].y = sumY[r] / count[r];
+        regionsDesc_[r].z = sumZ[r] / count[r];
+    }
+
+    for (size_t i = 0; i < portals.size(); i++) {
+        std::vector<int> &links = regionsDesc_[regions_[portals[i].first]].links;
+        int to = regions_[portals[i].second];
+        if (std::find(links.begin(), links.end(), to) == links.end()) {
+            links.push_back(to);
+        }
+    }
+
+    LOG(Log::k_FLG_GAME, "PathSectors", "build", ("%d components, %d regions, %d portals",
+        nbComponents, (int) regionsDesc_.size(), (int) portals.size()));
+}
+
+PathSectors::RegionState &PathSectors::state(SearchState &search, int region) {
+    RegionState &st = search.states[region];
+    if (st.generation != search.generation) {
+        st.generation = search.generation;
+        st.cost = 0xFFFFFFFF;
+        st.parent = -1;
+        st.closed = false;
+    }
+    return st;
+}
+
+uint32 PathSectors::distance(const Region &from, const Region &to) {
+    uint32 dx = from.x > to.x ? from.x - to.x : to.x - from.x;
+    uint32 dy = from.y > to.y ? from.y - to.y : to.y - from.y;
+
+    if (dx > dy) {
+        return AStarPathFinder::kCostStraight * (dx - dy)
+            + AStarPathFinder::kCostDiagonal * dy;
+    }
+    return AStarPathFinder::kCostStraight * (dy - dx)
+        + AStarPathFinder::kCostDiagonal * dx;
+}
+
+/*!
+ * Runs an A* on the graph of regions. Cost of a link is the distance
+ * between the mean positions of the two regions.
+ * \param fromIndex Starting node
+ * \param toIndex Destination node
+ * \param regionPath Regions to cross, from start to destination included
+ * \param search State of the search, owned by the caller
+ * \return True if a list of regions was found
+ */
+bool PathSectors::findRegionPath(int fromIndex, int toIndex, std::vector<int> &regionPath,
+        SearchState &search) {
+    int from = regions_[fromIndex];
+    int to = regions_[toIndex];
+    if (from == -1 || to == -1) {
+        return false;
+    }
+
+    if (search.states.size() != regionsDesc_.size()) {
+        RegionState empty;
+        empty.generation = 0;
+        search.states.assign(regionsDesc_.size(), empty);
+        search.generation = 0;
+    }
+    search.generation++;
+    if (search.generation == 0) {
+        for (size_t i = 0; i < search.states.size(); i++) {
+            search.states[i].generation = 0;
+        }
+        search.generation = 1;
+    }
+
+    std::greater<OpenEntry> cmp;
+    search.open.clear();
+    state(search, from).cost = 0;
+    search.open.push_back(OpenEntry(distance(regionsDesc_[from], regionsDesc_[to]), from));
+
+    bool found = false;
+    while (!search.open.empty()) {
+        std::pop_heap(search.open.begin(), search.open.end(), cmp);
+        int cur = search.open.back().second;
+        search.open.pop_back();
+
+        RegionState &current = state(search, cur);
+        if (current.closed) {
+            continue;
+        }
+        current.closed = true;
+        if (cur == to) {
+            found = true;
+            break;
+        }
+
+        const Region &region = regionsDesc_[cur];
+        for (size_t i = 0; i < region.links.size(); i++) {
+            int next = region.links[i];
+            RegionState &nextState = state(search, next);
+            if (nextState.closed) {
+                continue;
+            }
+            uint32 cost = current.cost + distance(region, regionsDesc_[next]);
+            if (cost < nextState.cost) {
+                nextState.cost = cost;
+                nextState.parent = cur;
+                search.open.push_back(OpenEntry(cost + distance(regionsDesc_[next], regionsDesc_[to]), next));
+                std::push_heap(search.open.begin(), search.open.end(), cmp);
+            }
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    size_t first = regionPath.size();
+    for (int r = to; r != -1; r = search.states[r].parent) {
+        regionPath.push_back(r);
+    }
+    std::reverse(regionPath.begin() + first, regionPath.end());
+    return true;
+}
@@ -0,0 +1,116 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef PATHSECTORS_H
+#define PATHSECTORS_H
+
+#include <vector>
+#include <utility>
+
+#include "common.h"
+#include "pathsurfaces.h"
+
+class Mission;
+
+/*!
+ * Abstract view of the walkable surfaces of a mission.
+ * The map is cut into square sectors of kSectorSize tiles on X and Y.
+ * Inside a sector, connected walkable tiles form a region, and regions of
+ * two sectors are linked when a move goes from one to the other. The graph
+ * of regions is small enough to route long distances quickly.
+ * Connected components of the whole map are also computed so that one can
+ * tell in constant time that a tile can't be reached from another.
+ */
+class PathSectors {
+public:
+    /*! Size of a sector in tiles on X and Y axis.*/
+    static const int kSectorSize = 16;
+
+    //! Computes sectors from the surfaces of the mission
+    void build(Mission *pMission);
+
+    //! Returns false if there is no way between the two nodes
+    bool mayBeConnected(int fromIndex, int toIndex) {
+        return components_[fromIndex] != 0
+            && components_[fromIndex] == components_[toIndex];
+    }
+
+    //! Returns the region of the node at index, -1 if not walkable
+    int regionAt(int index) { return regions_[index]; }
+
+    /*!
+     * Search state of a region.
+     */
+    struct RegionState {
+        uint32 generation;
+        uint32 cost;
+        int parent;
+        bool closed;
+    };
+
+    /*!
+     * Data used by a search on regions. Sectors are only read during
+     * a search, so each thread searching regions has its own state.
+     */
+    struct SearchState {
+        SearchState() : generation(0) {}
+
+        /*! Search state of regions, valid for the current generation.*/
+        std::vector<RegionState> states;
+        uint32 generation;
+        /*! Storage of the open list, reused between searches.*/
+        std::vector<std::pair<uint32, int> > open;
+    };
+
+    //! Finds the list of regions to cross between two nodes
+    bool findRegionPath(int fromIndex, int toIndex, std::vector<int> &regionPath,
+            SearchState &search);
+
+    //! Returns the number of regions
+    size_t numRegions() { return regionsDesc_.size(); }
+
+protected:
+    /*!
+     * A region of a sector.
+     */
+    struct Region {
+        /*! Mean position of the region tiles.*/
+        int x, y, z;
+        /*! Regions that can be reached from this one.*/
+        std::vector<int> links;
+    };
+
+    typedef std::pair<uint32, int> OpenEntry;
+
+    int findRoot(std::vector<int> &roots, int index);
+    void join(std::vector<int> &roots, int a, int b);
+    RegionState &state(SearchState &search, int region);
+    uint32 distance(const Region &from, const Region &to);
+
+protected:
+    /*! Connected component of each node, 0 for non walkable nodes.*/
+    std::vector<uint32> components_;
+    /*! Region of each node, -1 for non walkable nodes.*/
+    std::vector<int> regions_;
+    /*! All regions.*/
+    std::vector<Region> regionsDesc_;
+};
+
+#endif  // PATHSECTORS_H
@@ -84,6 +84,10 @@
         static const uint8 kBMaskDirWest;
         //! In path finding, identify the direction to North-West
         static const uint8 kBMaskDirNorthWest;
+        //! Offset on X axis for each bit of a direction mask
+        static const int kDirOffsetX[8];
+        //! Offset on Y axis for each bit of a direction mask
+        static const int kDirOffsetY[8];
     };
 
     typedef enum {
@@ -733,6 +733,9 @@ PedInstance::PedInstance(Ped *ped, uint16 anId, int m, bool isOur) :
     panicImmuned_ = false;
     totalPersuasionPoints_ = 0;
     pSelectedWeaponBeforeMedikit_ = NULL;
+    path_ticket_ = 0;
+    path_request_speed_ = -1;
+    move_dist_carry_ = 0.0;
 }
 
 PedInstance::~PedInstance()
@@ -1385,7 +1388,7 @@ void PedInstance::verifyHostilesFound(Mission *m) {
             || (smo->nature() == MapObject::kNatureVehicle
             && ((Vehicle *)smo)->containsHostilesForPed(this, hostile_desc_))
             || (m->checkIfBlockersInShootingLine(cur_xyz, &smo, NULL, false, false,
-            check_rng, &distTo) != 1))
+            check_rng, &distTo, NULL, true) != 1))
         {
             rm_set.push_back(smo);
         }
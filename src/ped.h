@@ -334,6 +334,26 @@ public:
     //! See ShootableMovableMapObject::initMovementToDestination()
     bool initMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed = -1);
 
+    /*!
+     * Status of a path requested with requestMovementToDestination().
+     */
+    enum PathRequestStatus {
+        //! Path is being searched
+        kPathRequestPending,
+        //! Path has been set, ped is moving
+        kPathRequestDone,
+        //! No path was found
+        kPathRequestFailed
+    };
+    //! Asks for a path to destination without waiting for the search
+    bool requestMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed = -1);
+    //! Checks if the requested path is available and if so, uses it
+    PathRequestStatus updatePathRequest(Mission *m);
+    //! Returns true if a path has been requested and not received
+    bool isWaitingForPath() { return path_ticket_ != 0; }
+    //! Drops the current path request
+    void cancelPathRequest(Mission *m);
+
     //! See ShootableMovableMapObject::doMove()
     bool doMove(int elapsed, Mission *pMission);
 
@@ -659,10 +679,8 @@ protected:
 
 private:
     inline int getClosestDirs(int dir, int& closest, int& closer);
-    bool floodMap(Mission *m, const TilePoint &clippedDestPt, floodPointDesc *mdpmirror);
-    void removeTilesWithNoChildsFromBase(Mission *m, unsigned short blvl, std::vector <toSetDesc> &bv, std::vector <lvlNodesDesc> &bn, floodPointDesc *mdpmirror);
-    void removeTilesWithNoChildsFromTarget(Mission *m, unsigned short tlvl, std::vector <toSetDesc> &tv, std::vector <lvlNodesDesc> &tn, floodPointDesc *mdpmirror);
-    void createPath(Mission *m, floodPointDesc *mdpmirror, std::vector<TilePoint> &cdestpath);
+    bool checkMovementEnds(Mission *m, const TilePoint &destinationPt, TilePoint *pClippedDestPt);
+    bool setPathToDestination(Mission *m, std::vector<TilePoint> &cdestpath, const TilePoint &clippedDestPt, int newSpeed);
     void buildFinalDestinationPath(Mission *m, std::vector<TilePoint> &cdestpath, const TilePoint &destinationPt);
 
 protected:
@@ -744,6 +762,16 @@ protected:
     bool panicImmuned_;
     //! This field is used to select a weapon after medikit was used
     WeaponInstance *pSelectedWeaponBeforeMedikit_;
+    //! Ticket of the current path request, 0 if none
+    int path_ticket_;
+    //! Tile where ped was when the path was requested
+    TilePoint path_request_start_;
+    //! Destination of the current path request
+    TilePoint path_request_dest_;
+    //! Speed to use when the requested path is received
+    int path_request_speed_;
+    //! Distance moveToDir() moved too much (<0) or too little (>0) last tick
+    double move_dist_carry_;
 };
 
 #endif
@@ -146,18 +146,9 @@ void PedManager::initAnimation(Ped *pedanim, unsigned short baseAnim)
  */
 PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16 ped_idx, int map, uint32 playerGroupId)
 {
-    if(gamdata.type == 0x0 ||
-        gamdata.location == LevelData::kPeopleLocNotVisible ||
-        gamdata.location == LevelData::kPeopleLocAboveWalkSurf)
-        return NULL;
-
     bool isOurAgent = ped_idx < AgentManager::kMaxSlot;
-    if (isOurAgent && !g_gameCtrl.agents().isSquadSlotActive(ped_idx)) {
-        // Creates agent only if he's active
-        return NULL;
-    }if (ped_idx >= 4 && ped_idx < 8) {
-        // Ped between index 4 and 7 are not used
-        // In original game must be the place where persuaded agents were stored
+    if (!isCreated(gamdata, ped_idx,
+            isOurAgent && g_gameCtrl.agents().isSquadSlotActive(ped_idx))) {
         return NULL;
     }
 
@@ -184,19 +175,10 @@ PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16
         newped->setHealth(hp);
         newped->setStateMasks(PedInstance::pa_smStanding);
     }
-    // this is tile based Z we get, realword Z is in gamdata,
-    // for correct calculations of viewpoint, target hit etc.
-    // Zr = (Zt * 128) / 256
-    int z = READ_LE_UINT16(gamdata.mapposz) >> 7;
-    // some peds have z = 0 - map paraguay
-    int oz = gamdata.mapposz[0] & 0x7F;
     newped->setSizeX(32);
     newped->setSizeY(32);
     newped->setSizeZ(256);
-    //printf("x %i y %i z %i ox %i oy %i oz %i\n", gamdata.mapposx[1], gamdata.mapposy[1], z, gamdata.mapposx[0], gamdata.mapposy[0], oz);
-    newped->setPosition(gamdata.mapposx[1], gamdata.mapposy[1],
-                        z, gamdata.mapposx[0],
-                        gamdata.mapposy[0], oz);
+    newped->setPosition(startPosition(gamdata));
     newped->setTypeFromValue(gamdata.type_ped);
 
     newped->setAllAdrenaLevels(gamdata.adrena_amount,
@@ -230,6 +212,50 @@ PedInstance *PedManager::loadInstance(const LevelData::People & gamdata, uint16
     return newped;
 }
 
+/*!
+ * \param gamdata
+ * \param ped_idx Index of the ped in the file.
+ * \param activeAgent True if the ped is one of our agents and its slot
+ * in the squad is active
+ * \return True if loadInstance() creates a ped.
+ */
+bool PedManager::isCreated(const LevelData::People & gamdata, uint16 ped_idx, bool activeAgent)
+{
+    if(gamdata.type == 0x0 ||
+        gamdata.location == LevelData::kPeopleLocNotVisible ||
+        gamdata.location == LevelData::kPeopleLocAboveWalkSurf)
+        return false;
+
+    if (ped_idx < AgentManager::kMaxSlot && !activeAgent) {
+        // Creates agent only if he's active
+        return false;
+    }if (ped_idx >= 4 && ped_idx < 8) {
+        // Ped between index 4 and 7 are not used
+        // In original game must be the place where persuaded agents were stored
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \param gamdata
+ * \return The position of the ped on the map.
+ */
+TilePoint PedManager::startPosition(const LevelData::People & gamdata)
+{
+    // this is tile based Z we get, realword Z is in gamdata,
+    // for correct calculations of viewpoint, target hit etc.
+    // Zr = (Zt * 128) / 256
+    int z = READ_LE_UINT16(gamdata.mapposz) >> 7;
+    // some peds have z = 0 - map paraguay
+    int oz = gamdata.mapposz[0] & 0x7F;
+    //printf("x %i y %i z %i ox %i oy %i oz %i\n", gamdata.mapposx[1], gamdata.mapposy[1], z, gamdata.mapposx[0], gamdata.mapposy[0], oz);
+    return TilePoint(gamdata.mapposx[1], gamdata.mapposy[1],
+                        z, gamdata.mapposx[0],
+                        gamdata.mapposy[0], oz);
+}
+
 /*!
  * Initialize the ped instance as one of our agent.
  * \param pAgent The agent reference
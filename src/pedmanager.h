@@ -43,6 +43,10 @@ public:
     virtual ~PedManager() {}
 
     PedInstance *loadInstance(const LevelData::People & ped_data, uint16 ped_idx, int map, uint32 playerGroupId);
+    //! Returns true if loadInstance() creates a ped for the given data
+    static bool isCreated(const LevelData::People & ped_data, uint16 ped_idx, bool activeAgent);
+    //! Returns the position of a ped created from the given data
+    static TilePoint startPosition(const LevelData::People & ped_data);
 protected:
     void initAnimation(Ped *pedanim, unsigned short baseAnim);
     //! Initialize the ped instance as our agent
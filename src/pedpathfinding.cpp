@@ -28,6 +28,8 @@
 #include "mission.h"
 #include "ped.h"
 #include "pathsurfaces.h"
+#include "pathfinder.h"
+#include "pathrequests.h"
 #include "gfx/tile.h"
 #include "utils/log.h"
 
@@ -44,9 +46,12 @@ const uint8 floodPointDesc::kBMaskDirSouthEast = 0x02;
 const uint8 floodPointDesc::kBMaskDirSouthWest = 0x80;
 const uint8 floodPointDesc::kBMaskDirWest = 0x40;
 const uint8 floodPointDesc::kBMaskDirNorthWest = 0x20;
+const int floodPointDesc::kDirOffsetX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int floodPointDesc::kDirOffsetY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
 
 /*!
  * Sets a destination point for the ped to reach at given speed.
+ * The path is searched immediately.
  * \param m
  * \param node destination point
  * \param newSpeed Speed of movement
@@ -55,21 +60,123 @@ const uint8 floodPointDesc::kBMaskDirNorthWest = 0x20;
 bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed) {
 
     dest_path_.clear();
+    cancelPathRequest(m);
 
-    if (health_ <= 0) {
+    TilePoint clippedDestPt;
+    if (!checkMovementEnds(m, destinationPt, &clippedDestPt)) {
         return false;
     }
 
-    TilePoint clippedDestPt(destinationPt);
-    m->get_map()->clip(&clippedDestPt);
-
-    // NOTE: this is a "flood" algorithm, it expands until it reaches other's
-    // flood point, then it removes unrelated points
 #ifdef EXECUTION_SPEED_TIME
     printf("---------------------------");
     printf("start time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
 #endif
 
+    // path is created here
+    std::vector<TilePoint> cdestpath;
+    cdestpath.reserve(256);
+
+    m->findPath(TilePoint(pos_.tx, pos_.ty, pos_.tz), clippedDestPt, cdestpath);
+
+#ifdef EXECUTION_SPEED_TIME
+    printf("path creation time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
+#endif
+
+    return setPathToDestination(m, cdestpath, clippedDestPt, newSpeed);
+}
+
+/*!
+ * Sets a destination point for the ped to reach at given speed.
+ * The path is searched by the path request queue of the mission and
+ * updatePathRequest() must be called on the next ticks to use it.
+ * While waiting, the ped keeps on following his current path if any.
+ * \param m
+ * \param destinationPt destination point
+ * \param newSpeed Speed of movement
+ * \return false if destination cannot be reached.
+ */
+bool PedInstance::requestMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed) {
+    cancelPathRequest(m);
+
+    TilePoint clippedDestPt;
+    if (!checkMovementEnds(m, destinationPt, &clippedDestPt)) {
+        dest_path_.clear();
+        return false;
+    }
+
+    path_request_start_ = TilePoint(pos_.tx, pos_.ty, pos_.tz);
+    path_request_dest_ = clippedDestPt;
+    path_request_speed_ = newSpeed;
+    path_ticket_ = m->pathRequests()->submit(path_request_start_, clippedDestPt);
+    return true;
+}
+
+/*!
+ * If the result of the request is available, sets the path and the speed
+ * as initMovementToDestination() does.
+ * \param m
+ * \return The status of the request.
+ */
+PedInstance::PathRequestStatus PedInstance::updatePathRequest(Mission *m) {
+    if (path_ticket_ == 0) {
+        return hasDestination() ? kPathRequestDone : kPathRequestFailed;
+    }
+
+    std::vector<TilePoint> cdestpath;
+    PathRequestQueue::Status status = m->pathRequests()->poll(path_ticket_, cdestpath);
+    if (status == PathRequestQueue::kRequestPending) {
+        return kPathRequestPending;
+    }
+    path_ticket_ = 0;
+
+    if (status == PathRequestQueue::kRequestFound && !sameTile(path_request_start_)) {
+        // Ped has walked on his previous path while waiting : the new path
+        // is used from where he is now
+        std::vector<TilePoint>::iterator it = cdestpath.begin();
+        while (it != cdestpath.end() && !sameTile(*it)) {
+            ++it;
+        }
+
+        if (it == cdestpath.end()) {
+            status = PathRequestQueue::kRequestUnknown;
+        } else {
+            cdestpath.erase(cdestpath.begin(), it + 1);
+        }
+    }
+
+    if (status == PathRequestQueue::kRequestUnknown) {
+        // result is lost or can't be used : ask again
+        return requestMovementToDestination(m, path_request_dest_, path_request_speed_) ?
+            kPathRequestPending : kPathRequestFailed;
+    }
+
+    dest_path_.clear();
+    return setPathToDestination(m, cdestpath, path_request_dest_, path_request_speed_) ?
+        kPathRequestDone : kPathRequestFailed;
+}
+
+void PedInstance::cancelPathRequest(Mission *m) {
+    if (path_ticket_ != 0) {
+        m->pathRequests()->cancel(path_ticket_);
+        path_ticket_ = 0;
+    }
+}
+
+/*!
+ * Checks that ped can walk from his position to destination.
+ * \param m
+ * \param destinationPt destination point
+ * \param pClippedDestPt destination clipped to the map
+ * \return false if there's no need to search a path.
+ */
+bool PedInstance::checkMovementEnds(Mission *m, const TilePoint &destinationPt, TilePoint *pClippedDestPt) {
+    if (health_ <= 0) {
+        return false;
+    }
+
+    TilePoint &clippedDestPt = *pClippedDestPt;
+    clippedDestPt = destinationPt;
+    m->get_map()->clip(&clippedDestPt);
 
     floodPointDesc *targetd = &(m->mdpoints_[clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_ + clippedDestPt.tz * m->mmax_m_xy]);
 
@@ -116,35 +223,16 @@ bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destina
         // path finding even if costly
         return false;
     }
-#ifdef EXECUTION_SPEED_TIME
-    printf("directions-map copy start %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
-    floodPointDesc *mdpmirror = m->mdpoints_cp_;
-    memcpy((void *)mdpmirror, (void *)m->mdpoints_,
-        m->mmax_x_ * m->mmax_y_ * m->mmax_z_ * sizeof(floodPointDesc));
-
-#ifdef EXECUTION_SPEED_TIME
-    printf("directions-map copy complete %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
-
-    if (!floodMap(m, clippedDestPt, mdpmirror)) {
-        return false;
-    }
-
-#ifdef EXECUTION_SPEED_TIME
-    printf("non-related removed time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
 
-    // path is created here
-    std::vector<TilePoint> cdestpath;
-    cdestpath.reserve(256);
-
-    createPath(m, mdpmirror, cdestpath);
-
-#ifdef EXECUTION_SPEED_TIME
-    printf("path creation time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
+    return true;
+}
 
+/*!
+ * Builds the final path from the tiles found by the path finder.
+ * \return true if ped has a destination.
+ */
+bool PedInstance::setPathToDestination(Mission *m, std::vector<TilePoint> &cdestpath,
+        const TilePoint &clippedDestPt, int newSpeed) {
     // TODO: smoother path
     // stairs to surface, surface to stairs correction
     if (!cdestpath.empty()) {
@@ -160,37 +248,73 @@ bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destina
         speed_ = newSpeed != -1 ? newSpeed : getDefaultSpeed();
         return true;
     }
+}
 
-#if 0
-    for (std::list <TilePoint>::iterator it = dest_path_.begin();
-        it != dest_path_.end(); ++it) {
-        printf("x %i, y %i, z %i\n", it->bfNodeDescileX(),it->tileY(),it->tileZ());
-    }
-#endif
-#ifdef EXECUTION_SPEED_TIME
-    dest_path_.clear();
-    printf("+++++++++++++++++++++++++++");
-    printf("end time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
+FloodPathFinder::FloodPathFinder() {
+    mirror_version_ = 0;
 }
 
-bool PedInstance::floodMap(Mission *m, const TilePoint &clippedDestPt, floodPointDesc *mdpmirror) {
-    unsigned char lt;
-    unsigned short blvl = 0, tlvl = 0;
+/*!
+ * Floods the map from start and destination then builds the path.
+ * The mirror is a copy of mdpoints_ owned by the path finder : the search
+ * marks the tiles it visits, those tiles are stored in bv and tv and
+ * restored once the path is built.
+ */
+bool FloodPathFinder::findPath(Mission *m, const TilePoint &start,
+        const TilePoint &dest, std::vector<TilePoint> &path) {
+    size_t nbNodes = m->mmax_x_ * m->mmax_y_ * m->mmax_z_;
+    if (mirror_.size() != nbNodes || mirror_version_ != m->surfacesVersion()) {
+        mirror_.assign(m->mdpoints_, m->mdpoints_ + nbNodes);
+        mirror_version_ = m->surfacesVersion();
+    }
+    floodPointDesc *mdpmirror = &mirror_[0];
     // these are all tiles that belong to base and target
     std::vector <toSetDesc> bv;
     std::vector <toSetDesc> tv;
     bv.reserve(8192);
     tv.reserve(8192);
+
+    bool found = floodMap(m, start, dest, mdpmirror, bv, tv);
+    if (found) {
+        createPath(m, start, mdpmirror, path);
+    }
+
+    restoreMirror(m, bv);
+    restoreMirror(m, tv);
+    return found;
+}
+
+/*!
+ * Instead of copying the whole map before each search, only the visited
+ * nodes are restored from mdpoints_ after the search.
+ * \param m The mission that holds surfaces data
+ * \param nodes List of nodes from the mirror that were modified
+ */
+void FloodPathFinder::restoreMirror(Mission *m, const std::vector<toSetDesc> &nodes) {
+    floodPointDesc *mdpmirror = &mirror_[0];
+    for (std::vector<toSetDesc>::const_iterator it = nodes.begin();
+        it != nodes.end(); ++it) {
+        *(it->pNode) = m->mdpoints_[it->pNode - mdpmirror];
+    }
+}
+
+/*!
+ * NOTE: this is a "flood" algorithm, it expands until it reaches other's
+ * flood point, then it removes unrelated points
+ */
+bool FloodPathFinder::floodMap(Mission *m, const TilePoint &start, const TilePoint &clippedDestPt, floodPointDesc *mdpmirror,
+    std::vector <toSetDesc> &bv, std::vector <toSetDesc> &tv) {
+    unsigned char lt;
+    unsigned short blvl = 0, tlvl = 0;
     // these are used for setting values through algorithm
     toSetDesc sadd;
     floodPointDesc *pfdp;
     // setup
-    pfdp = &(mdpmirror[pos_.tx + pos_.ty * m->mmax_x_ + pos_.tz * m->mmax_m_xy]);
+    pfdp = &(mdpmirror[start.tx + start.ty * m->mmax_x_ + start.tz * m->mmax_m_xy]);
     pfdp->bfNodeDesc |= m_fdBasePoint;
-    sadd.coords.x = pos_.tx;
-    sadd.coords.y = pos_.ty;
-    sadd.coords.z = pos_.tz;
+    sadd.coords.x = start.tx;
+    sadd.coords.y = start.ty;
+    sadd.coords.z = start.tz;
     sadd.pNode = pfdp;
     bv.push_back(sadd);
     pfdp = &(mdpmirror[clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_ + clippedDestPt.tz * m->mmax_m_xy]);
@@ -1027,7 +1151,7 @@ bool PedInstance::floodMap(Mission *m, const TilePoint &clippedDestPt, floodPoin
     return true;
 }
 
-void PedInstance::removeTilesWithNoChildsFromBase(Mission *m, unsigned short blvl, std::vector <toSetDesc> &bv, std::vector <lvlNodesDesc> &bn, floodPointDesc *mdpmirror) {
+void FloodPathFinder::removeTilesWithNoChildsFromBase(Mission *m, unsigned short blvl, std::vector <toSetDesc> &bv, std::vector <lvlNodesDesc> &bn, floodPointDesc *mdpmirror) {
     if (blvl > 1) {
         floodPointDesc *pfdp;
         --blvl;
@@ -1165,7 +1289,7 @@ void PedInstance::removeTilesWithNoChildsFromBase(Mission *m, unsigned short blv
     }
 }
 
-void PedInstance::removeTilesWithNoChildsFromTarget(Mission *m, unsigned short tlvl, std::vector <toSetDesc> &tv, std::vector <lvlNodesDesc> &tn, floodPointDesc *mdpmirror) {
+void FloodPathFinder::removeTilesWithNoChildsFromTarget(Mission *m, unsigned short tlvl, std::vector <toSetDesc> &tv, std::vector <lvlNodesDesc> &tn, floodPointDesc *mdpmirror) {
     if (tlvl > 1) {
         --tlvl;
         unsigned short indx = tn[tlvl].indxs + tn[tlvl].n;
@@ -1303,8 +1427,8 @@ void PedInstance::removeTilesWithNoChildsFromTarget(Mission *m, unsigned short t
     }
 }
 
-void PedInstance::createPath(Mission *m, floodPointDesc *mdpmirror, std::vector<TilePoint> &pathToDestination) {
-    TilePoint currentTile(pos_.tx, pos_.ty, pos_.tz);
+void FloodPathFinder::createPath(Mission *m, const TilePoint &start, floodPointDesc *mdpmirror, std::vector<TilePoint> &pathToDestination) {
+    TilePoint currentTile(start.tx, start.ty, start.tz);
     unsigned char ct = m_fdBasePoint;
     bool tnr = true, np = true;
     floodPointDesc *pfdp;
@@ -2325,7 +2449,9 @@ void PedInstance::buildFinalDestinationPath(Mission *m, std::vector<TilePoint> &
 bool PedInstance::doMove(int elapsed, Mission *pMission)
 {
     bool updated = false;
-    int used_time = elapsed;
+    // kept as double so the time of partial units isn't lost
+    double used_time = elapsed + move_time_carry_;
+    move_time_carry_ = 0.0;
 
     while ((!dest_path_.empty()) && used_time != 0) {
         int nxtTileX = dest_path_.front().tx;
@@ -2399,19 +2525,23 @@ bool PedInstance::doMove(int elapsed, Mission *pMission)
                 dy = (int)((diffy * (speed_ * avail_time_use) / d) / 1000);
 
             if (dx || dy) {
-                int prv_time = used_time;
+                double prv_time = used_time;
                 if (dx) {
-                    used_time -= (int)(((double) dx * 1000.0 * d)
-                        / (double)(diffx * speed_));
+                    used_time -= ((double) dx * 1000.0 * d)
+                        / (double)(diffx * speed_);
                 } else if (dy) {
-                    used_time -= (int)(((double) dy * 1000.0 * d)
-                        / (double)(diffy * speed_));
+                    used_time -= ((double) dy * 1000.0 * d)
+                        / (double)(diffy * speed_);
                 } else
                     used_time = 0;
                 if (used_time < 0 || prv_time == used_time)
                     used_time = 0;
-            } else
+            } else {
+                // keep the time for next tick, otherwise peds get
+                // slower as the tick rate rises
+                move_time_carry_ = used_time;
                 used_time = 0;
+            }
 
             addOffsetToPosition(dx, dy);
             // TODO : what obstacles? cars? doors are already
@@ -2510,7 +2640,11 @@ uint8 PedInstance::moveToDir(Mission* m, int elapsed, DirMoveType &dir_move,
         }
     }
 
-    double dist_curr = (elapsed * speed_) / 1000.0;
+    // the walk below moves by whole units, what was moved too much or too
+    // little last tick is taken into account so speed doesn't depend on
+    // the tick rate
+    double dist_curr = (elapsed * speed_) / 1000.0 + move_dist_carry_;
+    move_dist_carry_ = 0.0;
     if (dist == NULL || (dist && *dist == 0)) {
          if (dist_to_pos_ > 0 && (int)dist_curr > dist_to_pos_)
              dist_curr = (double) dist_to_pos_;
@@ -2827,6 +2961,8 @@ uint8 PedInstance::moveToDir(Mission* m, int elapsed, DirMoveType &dir_move,
             }
         }
     }
+    if ((move_mask & 1) != 0 && dist_curr > -1.0 && dist_curr < 1.0)
+        move_dist_carry_ = dist_curr;
     offzOnStairs(m->mtsurfaces_[pos_.tx + pos_.ty * m->mmax_x_
         + pos_.tz * m->mmax_m_xy]);
     if (set_dist && dist != NULL)
@@ -0,0 +1,576 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <string.h>
+
+#include "presenter_sdl.h"
+#include "gfx/blitkernels.h"
+#include "gfx/screen.h"
+#include "utils/log.h"
+
+Presenter::Presenter() {
+    p_display_ = NULL;
+    scale_ = 1;
+    full_update_ = true;
+    cursor_drawn_ = false;
+}
+
+/*!
+ * Clips the rect to the screen.
+ * \return False if nothing is left
+ */
+bool Presenter::clipToScreen(SDL_Rect *pRect, int x, int y, int width, int height) {
+    int x1 = x < 0 ? 0 : x;
+    int y1 = y < 0 ? 0 : y;
+    int x2 = x + width > GAME_SCREEN_WIDTH ? GAME_SCREEN_WIDTH : x + width;
+    int y2 = y + height > GAME_SCREEN_HEIGHT ? GAME_SCREEN_HEIGHT : y + height;
+    if (x2 <= x1 || y2 <= y1) {
+        return false;
+    }
+    pRect->x = x1;
+    pRect->y = y1;
+    pRect->w = x2 - x1;
+    pRect->h = y2 - y1;
+    return true;
+}
+
+/*!
+ * Copies the modified areas of the Screen, or the whole Screen.
+ * \param pDest Destination buffer, with the size of the Screen
+ * \param pitch Bytes between two rows of the destination
+ * \param rects Receives the areas copied, unless the whole screen is copied
+ * \param full True to copy the whole screen
+ * \return The number of rects
+ */
+int Presenter::copyDirtyAreas(uint8 *pDest, int pitch, SDL_Rect *rects, bool full) {
+    if (full) {
+        for (int j = 0; j < GAME_SCREEN_HEIGHT; j++) {
+            memcpy(pDest + j * pitch, g_Screen.pixels() + j * GAME_SCREEN_WIDTH,
+                   GAME_SCREEN_WIDTH);
+        }
+        return 0;
+    }
+
+    int nbRects = 0;
+    for (int i = 0; i < g_Screen.numDirtyAreas(); i++) {
+        const DirtyRect &area = g_Screen.dirtyArea(i);
+        for (int j = area.y; j < area.y + area.height; j++) {
+            memcpy(pDest + j * pitch + area.x,
+                   g_Screen.pixels() + j * GAME_SCREEN_WIDTH + area.x, area.width);
+        }
+        if (clipToScreen(&rects[nbRects], area.x, area.y, area.width, area.height)) {
+            nbRects++;
+        }
+    }
+    return nbRects;
+}
+
+/*!
+ * Returns true if the cursor must be drawn again or erased.
+ */
+bool Presenter::cursorNeedsUpdate(const CursorImage &cursor, bool cursorChanged) {
+    if (cursor.pSurface == NULL) {
+        return cursor_drawn_;
+    }
+    return cursorChanged;
+}
+
+/*!
+ * Sets the rect with the area of the previous cursor, which must be
+ * erased.
+ * \return False if there was no cursor
+ */
+bool Presenter::addOldCursor(SDL_Rect *pRect) {
+    return cursor_drawn_ && clipToScreen(pRect, last_cursor_rect_.x,
+        last_cursor_rect_.y, last_cursor_rect_.w, last_cursor_rect_.h);
+}
+
+/*!
+ * Records the cursor about to be drawn and sets the rect with its area.
+ * \return False if no cursor is drawn
+ */
+bool Presenter::setCursor(const CursorImage &cursor, SDL_Rect *pRect) {
+    cursor_drawn_ = cursor.pSurface != NULL;
+    if (!cursor_drawn_) {
+        return false;
+    }
+    last_cursor_rect_.x = cursor.x;
+    last_cursor_rect_.y = cursor.y;
+    last_cursor_rect_.w = cursor.rect.w;
+    last_cursor_rect_.h = cursor.rect.h;
+    return clipToScreen(pRect, cursor.x, cursor.y, cursor.rect.w, cursor.rect.h);
+}
+
+SurfacePresenter::SurfacePresenter() {
+    p_surface_ = NULL;
+}
+
+SurfacePresenter::~SurfacePresenter() {
+    if (p_surface_) {
+        SDL_FreeSurface(p_surface_);
+    }
+}
+
+bool SurfacePresenter::open(int depth, bool fullscreen) {
+    // TODO(nobody): maybe use double buffering?
+#ifdef GP2X
+    p_display_ = SDL_SetVideoMode(320, 240, 16, SDL_SWSURFACE);
+    p_surface_ =
+        SDL_CreateRGBSurface(SDL_SWSURFACE, 320, 240, 8, 0, 0, 0, 0);
+#else
+    p_display_ =
+        SDL_SetVideoMode(GAME_SCREEN_WIDTH, GAME_SCREEN_HEIGHT, depth,
+                         SDL_DOUBLEBUF | SDL_HWSURFACE | (fullscreen ?
+                                                          SDL_FULLSCREEN :
+                                                          0));
+    p_surface_ =
+        SDL_CreateRGBSurface(SDL_SWSURFACE, GAME_SCREEN_WIDTH,
+                             GAME_SCREEN_HEIGHT, 8, 0, 0, 0, 0);
+#endif
+
+    return p_display_ != NULL && p_surface_ != NULL;
+}
+
+void SurfacePresenter::setColors(const SDL_Color *colors, int first, int nb) {
+    SDL_SetColors(p_surface_, const_cast<SDL_Color *>(colors), first, nb);
+    // all colors on the display may have changed
+    full_update_ = true;
+}
+
+/*!
+ * If the display is double buffered, the back buffer may hold an older
+ * frame so the whole screen is sent.
+ */
+void SurfacePresenter::present(const CursorImage &cursor, bool cursorChanged) {
+    if (!g_Screen.dirty() && !cursorNeedsUpdate(cursor, cursorChanged)) {
+        return;
+    }
+
+#ifdef GP2X
+    bool full = true;
+#else
+    bool full = full_update_ || (p_display_->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF;
+#endif
+    SDL_Rect rects[kMaxRects];
+    int nbRects = 0;
+
+    SDL_LockSurface(p_surface_);
+#ifdef GP2X
+    const uint8 *pixeldata = g_Screen.pixels();
+    uint8 *screen = (uint8 *) p_surface_->pixels;
+    for (int j = 0; j < 240; j++)
+        for (int i = 0; i < 320; i++) {
+            int tx = i * GAME_SCREEN_WIDTH / 320;
+            int ty = j * GAME_SCREEN_HEIGHT / 240;
+
+            uint8 c = pixeldata[ty * GAME_SCREEN_WIDTH + tx];
+            screen[j * 320 + i] = c;
+        }
+#else
+    nbRects = copyDirtyAreas((uint8 *) p_surface_->pixels, p_surface_->pitch, rects, full);
+#endif
+    SDL_UnlockSurface(p_surface_);
+
+    g_Screen.clearDirty();
+
+    if (full) {
+        SDL_BlitSurface(p_surface_, NULL, p_display_, NULL);
+    } else {
+        if (addOldCursor(&rects[nbRects])) {
+            nbRects++;
+        }
+        for (int i = 0; i < nbRects; i++) {
+            // SDL_BlitSurface() changes the destination rect
+            SDL_Rect dst = rects[i];
+            SDL_BlitSurface(p_surface_, &rects[i], p_display_, &dst);
+        }
+    }
+
+    if (setCursor(cursor, &rects[nbRects])) {
+        SDL_Rect src = cursor.rect;
+        SDL_Rect dst;
+        dst.x = cursor.x;
+        dst.y = cursor.y;
+        SDL_BlitSurface(cursor.pSurface, &src, p_display_, &dst);
+        if (!full) {
+            nbRects++;
+        }
+    }
+
+    if (full) {
+        SDL_Flip(p_display_);
+        full_update_ = false;
+    } else {
+        SDL_UpdateRects(p_display_, nbRects, rects);
+    }
+}
+
+/*!
+ * \param scale Size of Screen pixels on the display, from 1 to kMaxScale
+ * \param nbWorkers Number of worker threads, 0 to convert on the main thread
+ */
+ThreadedPresenter::ThreadedPresenter(int scale, int nbWorkers) {
+    scale_ = scale < 1 ? 1 : (scale > kMaxScale ? kMaxScale : scale);
+    nb_workers_ = nbWorkers < 0 ? 0 : (nbWorkers > kMaxWorkers ? kMaxWorkers : nbWorkers);
+    p_row_ = NULL;
+    p_frame_ = NULL;
+    p_kernels_ = NULL;
+    nb_rects_ = 0;
+    full_frame_ = true;
+    cursor_.pSurface = NULL;
+    p_scaled_cursor_ = NULL;
+    p_cursor_source_ = NULL;
+    frame_number_ = 0;
+    busy_ = 0;
+    converted_ = false;
+    stopping_ = false;
+    p_mutex_ = NULL;
+    p_work_cond_ = NULL;
+    p_done_cond_ = NULL;
+    memset(palette_, 0, sizeof(palette_));
+    memset(next_palette_, 0, sizeof(next_palette_));
+}
+
+ThreadedPresenter::~ThreadedPresenter() {
+    if (!workers_.empty()) {
+        SDL_LockMutex(p_mutex_);
+        stopping_ = true;
+        SDL_CondBroadcast(p_work_cond_);
+        SDL_UnlockMutex(p_mutex_);
+        for (size_t i = 0; i < workers_.size(); i++) {
+            SDL_WaitThread(workers_[i].pThread, NULL);
+            delete[] workers_[i].pRow;
+        }
+    }
+
+    if (p_done_cond_) {
+        SDL_DestroyCond(p_done_cond_);
+    }
+    if (p_work_cond_) {
+        SDL_DestroyCond(p_work_cond_);
+    }
+    if (p_mutex_) {
+        SDL_DestroyMutex(p_mutex_);
+    }
+    if (p_scaled_cursor_) {
+        SDL_FreeSurface(p_scaled_cursor_);
+    }
+    delete[] p_row_;
+    delete[] p_frame_;
+}
+
+/*!
+ * The display is always a 32-bit software surface, whatever the given
+ * depth : SDL converts it if the real display is different.
+ * \return False if no such display can be created
+ */
+bool ThreadedPresenter::open(int depth, bool fullscreen) {
+    p_display_ = SDL_SetVideoMode(GAME_SCREEN_WIDTH * scale_, GAME_SCREEN_HEIGHT * scale_,
+        32, SDL_SWSURFACE | (fullscreen ? SDL_FULLSCREEN : 0));
+    if (p_display_ == NULL || p_display_->format->BytesPerPixel != 4
+        || SDL_MUSTLOCK(p_display_)) {
+        return false;
+    }
+
+    p_frame_ = new uint8[GAME_SCREEN_WIDTH * GAME_SCREEN_HEIGHT];
+    memset(p_frame_, 0, GAME_SCREEN_WIDTH * GAME_SCREEN_HEIGHT);
+    p_row_ = new uint32[GAME_SCREEN_WIDTH];
+
+    if (nb_workers_ > 0) {
+        p_mutex_ = SDL_CreateMutex();
+        p_work_cond_ = SDL_CreateCond();
+        p_done_cond_ = SDL_CreateCond();
+    }
+    if (p_mutex_ != NULL && p_work_cond_ != NULL && p_done_cond_ != NULL) {
+        // Workers keep a pointer on their entry so vector must not move
+        workers_.reserve(nb_workers_);
+        for (int i = 0; i < nb_workers_; i++) {
+            Worker worker;
+            worker.pPresenter = this;
+            worker.firstRow = GAME_SCREEN_HEIGHT * i / nb_workers_;
+            worker.lastRow = GAME_SCREEN_HEIGHT * (i + 1) / nb_workers_;
+            worker.lastFrame = frame_number_;
+            worker.pRow = new uint32[GAME_SCREEN_WIDTH];
+            workers_.push_back(worker);
+            workers_[i].pThread = SDL_CreateThread(workerMain, &workers_[i]);
+            if (workers_[i].pThread == NULL) {
+                FSERR(Log::k_FLG_GFX, "ThreadedPresenter", "open",
+                    ("Cannot create display thread : %s\n", SDL_GetError()));
+                delete[] worker.pRow;
+                workers_.pop_back();
+                break;
+            }
+        }
+        if (!workers_.empty() && workers_.size() < (size_t) nb_workers_) {
+            // the last worker takes the rows of missing ones
+            workers_.back().lastRow = GAME_SCREEN_HEIGHT;
+        }
+    }
+
+    return true;
+}
+
+void ThreadedPresenter::setColors(const SDL_Color *colors, int first, int nb) {
+    // workers may be using palette_ : it is updated with the next frame
+    for (int i = 0; i < nb; i++) {
+        next_palette_[first + i] = SDL_MapRGB(p_display_->format,
+            colors[i].r, colors[i].g, colors[i].b);
+    }
+    full_update_ = true;
+}
+
+int ThreadedPresenter::workerMain(void *pData) {
+    Worker *pWorker = static_cast<Worker *>(pData);
+    pWorker->pPresenter->run(pWorker);
+    return 0;
+}
+
+/*!
+ * Main loop of a worker thread.
+ */
+void ThreadedPresenter::run(Worker *pWorker) {
+    SDL_LockMutex(p_mutex_);
+    while (true) {
+        while (pWorker->lastFrame == frame_number_ && !stopping_) {
+            SDL_CondWait(p_work_cond_, p_mutex_);
+        }
+        if (stopping_) {
+            break;
+        }
+        pWorker->lastFrame = frame_number_;
+        SDL_UnlockMutex(p_mutex_);
+
+        convert(pWorker->firstRow, pWorker->lastRow, pWorker->pRow);
+
+        SDL_LockMutex(p_mutex_);
+        busy_--;
+        if (busy_ == 0) {
+            converted_ = true;
+            SDL_CondBroadcast(p_done_cond_);
+        }
+    }
+    SDL_UnlockMutex(p_mutex_);
+}
+
+/*!
+ * Converts the areas of the frame that are in the given rows.
+ * The display surface doesn't need locking so this can be run by the
+ * workers.
+ */
+void ThreadedPresenter::convert(int firstRow, int lastRow, uint32 *pRow) {
+    if (full_frame_) {
+        for (int j = firstRow; j < lastRow; j++) {
+            convertRow(j, 0, GAME_SCREEN_WIDTH, pRow);
+        }
+    } else {
+        for (int i = 0; i < nb_rects_; i++) {
+            const SDL_Rect &r = rects_[i];
+            int y1 = r.y > firstRow ? r.y : firstRow;
+            int y2 = r.y + r.h < lastRow ? r.y + r.h : lastRow;
+            for (int j = y1; j < y2; j++) {
+                convertRow(j, r.x, r.w, pRow);
+            }
+        }
+    }
+}
+
+/*!
+ * Converts pixels of a row of the frame to a square of scale_ rows
+ * on the display.
+ */
+void ThreadedPresenter::convertRow(int y, int x, int width, uint32 *pRow) {
+    uint8 *pixels = (uint8 *) p_display_->pixels;
+    int pitch = p_display_->pitch;
+    const uint8 *src = p_frame_ + y * GAME_SCREEN_WIDTH + x;
+    uint32 *dst = (uint32 *) (pixels + y * scale_ * pitch) + x * scale_;
+
+    if (scale_ == 1) {
+        p_kernels_->expandPalette(dst, src, width, palette_);
+        return;
+    }
+
+    p_kernels_->expandPalette(pRow, src, width, palette_);
+    switch (scale_) {
+    case 2:
+        for (int i = 0; i < width; i++) {
+            dst[2 * i] = dst[2 * i + 1] = pRow[i];
+        }
+        break;
+    default:
+        for (int i = 0; i < width; i++) {
+            for (int k = 0; k < scale_; k++) {
+                dst[i * scale_ + k] = pRow[i];
+            }
+        }
+        break;
+    }
+    for (int k = 1; k < scale_; k++) {
+        memcpy(pixels + (y * scale_ + k) * pitch + x * scale_ * 4, dst,
+               width * scale_ * 4);
+    }
+}
+
+/*!
+ * Returns a copy of the surface where each pixel is a square of
+ * scale pixels.
+ */
+static SDL_Surface *scaleSurface(SDL_Surface *pSource, int scale) {
+    SDL_PixelFormat *fmt = pSource->format;
+    SDL_Surface *pScaled = SDL_CreateRGBSurface(SDL_SWSURFACE,
+        pSource->w * scale, pSource->h * scale, fmt->BitsPerPixel,
+        fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask);
+    if (pScaled == NULL) {
+        return NULL;
+    }
+    if (fmt->palette != NULL) {
+        SDL_SetColors(pScaled, fmt->palette->colors, 0, fmt->palette->ncolors);
+    }
+    if (pSource->flags & SDL_SRCCOLORKEY) {
+        SDL_SetColorKey(pScaled, SDL_SRCCOLORKEY, fmt->colorkey);
+    }
+    if (pSource->flags & SDL_SRCALPHA) {
+        SDL_SetAlpha(pScaled, SDL_SRCALPHA, fmt->alpha);
+    }
+
+    int bpp = fmt->BytesPerPixel;
+    SDL_LockSurface(pSource);
+    SDL_LockSurface(pScaled);
+    for (int j = 0; j < pScaled->h; j++) {
+        const uint8 *src = (const uint8 *) pSource->pixels + (j / scale) * pSource->pitch;
+        uint8 *dst = (uint8 *) pScaled->pixels + j * pScaled->pitch;
+        for (int i = 0; i < pScaled->w; i++) {
+            memcpy(dst + i * bpp, src + (i / scale) * bpp, bpp);
+        }
+    }
+    SDL_UnlockSurface(pScaled);
+    SDL_UnlockSurface(pSource);
+    return pScaled;
+}
+
+/*!
+ * Draws the cursor on the display, scaled like the frame.
+ */
+void ThreadedPresenter::drawCursor() {
+    if (cursor_.pSurface == NULL) {
+        return;
+    }
+
+    SDL_Surface *pCursors = cursor_.pSurface;
+    if (scale_ > 1) {
+        if (p_cursor_source_ != cursor_.pSurface) {
+            if (p_scaled_cursor_) {
+                SDL_FreeSurface(p_scaled_cursor_);
+            }
+            p_scaled_cursor_ = scaleSurface(cursor_.pSurface, scale_);
+            p_cursor_source_ = cursor_.pSurface;
+        }
+        if (p_scaled_cursor_ == NULL) {
+            return;
+        }
+        pCursors = p_scaled_cursor_;
+    }
+
+    SDL_Rect src;
+    src.x = cursor_.rect.x * scale_;
+    src.y = cursor_.rect.y * scale_;
+    src.w = cursor_.rect.w * scale_;
+    src.h = cursor_.rect.h * scale_;
+    SDL_Rect dst;
+    dst.x = cursor_.x * scale_;
+    dst.y = cursor_.y * scale_;
+    SDL_BlitSurface(pCursors, &src, p_display_, &dst);
+}
+
+void ThreadedPresenter::waitWorkers() {
+    if (!workers_.empty()) {
+        SDL_LockMutex(p_mutex_);
+        while (busy_ > 0) {
+            SDL_CondWait(p_done_cond_, p_mutex_);
+        }
+        SDL_UnlockMutex(p_mutex_);
+    }
+}
+
+/*!
+ * Draws the cursor over the last converted frame and sends them to the
+ * display.
+ */
+void ThreadedPresenter::sendConverted() {
+    if (converted_) {
+        drawCursor();
+        if (full_frame_) {
+            SDL_UpdateRect(p_display_, 0, 0, 0, 0);
+        } else {
+            SDL_Rect rects[kMaxRects];
+            for (int i = 0; i < nb_rects_; i++) {
+                rects[i].x = rects_[i].x * scale_;
+                rects[i].y = rects_[i].y * scale_;
+                rects[i].w = rects_[i].w * scale_;
+                rects[i].h = rects_[i].h * scale_;
+            }
+            SDL_UpdateRects(p_display_, nb_rects_, rects);
+        }
+        converted_ = false;
+    }
+}
+
+/*!
+ * The frame given by the previous call is sent, then the new one is
+ * given to the workers.
+ */
+void ThreadedPresenter::present(const CursorImage &cursor, bool cursorChanged) {
+    waitWorkers();
+    sendConverted();
+
+    if (!g_Screen.dirty() && !full_update_ && !cursorNeedsUpdate(cursor, cursorChanged)) {
+        return;
+    }
+
+    // workers are idle : the frame and its parameters can be changed
+    full_frame_ = full_update_;
+    if (full_update_) {
+        memcpy(palette_, next_palette_, sizeof(palette_));
+        full_update_ = false;
+    }
+    nb_rects_ = copyDirtyAreas(p_frame_, GAME_SCREEN_WIDTH, rects_, full_frame_);
+    g_Screen.clearDirty();
+    if (!full_frame_ && addOldCursor(&rects_[nb_rects_])) {
+        nb_rects_++;
+    }
+    cursor_ = cursor;
+    if (setCursor(cursor, &rects_[nb_rects_]) && !full_frame_) {
+        nb_rects_++;
+    }
+    p_kernels_ = g_Screen.blitKernels();
+
+    if (workers_.empty()) {
+        convert(0, GAME_SCREEN_HEIGHT, p_row_);
+        converted_ = true;
+        sendConverted();
+        return;
+    }
+
+    SDL_LockMutex(p_mutex_);
+    frame_number_++;
+    busy_ = workers_.size();
+    SDL_CondBroadcast(p_work_cond_);
+    SDL_UnlockMutex(p_mutex_);
+}
@@ -0,0 +1,197 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef PRESENTER_SDL_H
+#define PRESENTER_SDL_H
+
+#include <vector>
+
+#include <SDL.h>
+
+#include "common.h"
+
+class BlitKernels;
+
+/*!
+ * The mouse cursor drawn over the screen.
+ */
+struct CursorImage {
+    /*! Surface holding all cursors, NULL if the cursor is hidden.*/
+    SDL_Surface *pSurface;
+    /*! Part of the surface for the current cursor.*/
+    SDL_Rect rect;
+    /*! Screen position of the top left corner.*/
+    int x, y;
+};
+
+/*!
+ * Sends the content of the Screen to the display.
+ * Only the areas modified on the Screen and the areas of the cursor are
+ * sent, unless the palette has changed : then the whole screen is sent.
+ */
+class Presenter {
+public:
+    Presenter();
+    virtual ~Presenter() {}
+
+    //! Sets the video mode
+    virtual bool open(int depth, bool fullscreen) = 0;
+    //! Changes colors of the palette
+    virtual void setColors(const SDL_Color *colors, int first, int nb) = 0;
+    //! Sends what changed since last call to the display
+    virtual void present(const CursorImage &cursor, bool cursorChanged) = 0;
+    //! Returns the size of Screen pixels on the display
+    int scale() { return scale_; }
+
+protected:
+    /*! Screen areas plus old and new cursor areas.*/
+    static const int kMaxRects = 34;
+
+    static bool clipToScreen(SDL_Rect *pRect, int x, int y, int width, int height);
+    int copyDirtyAreas(uint8 *pDest, int pitch, SDL_Rect *rects, bool full);
+    bool cursorNeedsUpdate(const CursorImage &cursor, bool cursorChanged);
+    bool addOldCursor(SDL_Rect *pRect);
+    bool setCursor(const CursorImage &cursor, SDL_Rect *pRect);
+
+protected:
+    /*! The video surface.*/
+    SDL_Surface *p_display_;
+    /*! Size of Screen pixels on the display.*/
+    int scale_;
+    /*! True if the whole screen must be sent on next update.*/
+    bool full_update_;
+    /*! True if a cursor was drawn on the last update.*/
+    bool cursor_drawn_;
+    /*! Area of the display where the cursor was drawn.*/
+    SDL_Rect last_cursor_rect_;
+};
+
+/*!
+ * The Screen is copied in an 8-bit surface which is blitted to the
+ * display : SDL converts colors if the display is not 8-bit.
+ * Everything is done by the main thread.
+ */
+class SurfacePresenter : public Presenter {
+public:
+    SurfacePresenter();
+    ~SurfacePresenter();
+
+    bool open(int depth, bool fullscreen);
+    void setColors(const SDL_Color *colors, int first, int nb);
+    void present(const CursorImage &cursor, bool cursorChanged);
+
+protected:
+    /*! 8-bit copy of the Screen with the palette.*/
+    SDL_Surface *p_surface_;
+};
+
+/*!
+ * The display is a 32-bit software surface whose pixels are computed
+ * by worker threads, through a table giving the display color of each
+ * palette index. The display may be bigger than the Screen by an integer
+ * factor : each pixel is then drawn as a square of pixels.
+ * When a frame is presented, the areas of the Screen that changed are
+ * copied in a buffer that the workers convert to the display while the
+ * game goes on with the next frame. Each worker converts a band of rows.
+ * The converted areas are sent to the display at the beginning of the
+ * next call to present(), by the main thread, as SDL video functions
+ * must not be called by other threads.
+ * Without worker, conversion is done by present().
+ */
+class ThreadedPresenter : public Presenter {
+public:
+    /*! Maximum number of worker threads.*/
+    static const int kMaxWorkers = 4;
+    /*! Maximum size of display pixels.*/
+    static const int kMaxScale = 4;
+
+    ThreadedPresenter(int scale, int nbWorkers);
+    ~ThreadedPresenter();
+
+    bool open(int depth, bool fullscreen);
+    void setColors(const SDL_Color *colors, int first, int nb);
+    void present(const CursorImage &cursor, bool cursorChanged);
+
+protected:
+    /*!
+     * A worker thread converting a band of rows of the frame.
+     */
+    struct Worker {
+        ThreadedPresenter *pPresenter;
+        SDL_Thread *pThread;
+        /*! First and last (excluded) rows of the frame converted.*/
+        int firstRow, lastRow;
+        /*! Number of the last frame converted.*/
+        uint32 lastFrame;
+        /*! A row converted before it is scaled.*/
+        uint32 *pRow;
+    };
+
+    static int workerMain(void *pData);
+    void run(Worker *pWorker);
+    void convert(int firstRow, int lastRow, uint32 *pRow);
+    void convertRow(int y, int x, int width, uint32 *pRow);
+    void drawCursor();
+    void waitWorkers();
+    void sendConverted();
+
+protected:
+    /*! Number of workers asked for.*/
+    int nb_workers_;
+    std::vector<Worker> workers_;
+    /*! Row buffer used when there is no worker.*/
+    uint32 *p_row_;
+    /*! Copy of the Screen read by the workers.*/
+    uint8 *p_frame_;
+    /*! Display color of each palette index, used by the workers.*/
+    uint32 palette_[256];
+    /*! Palette set since last frame.*/
+    uint32 next_palette_[256];
+    /*! Inner loop of the conversion.*/
+    const BlitKernels *p_kernels_;
+    /*! Areas of the frame to convert and send.*/
+    SDL_Rect rects_[kMaxRects];
+    int nb_rects_;
+    /*! True if the whole frame must be converted and sent.*/
+    bool full_frame_;
+    /*! The cursor to draw over the frame.*/
+    CursorImage cursor_;
+    /*! Cursors scaled to the size of display pixels.*/
+    SDL_Surface *p_scaled_cursor_;
+    /*! Cursors from which p_scaled_cursor_ was made.*/
+    SDL_Surface *p_cursor_source_;
+    /*! Number of the last frame given to the workers.*/
+    uint32 frame_number_;
+    /*! Number of workers converting the frame.*/
+    int busy_;
+    /*! True when a frame has been converted but not sent.*/
+    bool converted_;
+    /*! True when workers must stop.*/
+    bool stopping_;
+    /*! Protects frame_number_, busy_, converted_ and stopping_.*/
+    SDL_mutex *p_mutex_;
+    /*! Signaled when a frame is given to the workers.*/
+    SDL_cond *p_work_cond_;
+    /*! Signaled when the workers have converted a frame.*/
+    SDL_cond *p_done_cond_;
+};
+
+#endif  // PRESENTER_SDL_H
@@ -0,0 +1,227 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+
+/*
+ * Checks that drawing only what changed gives the same screen as drawing
+ * the whole map.
+ * Each mission is animated with the viewport on the squad leader and
+ * scrolled back and forth at times. On each tick the map renderer draws
+ * the changes over the last frame, then the whole map area is drawn again
+ * and both screens are compared. Any pixel that differs makes the program
+ * fail.
+ */
+
+#include <memory>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "app.h"
+#include "appcontext.h"
+#include "mission.h"
+#include "ped.h"
+#include "core/gamecontroller.h"
+#include "core/gamesession.h"
+#include "gfx/screen.h"
+#include "menus/maprenderer.h"
+#include "menus/squadselection.h"
+
+#ifdef SYSTEM_SDL
+#ifdef _WIN32
+#undef main
+#else
+#include <SDL_main.h>           //This is required on OSX for remapping of main()
+#endif
+#endif
+
+/*! Pixels the viewport moves on a scrolling tick.*/
+const int kScrollStep = 16;
+/*! The viewport scrolls during this many ticks, then stays still as long.*/
+const int kScrollPeriod = 20;
+
+void print_usage() {
+    printf("usage: rendercheck [options...]\n");
+    printf("    -h, --help            display this help and exit.\n");
+    printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
+    printf("    -m, --mission <num>   check only the given mission (block index from 0 to 49).\n");
+    printf("                          by default all missions are checked.\n");
+    printf("    -t, --ticks <num>     number of ticks for each mission (default: 600).\n");
+}
+
+/*!
+ * Returns the number of pixels of the map area that differ.
+ */
+int compareMapArea(const std::vector<uint8> &changes) {
+    int width = g_Screen.gameScreenWidth();
+    const uint8 *pixels = g_Screen.pixels();
+    int count = 0;
+    for (int y = 0; y < Screen::kScreenHeight; y++) {
+        for (int x = Screen::kScreenPanelWidth; x < Screen::kScreenWidth; x++) {
+            if (changes[y * width + x] != pixels[y * width + x]) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/*!
+ * Checks the mission in the given block.
+ * \return Number of ticks where the screens differ, -1 if mission could
+ * not be loaded
+ */
+int checkMission(int blockId, int nbTicks, int step) {
+    if (!g_App.reset()) {
+        return -1;
+    }
+
+    int misId = g_Session.getBlock(blockId).mis_id;
+    srand(0);
+    Mission *pMission = g_gameCtrl.missions().loadMission(misId);
+    if (pMission == NULL) {
+        printf("mission %2d (block %2d) : failed to load\n", misId, blockId);
+        return -1;
+    }
+    g_Session.setSelectedBlockId(blockId);
+    g_Session.setMission(pMission);
+    pMission->start();
+
+    SquadSelection selection;
+    selection.setSquad(pMission->getSquad());
+    MapRenderer renderer;
+    renderer.init(pMission, &selection);
+
+    // same start as GameplayMenu::initWorldCoords() without the borders
+    PedInstance *pLeader = selection.leader();
+    Point2D viewport;
+    pMission->get_map()->tileToScreenPoint(pLeader->tileX(), pLeader->tileY(),
+        pMission->mmax_z_ + 1, 0, 0, &viewport);
+    viewport.x -= (Screen::kScreenWidth - Screen::kScreenPanelWidth) / 2;
+    viewport.y -= Screen::kScreenHeight / 2;
+
+    g_Screen.clear(0);
+    renderer.render(viewport);
+
+    std::vector<uint8> changes(g_Screen.gameScreenWidth() * g_Screen.gameScreenHeight());
+    int badTicks = 0;
+    int firstBad = -1;
+    int maxPixels = 0;
+    for (int tick = 0; tick < nbTicks; tick++) {
+        pMission->animateObjects(step);
+        int phase = tick / kScrollPeriod;
+        if (phase % 2 == 1) {
+            // right, down, left then up
+            viewport.x += phase % 8 == 1 ? kScrollStep : phase % 8 == 5 ? -kScrollStep : 0;
+            viewport.y += phase % 8 == 3 ? kScrollStep : phase % 8 == 7 ? -kScrollStep : 0;
+        }
+
+        renderer.renderChanges(viewport);
+        memcpy(&changes[0], g_Screen.pixels(), changes.size());
+        renderer.render(viewport);
+
+        int nbPixels = compareMapArea(changes);
+        if (nbPixels > 0) {
+            if (firstBad == -1) {
+                firstBad = tick;
+            }
+            if (nbPixels > maxPixels) {
+                maxPixels = nbPixels;
+            }
+            badTicks++;
+        }
+    }
+
+    printf("mission %2d (block %2d) : %d ticks, %d differ", misId, blockId,
+        nbTicks, badTicks);
+    if (badTicks > 0) {
+        printf(" (first at tick %d, up to %d pixels)", firstBad, maxPixels);
+    }
+    printf("\n");
+
+    g_Session.setMission(NULL);
+    return badTicks;
+}
+
+int main(int argc, char *argv[]) {
+    std::string iniPath;
+    int blockId = -1;
+    int nbTicks = 600;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-h", argv[i]) || 0 == strcmp("--help", argv[i])) {
+            print_usage();
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        if (0 == strcmp("-i", argv[i]) || 0 == strcmp("--ini", argv[i])) {
+            iniPath = argv[++i];
+        } else if (0 == strcmp("-m", argv[i]) || 0 == strcmp("--mission", argv[i])) {
+            blockId = atoi(argv[++i]);
+            if (blockId < 0 || blockId >= 50) {
+                print_usage();
+                return 1;
+            }
+        } else if (0 == strcmp("-t", argv[i]) || 0 == strcmp("--ticks", argv[i])) {
+            nbTicks = atoi(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (iniPath.size() == 0) {
+        iniPath.assign(App::defaultIniFolder());
+        iniPath.append("/freesynd.ini");
+    }
+
+    std::auto_ptr<App> app(new App(true));
+    if (!app->initializeHeadless(iniPath)) {
+        printf("Failed to initialize application with %s\n", iniPath.c_str());
+        return 1;
+    }
+
+    int failures = 0;
+    int badMissions = 0;
+    int first = blockId == -1 ? 0 : blockId;
+    int last = blockId == -1 ? 49 : blockId;
+    for (int blk = first; blk <= last; blk++) {
+        int badTicks = checkMission(blk, nbTicks, g_Ctx.tickStep());
+        if (badTicks < 0) {
+            failures++;
+        } else if (badTicks > 0) {
+            badMissions++;
+        }
+    }
+    printf("%d missions checked, %d with differences, %d not loaded\n",
+        last - first + 1 - failures, badMissions, failures);
+
+    app->destroy();
+
+    return failures == 0 && badMissions == 0 ? 0 : 1;
+}
@@ -0,0 +1,443 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+
+/*
+ * Measures the RNC decompressor on the original data files.
+ * Every RNC file of the data directory is unpacked by the bit by bit
+ * decoder freesynd used before and by the current one, with and without
+ * CRC checks. The throughput of each decoder is printed in MB of unpacked
+ * data per second and both decoders must give the same content.
+ */
+
+#include <memory>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "app.h"
+#include "utils/dernc.h"
+#include "utils/file.h"
+
+#ifdef SYSTEM_SDL
+#ifdef _WIN32
+#undef main
+#else
+#include <SDL_main.h>           //This is required on OSX for remapping of main()
+#endif
+#endif
+
+/*!
+ * The decoder freesynd used before the lookup tables : symbols are found
+ * by searching all the codes and bytes are copied one by one.
+ */
+namespace reference {
+
+    struct BitStream {
+        uint32 bit_buffer;
+        int bit_count;
+    };
+
+    struct HuffmanTable {
+        int node_count;
+        struct {
+            uint32 code;
+            int code_length;
+            int value;
+        } table[32];
+    };
+
+    uint32 bitPeek(BitStream &bit_stream, uint32 mask) {
+        return bit_stream.bit_buffer & mask;
+    }
+
+    void bitAdvance(BitStream &bit_stream, int count, uint8 *&packed_data) {
+        bit_stream.bit_buffer >>= count;
+        bit_stream.bit_count -= count;
+        if (bit_stream.bit_count < 16) {
+            packed_data += 2;
+            bit_stream.bit_buffer |=
+                (READ_LE_UINT16(packed_data) << bit_stream.bit_count);
+            bit_stream.bit_count += 16;
+        }
+    }
+
+    void bitAdvance8(BitStream &bit_stream, int count,
+            uint8 *&packed_data, uint8 *packed_data_end) {
+        bit_stream.bit_buffer >>= count;
+        bit_stream.bit_count -= count;
+        if (bit_stream.bit_count < 16) {
+            packed_data += 2;
+            if (packed_data < packed_data_end) {
+                bit_stream.bit_buffer |=
+                    ((uint32)(*packed_data) << bit_stream.bit_count);
+                bit_stream.bit_count += 16;
+            }
+        }
+    }
+
+    uint32 bitRead(BitStream &bit_stream, uint32 mask, int count,
+            uint8 *&packed_data) {
+        uint32 result = bitPeek(bit_stream, mask);
+        bitAdvance(bit_stream, count, packed_data);
+        return result;
+    }
+
+    uint32 bitRead8(BitStream &bit_stream, uint32 mask, int count,
+            uint8 *&packed_data, uint8 *packed_data_end) {
+        uint32 result = bitPeek(bit_stream, mask);
+        bitAdvance8(bit_stream, count, packed_data, packed_data_end);
+        return result;
+    }
+
+    void readHuffmanTable(HuffmanTable &huffman_table,
+            BitStream &bit_stream, uint8 *&packed_data) {
+        int count = bitRead(bit_stream, 0x1f, 5, packed_data);
+        if (!count)
+            return;
+
+        int leaf_max = 1;
+        int leaf_length[32];
+        for (int i = 0; i < count; ++i) {
+            leaf_length[i] = bitRead(bit_stream, 0x0f, 4, packed_data);
+            if (leaf_max < leaf_length[i])
+                leaf_max = leaf_length[i];
+        }
+
+        uint32 code_b = 0;
+        int node_count = 0;
+        for (int i = 1; i <= leaf_max; ++i) {
+            for (int j = 0; j < count; ++j)
+                if (leaf_length[j] == i) {
+                    huffman_table.table[node_count].code = mirror(code_b, i);
+                    huffman_table.table[node_count].code_length = i;
+                    huffman_table.table[node_count].value = j;
+                    ++code_b;
+                    ++node_count;
+                }
+            code_b <<= 1;
+        }
+
+        huffman_table.node_count = node_count;
+    }
+
+    int readHuffmanData(HuffmanTable &huffman_table,
+            BitStream &bit_stream, uint8 *&packed_data,
+            uint8 *packed_data_end) {
+        int i;
+        uint32 mask;
+
+        for (i = 0; i < huffman_table.node_count; ++i) {
+            mask = (1 << huffman_table.table[i].code_length) - 1;
+            if (bitPeek(bit_stream, mask) == huffman_table.table[i].code)
+                break;
+        }
+
+        if (i == huffman_table.node_count)
+            return -1;
+        if ((packed_data + 2) < packed_data_end)
+            bitAdvance(bit_stream, huffman_table.table[i].code_length,
+                   packed_data);
+        else
+            bitAdvance8(bit_stream, huffman_table.table[i].code_length,
+                   packed_data, packed_data_end);
+
+        uint32 result = huffman_table.table[i].value;
+
+        if (result >= 2) {
+            result = 1 << (result - 1);
+            if ((packed_data + 2) < packed_data_end)
+                result |= bitRead(bit_stream, result - 1,
+                        huffman_table.table[i].value - 1, packed_data);
+            else
+                result |= bitRead8(bit_stream, result - 1,
+                        huffman_table.table[i].value - 1, packed_data,
+                        packed_data_end);
+        }
+
+        return result;
+    }
+
+    void bitReadFix(BitStream &bit_stream, uint8 *&packed_data) {
+        bit_stream.bit_count -= 16;
+        bit_stream.bit_buffer &= (1 << bit_stream.bit_count) - 1;
+        bit_stream.bit_buffer |=
+            (READ_LE_UINT16(packed_data) << bit_stream.bit_count);
+        bit_stream.bit_count += 16;
+    }
+
+    void bitReadFix8(BitStream &bit_stream, uint8 *&packed_data) {
+        bit_stream.bit_count -= 16;
+        bit_stream.bit_buffer &= (1 << bit_stream.bit_count) - 1;
+        bit_stream.bit_buffer |=
+            ((uint32)(*packed_data) << bit_stream.bit_count);
+        bit_stream.bit_count += 16;
+    }
+
+    int unpack(uint8 *packed_data, uint8 *unpacked_data) {
+        int output_length = READ_BE_UINT32(packed_data + 4);
+        int input_length = READ_BE_UINT32(packed_data + 8);
+
+        uint16 unpacked_crc = READ_BE_UINT16(packed_data + 12);
+        uint16 packed_crc = READ_BE_UINT16(packed_data + 14);
+
+        uint8 *input = packed_data + 18;
+        uint8 *output = unpacked_data;
+
+        uint8 *input_end = input + input_length;
+        uint8 *output_end = output + output_length;
+
+        if (rnc::crc(input, input_end - input) != packed_crc)
+            return rnc::PACKED_CRC_ERROR;
+
+        BitStream bit_stream;
+        bit_stream.bit_buffer = READ_LE_UINT16(input);
+        bit_stream.bit_count = 16;
+        bitAdvance(bit_stream, 2, input);
+
+        HuffmanTable raw_huff_tbl, dist_huff_tbl, len_huff_tbl;
+        int length, position;
+        uint32 ch_count;
+        while (output < output_end) {
+            readHuffmanTable(raw_huff_tbl, bit_stream, input);
+            readHuffmanTable(dist_huff_tbl, bit_stream, input);
+            readHuffmanTable(len_huff_tbl, bit_stream, input);
+
+            ch_count = bitRead(bit_stream, 0xffff, 16, input);
+
+            while (1) {
+                length = readHuffmanData(raw_huff_tbl, bit_stream, input,
+                    input_end);
+                if (length == -1)
+                    return rnc::HUF_DECODE_ERROR;
+
+                if (length) {
+                    while (length--)
+                        *output++ = *input++;
+                    if ((input + 1) < input_end)
+                        bitReadFix(bit_stream, input);
+                    else
+                        bitReadFix8(bit_stream, input);
+                }
+
+                if (--ch_count <= 0)
+                    break;
+
+                position = readHuffmanData(dist_huff_tbl, bit_stream, input,
+                    input_end);
+                if (position == -1)
+                    return rnc::HUF_DECODE_ERROR;
+
+                length = readHuffmanData(len_huff_tbl, bit_stream, input,
+                    input_end);
+                if (length == -1)
+                    return rnc::HUF_DECODE_ERROR;
+
+                position += 1;
+                length += 2;
+
+                while (length--) {
+                    *output = output[-position];
+                    output++;
+                }
+            }
+        }
+
+        if (output != output_end)
+            return rnc::FILE_SIZE_MISMATCH;
+
+        if (rnc::crc(output_end - output_length, output_length) != unpacked_crc)
+            return rnc::UNPACKED_CRC_ERROR;
+
+        return output_length;
+    }
+}
+
+/*!
+ * A compressed file of the data directory.
+ */
+struct PackedFile {
+    std::string name;
+    std::vector<uint8> data;
+    int unpackedLength;
+};
+
+/*!
+ * The decoder measured.
+ */
+enum Decoder {
+    kDecoderReference,
+    kDecoderCurrent,
+    kDecoderCurrentNoCRC
+};
+
+void print_usage() {
+    printf("usage: rncbench [options...]\n");
+    printf("    -h, --help            display this help and exit.\n");
+    printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
+    printf("    -p, --passes <num>    number of passes for each measure (default: 10).\n");
+}
+
+/*!
+ * Reads all RNC files of the given directory.
+ */
+void loadPackedFiles(const std::string &dir, std::vector<PackedFile> &files) {
+    std::vector<std::string> names;
+    File::listFiles(dir, "", names);
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i][0] == '.') {
+            continue;
+        }
+        FILE *fp = fopen((dir + names[i]).c_str(), "rb");
+        if (fp == NULL) {
+            continue;
+        }
+        uint8 header[18];
+        if (fread(header, 1, sizeof(header), fp) == sizeof(header)
+            && READ_BE_UINT32(header) == RNC_SIGNATURE) {
+            PackedFile file;
+            file.name = names[i];
+            file.unpackedLength = READ_BE_UINT32(header + 4);
+            int packedLength = READ_BE_UINT32(header + 8);
+            file.data.resize(sizeof(header) + packedLength + 2);
+            memcpy(&file.data[0], header, sizeof(header));
+            if (fread(&file.data[sizeof(header)], 1, packedLength, fp)
+                == (size_t) packedLength) {
+                files.push_back(file);
+            }
+        }
+        fclose(fp);
+    }
+}
+
+/*!
+ * Unpacks all files nbPasses times.
+ * \return Number of bytes unpacked per second in MB
+ */
+double runPasses(std::vector<PackedFile> &files, Decoder decoder, int nbPasses,
+        std::vector<std::vector<uint8> > &outputs) {
+    double total = 0;
+    clock_t start = clock();
+    for (int pass = 0; pass < nbPasses; pass++) {
+        for (size_t i = 0; i < files.size(); i++) {
+            uint8 *pOutput = &outputs[i][0];
+            int result;
+            if (decoder == kDecoderReference) {
+                result = reference::unpack(&files[i].data[0], pOutput);
+            } else {
+                result = rnc::unpack(&files[i].data[0], pOutput,
+                    decoder == kDecoderCurrent);
+            }
+            if (result != files[i].unpackedLength) {
+                printf("%s : %s\n", files[i].name.c_str(), rnc::errorString(result));
+            }
+            total += files[i].unpackedLength;
+        }
+    }
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    return seconds > 0 ? total / (1024 * 1024) / seconds : 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::string iniPath;
+    int nbPasses = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-h", argv[i]) || 0 == strcmp("--help", argv[i])) {
+            print_usage();
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        if (0 == strcmp("-i", argv[i]) || 0 == strcmp("--ini", argv[i])) {
+            iniPath = argv[++i];
+        } else if (0 == strcmp("-p", argv[i]) || 0 == strcmp("--passes", argv[i])) {
+            nbPasses = atoi(argv[++i]);
+            if (nbPasses <= 0) {
+                print_usage();
+                return 1;
+            }
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (iniPath.size() == 0) {
+        iniPath.assign(App::defaultIniFolder());
+        iniPath.append("/freesynd.ini");
+    }
+
+    std::auto_ptr<App> app(new App(true));
+    if (!app->initializeHeadless(iniPath)) {
+        printf("Failed to initialize application with %s\n", iniPath.c_str());
+        return 1;
+    }
+
+    std::vector<PackedFile> files;
+    loadPackedFiles(File::originalDataFullPath("", false), files);
+    if (files.empty()) {
+        printf("No RNC file found in %s\n",
+            File::originalDataFullPath("", false).c_str());
+        app->destroy();
+        return 1;
+    }
+
+    double packed = 0, unpacked = 0;
+    std::vector<std::vector<uint8> > reference(files.size());
+    std::vector<std::vector<uint8> > current(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        packed += files[i].data.size();
+        unpacked += files[i].unpackedLength;
+        reference[i].resize(files[i].unpackedLength + 1);
+        current[i].resize(files[i].unpackedLength + 1);
+    }
+    printf("%d RNC files, %.2f MB packed, %.2f MB unpacked, %d passes\n",
+        (int) files.size(), packed / (1024 * 1024), unpacked / (1024 * 1024),
+        nbPasses);
+
+    printf("%-20s %9.2f MB/s\n", "reference",
+        runPasses(files, kDecoderReference, nbPasses, reference));
+    printf("%-20s %9.2f MB/s\n", "lookup tables",
+        runPasses(files, kDecoderCurrent, nbPasses, current));
+    printf("%-20s %9.2f MB/s\n", "lookup tables no CRC",
+        runPasses(files, kDecoderCurrentNoCRC, nbPasses, current));
+
+    int nbDiffs = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (memcmp(&reference[i][0], &current[i][0], files[i].unpackedLength) != 0) {
+            printf("%s : content differs\n", files[i].name.c_str());
+            nbDiffs++;
+        }
+    }
+    printf("%s\n", nbDiffs == 0 ? "same content for all files" : "decoders differ");
+
+    app->destroy();
+
+    return nbDiffs == 0 ? 0 : 1;
+}
@@ -27,7 +27,6 @@
 #include "config.h"
 #include "audio.h"
 #include "musicmanager.h"
-#include "xmidi.h"
 #include "utils/file.h"
 #include "utils/log.h"
 
@@ -47,47 +46,77 @@ MusicManager::~MusicManager()
 }
 
 void MusicManager::loadMusic()
+{
+    convertMusic();
+    createTracks();
+}
+
+/*!
+ * Only converts the original files : the tracks are created by
+ * createTracks(). So this can be run by another thread than the one
+ * playing the music.
+ */
+bool MusicManager::convertMusic()
 {
     // If audio has not been initialized -> do nothing
     if (!Audio::isInitialized()) {
-        return;
+        return true;
     }
 
     XMidi xmidi;
-    std::vector < XMidi::Midi > tracks;
     int size;
     uint8 *data;
 
+#if !USE_INTRO_OGG
+    data = File::loadOriginalFile("INTRO.XMI", size);
+    intro_midi_ = xmidi.convertXMidi(data, size);
+    delete[] data;
+#endif
+
+    data = File::loadOriginalFile("SYNGAME.XMI", size);
+    game_midi_ = xmidi.convertXMidi(data, size);
+    delete[] data;
+    return true;
+}
+
+/*!
+ * Must be called by the thread playing the music.
+ */
+bool MusicManager::createTracks()
+{
+    if (!Audio::isInitialized()) {
+        return true;
+    }
+
 #if USE_INTRO_OGG
     tracks_.push_back(new Music);
     tracks_.back()->loadMusicFile("music/intro.ogg");
 #else
-    data = File::loadOriginalFile("INTRO.XMI", size);
-    tracks = xmidi.convertXMidi(data, size);
-    for (unsigned int i = 0; i < tracks.size(); ++i) {
+    for (unsigned int i = 0; i < intro_midi_.size(); ++i) {
         tracks_.push_back(new Music);
-        tracks_.back()->loadMusic(tracks[i].data_, tracks[i].size_);
+        tracks_.back()->loadMusic(intro_midi_[i].data_, intro_midi_[i].size_);
     }
-    delete[] data;
 #endif
 
-    data = File::loadOriginalFile("SYNGAME.XMI", size);
-    tracks = xmidi.convertXMidi(data, size);
-    for (unsigned int i = 0; i < tracks.size(); ++i) {
+    for (unsigned int i = 0; i < game_midi_.size(); ++i) {
         if (i == 0) {
 #if USE_ASSASSINATE_OGG
             tracks_.push_back(new Music);
             tracks_.back()->loadMusicFile("music/assassinate.ogg");
 #else
             tracks_.push_back(new Music);
-            tracks_.back()->loadMusic(tracks[i].data_, tracks[i].size_);
+            tracks_.back()->loadMusic(game_midi_[i].data_, game_midi_[i].size_);
 #endif
         } else {
             tracks_.push_back(new Music);
-            tracks_.back()->loadMusic(tracks[i].data_, tracks[i].size_);
+            tracks_.back()->loadMusic(game_midi_[i].data_, game_midi_[i].size_);
         }
     }
-    delete[] data;
+
+    // tracks keep pointers on the MIDI data
+    intro_midi_.clear();
+    game_midi_.clear();
+    return true;
 }
 
 void MusicManager::playTrack(msc::MusicTrack track, int loops)
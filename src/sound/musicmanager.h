@@ -29,6 +29,7 @@
 
 #include "common.h"
 #include "music.h"
+#include "xmidi.h"
 
 #include <vector>
 
@@ -41,6 +42,10 @@ public:
     ~MusicManager();
 
     void loadMusic();
+    //! Converts the original music files, without using the audio device
+    bool convertMusic();
+    //! Creates the tracks from the converted music
+    bool createTracks();
     void playTrack(msc::MusicTrack track, int loops = -1);
     void stopPlayback();
     //! Sets the music volume to the given level
@@ -52,6 +57,8 @@ public:
 
 protected:
     std::vector<Music *> tracks_;
+    /*! MIDI tracks converted but not yet turned into music.*/
+    std::vector<XMidi::Midi> intro_midi_, game_midi_;
     msc::MusicTrack current_track_;
     bool is_playing_;
     /*! 
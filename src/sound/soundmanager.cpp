@@ -51,46 +51,41 @@ Sound *SoundManager::sound(snd::InGameSample sample)
 }
 
 
+/*!
+ * Reads the samples and creates the sounds.
+ * \param set The set of samples to load
+ * \return False if samples could not be read
+ */
 bool SoundManager::loadSounds(SampleSet set)
 {
-    int tabSize, size;
-    uint8 *tabData, *data;
+    if (!readSounds(set)) {
+        return false;
+    }
+    return createSounds();
+}
+
+/*!
+ * Only reads the original files : the sounds are created by createSounds().
+ * So this can be run by another thread than the one using the sounds.
+ * \param set The set of samples to read
+ * \return False if samples could not be read
+ */
+bool SoundManager::readSounds(SampleSet set)
+{
     switch (set) {
     case SAMPLES_INTRO:
-        {
-            tabData = File::loadOriginalFile("ISNDS-0.TAB", tabSize);
-            data = File::loadOriginalFile("ISNDS-0.DAT", size);
-            bool loaded = loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-            if (!loaded) {
-                printf("Error : Could not load sounds from file ISNDS-0.DAT\n");
-                return false;
-            }
-            tabData = File::loadOriginalFile("ISNDS-1.TAB", tabSize);
-            data = File::loadOriginalFile("ISNDS-1.DAT", size);
-            loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-            if (!loaded) {
-                printf("Error : Could not load sounds from file ISNDS-1.DAT\n");
-                return false;
-            }
+        if (!readSounds("ISNDS-0.TAB", "ISNDS-0.DAT")) {
+            printf("Error : Could not load sounds from file ISNDS-0.DAT\n");
+            return false;
+        }
+        if (!readSounds("ISNDS-1.TAB", "ISNDS-1.DAT")) {
+            printf("Error : Could not load sounds from file ISNDS-1.DAT\n");
+            return false;
         }
         break;
     case SAMPLES_GAME:
-        {
-            tabData = File::loadOriginalFile("SOUND-0.TAB", tabSize);
-            data = File::loadOriginalFile("SOUND-0.DAT", size);
-            loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-            tabData = File::loadOriginalFile("SOUND-1.TAB", tabSize);
-            data = File::loadOriginalFile("SOUND-1.DAT", size);
-            loadSounds(tabData, tabSize, data);
-            delete[] tabData;
-            delete[] data;
-        }
+        readSounds("SOUND-0.TAB", "SOUND-0.DAT");
+        readSounds("SOUND-1.TAB", "SOUND-1.DAT");
         break;
     default:
         break;
@@ -99,42 +94,59 @@ bool SoundManager::loadSounds(SampleSet set)
     return true;
 }
 
-bool SoundManager::loadSounds(uint8 * tabData, int tabSize,
-                              uint8 * soundData)
+bool SoundManager::readSounds(const char *tabName, const char *datName)
 {
+    int tabSize, size;
+    uint8 *tabData = File::loadOriginalFile(tabName, tabSize);
+    uint8 *soundData = File::loadOriginalFile(datName, size);
     if (!tabData || !soundData) {
+        delete[] tabData;
+        delete[] soundData;
         return false;
     }
-    
-    tabData += tabentry_startoffset_;
-    uint32 offset = 0;
+
+    uint8 *tabEntry = tabData + tabentry_startoffset_;
+    uint8 *sample = soundData;
 
     for (int i = 0; i < tabSize - tabentry_offset_;
         i += tabentry_offset_)
     {
-        uint32 soundsize = READ_LE_UINT32(tabData);
+        uint32 soundsize = READ_LE_UINT32(tabEntry);
 
         // Samples with size < 144 are bogus
         if (soundsize > 144) {
-            sounds_.push_back(new Sound);
-            uint8 *sample = new uint8[soundsize];
-            memcpy(sample, soundData, soundsize);
-            //printf("sample rate %x\n", sample[0x1e]);
+            samples_.push_back(std::vector<uint8>(sample, sample + soundsize));
+            std::vector<uint8> &data = samples_.back();
             // patching wrong sample rate
-            if (sounds_.size() == 13)
-                sample[0x1e] = 0x9c;
-            else if (sounds_.size() == 24)
-                sample[0x1e] = 0x9c;
-            else if (sounds_.size() == 25)
-                sample[0x1e] = 0x38;
-            sounds_.back()->loadSound(sample, soundsize);
-            delete []sample;
+            size_t num = sounds_.size() + samples_.size();
+            //printf("sample rate %x\n", data[0x1e]);
+            if (num == 13)
+                data[0x1e] = 0x9c;
+            else if (num == 24)
+                data[0x1e] = 0x9c;
+            else if (num == 25)
+                data[0x1e] = 0x38;
         }
-        soundData += soundsize;
-        offset += soundsize;
+        sample += soundsize;
 
-        tabData += tabentry_offset_;
+        tabEntry += tabentry_offset_;
+    }
+
+    delete[] tabData;
+    delete[] soundData;
+    return true;
+}
+
+/*!
+ * Must be called by the thread using the sounds.
+ */
+bool SoundManager::createSounds()
+{
+    for (size_t i = 0; i < samples_.size(); i++) {
+        sounds_.push_back(new Sound);
+        sounds_.back()->loadSound(&samples_[i][0], samples_[i].size());
     }
+    samples_.clear();
     return true;
 }
 
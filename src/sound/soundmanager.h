@@ -46,6 +46,10 @@ public:
     ~SoundManager();
 
     bool loadSounds(SampleSet set);
+    //! Reads the samples of the set, without using the audio device
+    bool readSounds(SampleSet set);
+    //! Creates the sounds from the samples read
+    bool createSounds();
 
     //! Plays the sound a number a time on the given channel
     void play(snd::InGameSample sample, int channel = 0, int loops = 0);
@@ -61,11 +65,13 @@ public:
 
 protected:
     Sound *sound(snd::InGameSample sample);
-    bool loadSounds(uint8 *tabData, int tabSize, uint8 *soundData);
+    bool readSounds(const char *tabName, const char *datName);
 
     const int tabentry_startoffset_;
     const int tabentry_offset_;
     std::vector<Sound *> sounds_;
+    /*! Samples read but not yet turned into sounds.*/
+    std::vector<std::vector<uint8> > samples_;
     /*! 
      * Saves the volume level before a mute so
      * we can restore it after a unmute.
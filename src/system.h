@@ -80,7 +80,7 @@ union FS_Event {
  */
 struct System : public Singleton<System> {
     virtual ~System() {}
-    virtual bool initialize(bool fullscreen) = 0;
+    virtual bool initialize(bool fullscreen, bool presentThread, int scale) = 0;
     virtual void updateScreen() = 0;
     //! Pumps an event from the event queue
     virtual bool pumpEvents(FS_Event *pEvtOut) = 0;
@@ -26,6 +26,7 @@
 #include "config.h"
 #include "gfx/screen.h"
 #include "system.h"
+#include "presenter_sdl.h"
 #include "sound/audio.h"
 #include "utils/file.h"
 #include "utils/log.h"
@@ -38,16 +39,15 @@ const int SystemSDL::CURSOR_WIDTH = 24;
 
 SystemSDL::SystemSDL(int depth) {
     depth_ = depth;
+    scale_ = 1;
     keyModState_ = 0;
-    screen_surf_ = NULL;
-    temp_surf_ = NULL;
+    p_presenter_ = NULL;
     cursor_surf_ = NULL;
 }
 
 SystemSDL::~SystemSDL() {
-    if (temp_surf_) {
-        SDL_FreeSurface(temp_surf_);
-    }
+    // stops the display thread before SDL is closed
+    delete p_presenter_;
 
     if (cursor_surf_) {
         SDL_FreeSurface(cursor_surf_);
@@ -63,7 +63,12 @@ SystemSDL::~SystemSDL() {
     SDL_Quit();
 }
 
-bool SystemSDL::initialize(bool fullscreen) {
+/*!
+ * \param fullscreen True to run in fullscreen
+ * \param presentThread True to convert frames to the display in a thread
+ * \param scale Size of the game pixels on the display
+ */
+bool SystemSDL::initialize(bool fullscreen, bool presentThread, int scale) {
     if (SDL_Init(SDL_INIT_VIDEO
 #ifdef GP2X
                  | SDL_INIT_JOYSTICK
@@ -94,22 +99,25 @@ bool SystemSDL::initialize(bool fullscreen) {
         LOG(Log::k_FLG_SND, "SystemSDL", "Init", ("Couldn't initialize Sound System : no sound will be played."))
     }
 
-    // TODO(nobody): maybe use double buffering?
-#ifdef GP2X
-    screen_surf_ = SDL_SetVideoMode(320, 240, 16, SDL_SWSURFACE);
-    temp_surf_ =
-        SDL_CreateRGBSurface(SDL_SWSURFACE, 320, 240, 8, 0, 0, 0, 0);
-#else
-    screen_surf_ =
-        SDL_SetVideoMode(GAME_SCREEN_WIDTH, GAME_SCREEN_HEIGHT, depth_,
-                         SDL_DOUBLEBUF | SDL_HWSURFACE | (fullscreen ?
-                                                          SDL_FULLSCREEN :
-                                                          0));
-    temp_surf_ =
-        SDL_CreateRGBSurface(SDL_SWSURFACE, GAME_SCREEN_WIDTH,
-                             GAME_SCREEN_HEIGHT, 8, 0, 0, 0, 0);
-
+#ifndef GP2X
+    if (presentThread || scale > 1) {
+        // bigger displays are shared by more threads
+        p_presenter_ = new ThreadedPresenter(scale, presentThread ? scale : 0);
+        if (!p_presenter_->open(depth_, fullscreen)) {
+            LOG(Log::k_FLG_GFX, "SystemSDL", "Init", ("No 32-bit display : frames are converted by the main thread, without scaling."))
+            delete p_presenter_;
+            p_presenter_ = NULL;
+        }
+    }
 #endif
+    if (p_presenter_ == NULL) {
+        p_presenter_ = new SurfacePresenter();
+        if (!p_presenter_->open(depth_, fullscreen)) {
+            printf("Critical error, cannot set video mode : %s\n", SDL_GetError());
+            return false;
+        }
+    }
+    scale_ = p_presenter_->scale();
 
     cursor_surf_ = NULL;
     // Init SDL_Image library
@@ -132,39 +140,15 @@ bool SystemSDL::initialize(bool fullscreen) {
 }
 
 void SystemSDL::updateScreen() {
-    if (g_Screen.dirty()|| (cursor_visible_ && update_cursor_)) {
-        SDL_LockSurface(temp_surf_);
-#ifdef GP2X
-        const uint8 *pixeldata = g_Screen.pixels();
-        uint8 *screen = (uint8 *) temp_surf_->pixels;
-        for (int j = 0; j < 240; j++)
-            for (int i = 0; i < 320; i++) {
-                int tx = i * GAME_SCREEN_WIDTH / 320;
-                int ty = j * GAME_SCREEN_HEIGHT / 240;
-
-                uint8 c = pixeldata[ty * GAME_SCREEN_WIDTH + tx];
-                screen[j * 320 + i] = c;
-            }
-#else
-        memcpy(temp_surf_->pixels, g_Screen.pixels(),
-               GAME_SCREEN_WIDTH * GAME_SCREEN_HEIGHT);
-#endif
-        SDL_UnlockSurface(temp_surf_);
-
-        g_Screen.clearDirty();
-
-        SDL_BlitSurface(temp_surf_, NULL, screen_surf_, NULL);
-
-        if (cursor_visible_) {
-            SDL_Rect dst;
-
-            dst.x = cursor_x_ - cursor_hs_x_;
-            dst.y = cursor_y_ - cursor_hs_y_;
-            SDL_BlitSurface(cursor_surf_, &cursor_rect_, screen_surf_, &dst);
-            update_cursor_ = false;
-        }
-
-        SDL_Flip(screen_surf_);
+    CursorImage cursor;
+    cursor.pSurface = cursor_visible_ ? cursor_surf_ : NULL;
+    cursor.rect = cursor_rect_;
+    cursor.x = cursor_x_ - cursor_hs_x_;
+    cursor.y = cursor_y_ - cursor_hs_y_;
+
+    p_presenter_->present(cursor, update_cursor_);
+    if (cursor_visible_) {
+        update_cursor_ = false;
     }
 }
 
@@ -313,23 +297,23 @@ bool SystemSDL::pumpEvents(FS_Event *pEvtOut) {
             break;
         case SDL_MOUSEBUTTONUP:
             pEvtOut->button.type = EVT_MSE_UP;
-            pEvtOut->button.x = evtIn.button.x;
-            pEvtOut->button.y = cursor_y_ = evtIn.button.y;
+            pEvtOut->button.x = evtIn.button.x / scale_;
+            pEvtOut->button.y = cursor_y_ = evtIn.button.y / scale_;
             pEvtOut->button.button = evtIn.button.button;
             pEvtOut->button.keyMods = keyModState_;
             break;
         case SDL_MOUSEBUTTONDOWN:
             pEvtOut->button.type = EVT_MSE_DOWN;
-            pEvtOut->button.x = evtIn.button.x;
-            pEvtOut->button.y = cursor_y_ = evtIn.button.y;
+            pEvtOut->button.x = evtIn.button.x / scale_;
+            pEvtOut->button.y = cursor_y_ = evtIn.button.y / scale_;
             pEvtOut->button.button = evtIn.button.button;
             pEvtOut->button.keyMods = keyModState_;
             break;
         case SDL_MOUSEMOTION:
             update_cursor_ = true;
             pEvtOut->motion.type = EVT_MSE_MOTION;
-            pEvtOut->motion.x = cursor_x_ = evtIn.motion.x;
-            pEvtOut->motion.y = cursor_y_ = evtIn.motion.y;
+            pEvtOut->motion.x = cursor_x_ = evtIn.motion.x / scale_;
+            pEvtOut->motion.y = cursor_y_ = evtIn.motion.y / scale_;
             pEvtOut->motion.state = evtIn.motion.state;
             pEvtOut->motion.keyMods = keyModState_;
             break;
@@ -374,7 +358,7 @@ void SystemSDL::setPalette6b3(const uint8 * pal, int cols) {
 #endif
     }
 
-    SDL_SetColors(temp_surf_, palette, 0, cols);
+    p_presenter_->setColors(palette, 0, cols);
 }
 
 void SystemSDL::setPalette8b3(const uint8 * pal, int cols) {
@@ -386,7 +370,7 @@ void SystemSDL::setPalette8b3(const uint8 * pal, int cols) {
         palette[i].b = pal[i * 3 + 2];
     }
 
-    SDL_SetColors(temp_surf_, palette, 0, cols);
+    p_presenter_->setColors(palette, 0, cols);
 }
 
 void SystemSDL::setColor(uint8 index, uint8 r, uint8 g, uint8 b) {
@@ -396,7 +380,7 @@ void SystemSDL::setColor(uint8 index, uint8 r, uint8 g, uint8 b) {
     color.g = g;
     color.b = b;
 
-    SDL_SetColors(temp_surf_, &color, index, 1);
+    p_presenter_->setColors(&color, index, 1);
 }
 
 /*!
@@ -426,7 +410,10 @@ bool SystemSDL::loadCursorSprites() {
  * \return See SDL_GetMouseState.
  */
 int SystemSDL::getMousePos(int *x, int *y) {
-    return SDL_GetMouseState(x, y);
+    int state = SDL_GetMouseState(x, y);
+    *x /= scale_;
+    *y /= scale_;
+    return state;
 }
 
 void SystemSDL::hideCursor() {
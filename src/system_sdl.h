@@ -30,6 +30,8 @@
 
 #include "keys.h"
 
+class Presenter;
+
 //! Implementation of the System interface for SDL.
 /*!
  * This class implements the System interface based on the SDL library.
@@ -47,7 +49,7 @@ public:
     SystemSDL(int depth = 32);
     ~SystemSDL();
 
-    bool initialize(bool fullscreen);
+    bool initialize(bool fullscreen, bool presentThread, int scale);
 
     void updateScreen();
     //! Pumps an event from the event queue
@@ -85,7 +87,8 @@ protected:
     /*! A constant that holds the cursor icon width and height.*/
     static const int CURSOR_WIDTH;
     int depth_;
-    bool scale_;
+    /*! Size of the game pixels on the display.*/
+    int scale_;
     /*! Cursor visibility.*/
     bool cursor_visible_;
     /*! Cursor screen coordinates. */
@@ -97,8 +100,8 @@ protected:
     /*! Current cursor hotspot.*/
     int cursor_hs_y_;
 
-    SDL_Surface *screen_surf_;
-    SDL_Surface *temp_surf_;
+    /*! Sends the screen to the display.*/
+    Presenter *p_presenter_;
     /*! 
      * A surface that holds all cursors
      * images.
@@ -0,0 +1,286 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "utils/assetcache.h"
+#include "utils/ccrc32.h"
+#include "utils/file.h"
+#include "utils/log.h"
+
+bool AssetCache::enabled_ = true;
+
+static const char kMagic[4] = { 'F', 'S', 'A', 'C' };
+
+/*!
+ * \param payload Data being built
+ * \param data Bytes to add
+ * \param size Number of bytes to add
+ * \return Offset of the bytes in the payload
+ */
+uint32 AssetCache::append(std::vector<uint8> &payload, const void *data, size_t size) {
+    payload.resize((payload.size() + 3) & ~3, 0);
+    uint32 offset = payload.size();
+    const uint8 *bytes = static_cast<const uint8 *>(data);
+    payload.insert(payload.end(), bytes, bytes + size);
+    return offset;
+}
+
+AssetCache::AssetCache() {
+    crc_ = 0xFFFFFFFF;
+    p_map_ = NULL;
+    map_size_ = 0;
+    p_data_ = NULL;
+    data_size_ = 0;
+#ifdef _WIN32
+    h_file_ = NULL;
+    h_mapping_ = NULL;
+#endif
+}
+
+AssetCache::~AssetCache() {
+    reset();
+}
+
+void AssetCache::reset() {
+    close();
+    releaseSources();
+    source_sizes_.clear();
+    source_names_.clear();
+    sources_.clear();
+    crc_ = 0xFFFFFFFF;
+}
+
+std::string AssetCache::pathOf(const std::string &name) {
+    return File::homeFullPath(name + ".fsc");
+}
+
+/*!
+ * Sources must be added in the same order each time.
+ * \param filename Name of the original file
+ * \return False if file could not be read
+ */
+bool AssetCache::addSource(const std::string &filename) {
+    int size = 0;
+    uint8 *data = File::loadOriginalFileToMem(filename, size);
+    if (data == NULL) {
+        return false;
+    }
+
+    CCRC32 crc32;
+    crc32.PartialCRC(&crc_, reinterpret_cast<const unsigned char *>(&size), sizeof(size));
+    crc32.PartialCRC(&crc_, data, size);
+    sources_.push_back(data);
+    source_sizes_.push_back(size);
+    source_names_.push_back(filename);
+    return true;
+}
+
+/*!
+ * If the content of the source was released, the file is read again.
+ * \param index Index of the source, in the order they were added
+ * \param size Size of the returned buffer
+ * \return A buffer the caller must delete or NULL
+ */
+uint8 *AssetCache::unpackSource(size_t index, int &size) {
+    size = 0;
+    if (index >= source_names_.size()) {
+        return NULL;
+    }
+    if (sources_[index] == NULL) {
+        return File::loadOriginalFile(source_names_[index], size);
+    }
+
+    uint8 *data = sources_[index];
+    sources_[index] = NULL;
+    size = source_sizes_[index];
+    return File::unpackOriginalFile(source_names_[index], data, size);
+}
+
+/*!
+ * Sources are still known and their CRC is kept to write the cache.
+ */
+void AssetCache::releaseSources() {
+    for (size_t i = 0; i < sources_.size(); i++) {
+        delete[] sources_[i];
+        sources_[i] = NULL;
+    }
+}
+
+/*!
+ * When the file is mapped, sources are released.
+ * \param name Name of the cache, without directory nor extension
+ * \return False if the file is missing or out of date
+ */
+bool AssetCache::open(const std::string &name) {
+    close();
+    if (!enabled_ || source_names_.empty()) {
+        return false;
+    }
+
+    std::string path = pathOf(name);
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD size = GetFileSize(hFile, NULL);
+    HANDLE hMapping = NULL;
+    void *pMap = NULL;
+    if (size != INVALID_FILE_SIZE && size > 0) {
+        hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    if (hMapping != NULL) {
+        pMap = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (pMap == NULL) {
+        if (hMapping != NULL) {
+            CloseHandle(hMapping);
+        }
+        CloseHandle(hFile);
+        return false;
+    }
+    h_file_ = hFile;
+    h_mapping_ = hMapping;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    size_t size = 0;
+    void *pMap = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = st.st_size;
+        pMap = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // the mapping stays valid once the file is closed
+    ::close(fd);
+    if (pMap == MAP_FAILED) {
+        return false;
+    }
+#endif
+    p_map_ = static_cast<uint8 *>(pMap);
+    map_size_ = size;
+
+    const Header *pHeader = reinterpret_cast<const Header *>(p_map_);
+    if (map_size_ < sizeof(Header) || memcmp(pHeader->magic, kMagic, sizeof(kMagic)) != 0
+        || pHeader->version != kVersion || pHeader->crc != (crc_ ^ 0xFFFFFFFF)
+        || pHeader->size != map_size_ - sizeof(Header)) {
+        LOG(Log::k_FLG_IO, "AssetCache", "open", ("Cache %s is out of date", path.c_str()));
+        close();
+        return false;
+    }
+
+    p_data_ = p_map_ + sizeof(Header);
+    data_size_ = pHeader->size;
+    releaseSources();
+    LOG(Log::k_FLG_IO, "AssetCache", "open", ("Using cache %s", path.c_str()));
+    return true;
+}
+
+void AssetCache::close() {
+    if (p_map_ == NULL) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(p_map_);
+    CloseHandle(h_mapping_);
+    CloseHandle(h_file_);
+    h_mapping_ = NULL;
+    h_file_ = NULL;
+#else
+    munmap(p_map_, map_size_);
+#endif
+    p_map_ = NULL;
+    map_size_ = 0;
+    p_data_ = NULL;
+    data_size_ = 0;
+}
+
+/*!
+ * The file is written under a temporary name then renamed so that a
+ * partly written file is never used.
+ * \param name Name of the cache, without directory nor extension
+ * \param payload Data built from the sources
+ * \return False if file could not be written
+ */
+bool AssetCache::write(const std::string &name, const std::vector<uint8> &payload) {
+    if (!enabled_) {
+        return false;
+    }
+
+    std::string path = pathOf(name);
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (fp == NULL) {
+        FSERR(Log::k_FLG_IO, "AssetCache", "write", ("Cannot create cache %s\n", tmpPath.c_str()));
+        return false;
+    }
+
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.crc = crc_ ^ 0xFFFFFFFF;
+    header.size = payload.size();
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (ok && !payload.empty()) {
+        ok = fwrite(&payload[0], payload.size(), 1, fp) == 1;
+    }
+    ok = fclose(fp) == 0 && ok;
+
+    if (ok) {
+        // rename() does not replace an existing file on Windows
+        remove(path.c_str());
+        ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        remove(tmpPath.c_str());
+        FSERR(Log::k_FLG_IO, "AssetCache", "write", ("Cannot write cache %s\n", path.c_str()));
+        return false;
+    }
+
+    LOG(Log::k_FLG_IO, "AssetCache", "write", ("Cache %s written", path.c_str()));
+    return true;
+}
+
+/*!
+ * \param offset Offset of the data from the start of the payload
+ * \param size Size of the data
+ * \return NULL if the data is not entirely in the payload
+ */
+const void *AssetCache::at(uint32 offset, uint32 size) const {
+    if (offset > data_size_ || size > data_size_ - offset) {
+        return NULL;
+    }
+    return p_data_ + offset;
+}
@@ -0,0 +1,115 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef UTILS_ASSETCACHE_H_
+#define UTILS_ASSETCACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+/*!
+ * A file of the home directory holding data decoded from original files,
+ * so that the decoding is done only once.
+ * The file starts with a header giving the version of the format and the
+ * CRC of the original files the data was built from. If one of them
+ * changes, or if the format changes, the file is ignored and built again.
+ * The file is mapped read-only in memory and its data is used in place :
+ * it must stay open as long as objects point into it.
+ * Data is written in the byte order of the machine, so a cache file
+ * can't be shared between machines of different kinds.
+ * To use a cache : add the sources, then open the file. If it fails,
+ * build the data from the unpacked sources and write the file.
+ */
+class AssetCache {
+public:
+    /*! Version of the data format : change it when a format changes.*/
+    static const uint32 kVersion = 1;
+
+    //! Enables or disables the use of cache files
+    static void setEnabled(bool enabled) { enabled_ = enabled; }
+    //! Returns true if cache files are used
+    static bool isEnabled() { return enabled_; }
+
+    //! Appends data to a payload on a 4 bytes boundary and returns its offset
+    static uint32 append(std::vector<uint8> &payload, const void *data, size_t size);
+
+    AssetCache();
+    ~AssetCache();
+
+    //! Forgets sources and unmaps the cache file
+    void reset();
+    //! Reads an original file the data is built from
+    bool addSource(const std::string &filename);
+    //! Returns the uncompressed content of a source, to build the data
+    uint8 *unpackSource(size_t index, int &size);
+    //! Frees the content of the sources
+    void releaseSources();
+
+    //! Maps the cache file if it was built from the current sources
+    bool open(const std::string &name);
+    //! Unmaps the cache file
+    void close();
+    //! Writes the cache file for the current sources
+    bool write(const std::string &name, const std::vector<uint8> &payload);
+
+    //! Returns true if a cache file is mapped
+    bool isOpen() const { return p_data_ != NULL; }
+    //! Returns a pointer on the mapped data, NULL if out of the data
+    const void *at(uint32 offset, uint32 size) const;
+
+protected:
+    /*!
+     * Start of a cache file.
+     */
+    struct Header {
+        char magic[4];
+        uint32 version;
+        /*! CRC of the original files.*/
+        uint32 crc;
+        /*! Size of data following the header.*/
+        uint32 size;
+    };
+
+    static std::string pathOf(const std::string &name);
+
+protected:
+    static bool enabled_;
+    /*! Content of the original files, as read on disk, or NULL once released.*/
+    std::vector<uint8 *> sources_;
+    std::vector<int> source_sizes_;
+    std::vector<std::string> source_names_;
+    /*! CRC of the sources read so far.*/
+    uint32 crc_;
+    /*! Start of the mapping.*/
+    uint8 *p_map_;
+    size_t map_size_;
+    /*! Data following the header.*/
+    const uint8 *p_data_;
+    uint32 data_size_;
+#ifdef _WIN32
+    void *h_file_;
+    void *h_mapping_;
+#endif
+};
+
+#endif  // UTILS_ASSETCACHE_H_
@@ -0,0 +1,299 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <assert.h>
+
+#include "utils/assetloader.h"
+#include "utils/log.h"
+
+AssetLoader::AssetLoader() {
+    all_ = 0;
+    decoded_ = 0;
+    finished_ = 0;
+    failed_ = 0;
+    stopping_ = false;
+    p_mutex_ = SDL_CreateMutex();
+    p_work_cond_ = SDL_CreateCond();
+    p_done_cond_ = SDL_CreateCond();
+}
+
+AssetLoader::~AssetLoader() {
+    stop();
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        delete tasks_[i].pTask;
+    }
+    SDL_DestroyCond(p_done_cond_);
+    SDL_DestroyCond(p_work_cond_);
+    SDL_DestroyMutex(p_mutex_);
+}
+
+/*!
+ * \param id A mask with one bit set, not used by another task
+ * \param name Name of the task for the log
+ * \param pTask The task
+ * \param dependencies Mask of tasks that must be loaded before this one
+ */
+void AssetLoader::addTask(uint32 id, const char *name, AssetTask *pTask,
+        uint32 dependencies) {
+    assert(workers_.empty());
+    assert((id & all_) == 0);
+    assert((dependencies & ~all_) == 0);
+
+    Entry entry;
+    entry.id = id;
+    entry.name = name;
+    entry.pTask = pTask;
+    entry.dependencies = dependencies;
+    entry.state = kStateWaiting;
+    entry.time = 0;
+    tasks_.push_back(entry);
+    all_ |= id;
+}
+
+/*!
+ * \param nbThreads Number of worker threads, 0 to decode on the main thread
+ */
+void AssetLoader::start(int nbThreads) {
+    if (nbThreads > kMaxThreads) {
+        nbThreads = kMaxThreads;
+    }
+    if (nbThreads > (int) tasks_.size()) {
+        nbThreads = tasks_.size();
+    }
+
+    stopping_ = false;
+    for (int i = 0; i < nbThreads; i++) {
+        SDL_Thread *pThread = SDL_CreateThread(workerMain, this);
+        if (pThread == NULL) {
+            FSERR(Log::k_FLG_IO, "AssetLoader", "start",
+                ("Cannot create loader thread : %s\n", SDL_GetError()));
+            break;
+        }
+        workers_.push_back(pThread);
+    }
+}
+
+void AssetLoader::stop() {
+    SDL_LockMutex(p_mutex_);
+    stopping_ = true;
+    SDL_CondBroadcast(p_work_cond_);
+    SDL_UnlockMutex(p_mutex_);
+
+    for (size_t i = 0; i < workers_.size(); i++) {
+        SDL_WaitThread(workers_[i], NULL);
+    }
+    workers_.clear();
+}
+
+int AssetLoader::workerMain(void *pData) {
+    static_cast<AssetLoader *>(pData)->run();
+    return 0;
+}
+
+/*!
+ * Main loop of a worker thread : it ends when all tasks are decoded or
+ * being decoded.
+ */
+void AssetLoader::run() {
+    SDL_LockMutex(p_mutex_);
+    while (!stopping_) {
+        int index = nextTask();
+        if (index != -1) {
+            decode(index);
+            continue;
+        }
+
+        bool waiting = false;
+        for (size_t i = 0; i < tasks_.size(); i++) {
+            if (tasks_[i].state == kStateWaiting) {
+                waiting = true;
+                break;
+            }
+        }
+        if (!waiting) {
+            break;
+        }
+        // wait for the dependencies of the remaining tasks
+        SDL_CondWait(p_work_cond_, p_mutex_);
+    }
+    SDL_UnlockMutex(p_mutex_);
+}
+
+/*!
+ * Must be called with the mutex locked.
+ * \return The index of a task whose dependencies are decoded, -1 if none
+ */
+int AssetLoader::nextTask() {
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        if (tasks_[i].state == kStateWaiting
+            && (tasks_[i].dependencies & ~decoded_) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*!
+ * Must be called with the mutex locked : it is released while the task
+ * is decoding.
+ */
+void AssetLoader::decode(int index) {
+    Entry &entry = tasks_[index];
+    entry.state = kStateDecoding;
+    // a task is not decoded if one of its dependencies failed
+    bool ok = (entry.dependencies & failed_) == 0;
+    SDL_UnlockMutex(p_mutex_);
+
+    uint32 start = SDL_GetTicks();
+    if (ok) {
+        ok = entry.pTask->decode();
+    }
+    uint32 time = SDL_GetTicks() - start;
+
+    SDL_LockMutex(p_mutex_);
+    entry.time = time;
+    entry.state = kStateDecoded;
+    decoded_ |= entry.id;
+    if (!ok) {
+        failed_ |= entry.id;
+    }
+    // tasks depending on this one can start
+    SDL_CondBroadcast(p_work_cond_);
+    SDL_CondBroadcast(p_done_cond_);
+}
+
+bool AssetLoader::isDecoded(const Entry &entry) {
+    SDL_LockMutex(p_mutex_);
+    bool decoded = entry.state == kStateDecoded;
+    SDL_UnlockMutex(p_mutex_);
+    return decoded;
+}
+
+/*!
+ * Runs the last step of a decoded task, on the main thread.
+ */
+void AssetLoader::finish(Entry &entry) {
+    SDL_LockMutex(p_mutex_);
+    bool ok = (failed_ & (entry.id | entry.dependencies)) == 0;
+    SDL_UnlockMutex(p_mutex_);
+
+    if (ok) {
+        ok = entry.pTask->finish();
+    }
+    // decoded data is not needed anymore
+    delete entry.pTask;
+    entry.pTask = NULL;
+
+    SDL_LockMutex(p_mutex_);
+    entry.state = kStateFinished;
+    if (!ok) {
+        failed_ |= entry.id;
+    }
+    SDL_UnlockMutex(p_mutex_);
+    finished_ |= entry.id;
+
+    if (ok) {
+        LOG(Log::k_FLG_IO, "AssetLoader", "finish",
+            ("%s loaded, decoded in %d ms", entry.name, entry.time));
+    } else {
+        FSERR(Log::k_FLG_IO, "AssetLoader", "finish",
+            ("Failed loading %s\n", entry.name));
+    }
+}
+
+/*!
+ * Tasks are added after their dependencies, so a pass from the last task
+ * to the first collects all of them.
+ */
+uint32 AssetLoader::withDependencies(uint32 ids) const {
+    for (size_t i = tasks_.size(); i > 0; i--) {
+        if (tasks_[i - 1].id & ids) {
+            ids |= tasks_[i - 1].dependencies;
+        }
+    }
+    return ids;
+}
+
+/*!
+ * Tasks are finished in the order they were added, so dependencies are
+ * finished first.
+ * \param ids Mask of the tasks needed
+ * \return True if all of them were loaded
+ */
+bool AssetLoader::waitFor(uint32 ids) {
+    uint32 needed = withDependencies(ids);
+    if ((needed & ~finished_) != 0) {
+        for (size_t i = 0; i < tasks_.size(); i++) {
+            Entry &entry = tasks_[i];
+            if ((entry.id & needed) == 0 || (entry.id & finished_) != 0) {
+                continue;
+            }
+
+            SDL_LockMutex(p_mutex_);
+            while (entry.state != kStateDecoded) {
+                if (workers_.empty() && entry.state == kStateWaiting) {
+                    // dependencies were decoded in the previous loops
+                    decode(i);
+                } else {
+                    SDL_CondWait(p_done_cond_, p_mutex_);
+                }
+            }
+            SDL_UnlockMutex(p_mutex_);
+
+            finish(entry);
+        }
+    }
+
+    SDL_LockMutex(p_mutex_);
+    bool ok = (failed_ & ids) == 0;
+    SDL_UnlockMutex(p_mutex_);
+    return ok;
+}
+
+/*!
+ * Called by the main loop so that tasks are ready before being asked for.
+ */
+void AssetLoader::update() {
+    if (isIdle()) {
+        if (!workers_.empty()) {
+            stop();
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        Entry &entry = tasks_[i];
+        if ((entry.id & finished_) != 0
+            || (entry.dependencies & ~finished_) != 0) {
+            continue;
+        }
+
+        if (workers_.empty()) {
+            // decodes and finishes the task now
+            waitFor(entry.id);
+            return;
+        }
+        if (isDecoded(entry)) {
+            finish(entry);
+            return;
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef UTILS_ASSETLOADER_H_
+#define UTILS_ASSETLOADER_H_
+
+#include <vector>
+
+#include <SDL.h>
+
+#include "common.h"
+
+/*!
+ * A group of data loaded by the AssetLoader.
+ * Loading is cut in two steps : decode() reads and decodes the original
+ * files on a worker thread, then finish() hands the result to the game
+ * on the main thread. decode() must not use the screen, the audio device
+ * or any object the main thread may use before the task is finished.
+ */
+class AssetTask {
+public:
+    virtual ~AssetTask() {}
+
+    //! Reads and decodes the data, on a worker thread
+    virtual bool decode() = 0;
+    //! Makes the data available to the game, on the main thread
+    virtual bool finish() { return true; }
+};
+
+/*!
+ * Loads groups of data on worker threads.
+ * Each task is known by a bit of a mask. A task is decoded once all the
+ * tasks it depends on are decoded, and finished once they are finished,
+ * so a task must be added after its dependencies. All tasks are added
+ * before the loader is started.
+ * The main thread asks for the tasks it needs with waitFor() and lets
+ * the others be finished in the background by calling update() regularly.
+ * With no worker thread, tasks are decoded on the main thread, by
+ * waitFor() or one at a time by update().
+ * Loader must only be used from the main thread.
+ */
+class AssetLoader {
+public:
+    /*! Maximum number of worker threads.*/
+    static const int kMaxThreads = 8;
+
+    AssetLoader();
+    ~AssetLoader();
+
+    //! Adds a task, which is then owned by the loader
+    void addTask(uint32 id, const char *name, AssetTask *pTask,
+            uint32 dependencies = 0);
+    //! Starts decoding the tasks on worker threads
+    void start(int nbThreads);
+    //! Waits for the given tasks and their dependencies to be finished
+    bool waitFor(uint32 ids);
+    //! Finishes one task whose data is decoded, without waiting
+    void update();
+    //! Stops the workers once the running tasks are decoded
+    void stop();
+
+    //! Returns true if all tasks are finished
+    bool isIdle() const { return finished_ == all_; }
+
+protected:
+    /*!
+     * States of a task.
+     */
+    enum State {
+        kStateWaiting,
+        kStateDecoding,
+        kStateDecoded,
+        kStateFinished
+    };
+
+    /*!
+     * A task with its state.
+     */
+    struct Entry {
+        uint32 id;
+        const char *name;
+        AssetTask *pTask;
+        uint32 dependencies;
+        State state;
+        /*! Time spent decoding in ms.*/
+        uint32 time;
+    };
+
+    static int workerMain(void *pData);
+    void run();
+    int nextTask();
+    void decode(int index);
+    void finish(Entry &entry);
+    bool isDecoded(const Entry &entry);
+    uint32 withDependencies(uint32 ids) const;
+
+protected:
+    std::vector<Entry> tasks_;
+    std::vector<SDL_Thread *> workers_;
+    /*! Masks of all tasks, of decoded tasks and of finished tasks.*/
+    uint32 all_, decoded_, finished_;
+    /*! Mask of the tasks that failed.*/
+    uint32 failed_;
+    /*! True when workers must stop.*/
+    bool stopping_;
+    /*! Protects the states and the masks.*/
+    SDL_mutex *p_mutex_;
+    /*! Signaled when a task can be decoded.*/
+    SDL_cond *p_work_cond_;
+    /*! Signaled when a task is decoded.*/
+    SDL_cond *p_done_cond_;
+};
+
+#endif  // UTILS_ASSETLOADER_H_
@@ -22,6 +22,8 @@
  *                                                                      *
  ************************************************************************/
 
+#include <string.h>
+
 #include "dernc.h"
 
 namespace RNC_INTERNAL {
@@ -30,6 +32,10 @@ namespace RNC_INTERNAL {
         int bit_count;          // How many bits does bitbuf hold?
     };
 
+    // Number of bits decoded at once with the lookup table of a Huffman
+    // table : longer codes are searched in the nodes
+    static const int kLookupBits = 9;
+
     struct HuffmanTable {
         int node_count;         // Number of nodes in the tree
         struct {
@@ -37,12 +43,17 @@ namespace RNC_INTERNAL {
             int code_length;
             int value;
         } table[32];
+        // Value and length of the code starting with each sequence of
+        // kLookupBits bits, length 0 if the code is longer
+        struct {
+            uint8 value;
+            uint8 code_length;
+        } lookup[1 << kLookupBits];
     };
 
     static uint16 crc_table[256];
-    static bool is_crc_setup = false;
 
-    void setupCRCTable() {
+    bool setupCRCTable() {
         uint16 temp;
 
         for (int i = 0; i < 256; ++i) {
@@ -52,9 +63,14 @@ namespace RNC_INTERNAL {
                 temp = (temp & 1 ? (temp >> 1) ^ 0xA001 : temp >> 1);
 
             crc_table[i] = temp;
-        } is_crc_setup = true;
+        }
+        return true;
     }
 
+    // Table is built before main() as files can be unpacked by several
+    // threads at once
+    static const bool is_crc_setup = setupCRCTable();
+
     uint32 bitPeek(BitStream &bit_stream, uint32 mask) {
         return bit_stream.bit_buffer &mask;
     }
@@ -129,40 +145,63 @@ namespace RNC_INTERNAL {
         }
 
         huffman_table.node_count = node_count;
+
+        // Codes are filled from the last node so that the first node
+        // matching a sequence wins, as in a search of the nodes
+        memset(huffman_table.lookup, 0, sizeof(huffman_table.lookup));
+        for (int i = node_count - 1; i >= 0; --i) {
+            uint32 code = huffman_table.table[i].code;
+            int length = huffman_table.table[i].code_length;
+            if (length > kLookupBits || (code >> length) != 0)
+                continue;
+            for (uint32 k = code; k < (1 << kLookupBits); k += 1 << length) {
+                huffman_table.lookup[k].value = huffman_table.table[i].value;
+                huffman_table.lookup[k].code_length = length;
+            }
+        }
     }
 
     int readHuffmanData(HuffmanTable &huffman_table,
             BitStream &bit_stream, uint8 *&packed_data,
             uint8 *packed_data_end) {
-        int i;
-        uint32 mask;
+        int code_length, value;
+        int entry = bitPeek(bit_stream, (1 << kLookupBits) - 1);
+
+        if (huffman_table.lookup[entry].code_length != 0) {
+            code_length = huffman_table.lookup[entry].code_length;
+            value = huffman_table.lookup[entry].value;
+        } else {
+            int i;
+            uint32 mask;
+
+            for (i = 0; i < huffman_table.node_count; ++i) {
+                mask = (1 << huffman_table.table[i].code_length) - 1;
+                if (bitPeek(bit_stream, mask) == huffman_table.table[i].code)
+                    break;
+            }
 
-        for (i = 0; i < huffman_table.node_count; ++i) {
-            mask = (1 << huffman_table.table[i].code_length) - 1;
-            if (bitPeek(bit_stream, mask) == huffman_table.table[i].code)
-                break;
+            if (i == huffman_table.node_count)
+                return -1;
+            code_length = huffman_table.table[i].code_length;
+            value = huffman_table.table[i].value;
         }
 
-        if (i == huffman_table.node_count)
-            return -1;
         if ((packed_data + 2) < packed_data_end)
-            bitAdvance(bit_stream, huffman_table.table[i].code_length,
-                   packed_data);
+            bitAdvance(bit_stream, code_length, packed_data);
         else
-            bitAdvance8(bit_stream, huffman_table.table[i].code_length,
-                   packed_data, packed_data_end);
+            bitAdvance8(bit_stream, code_length, packed_data,
+                   packed_data_end);
 
-        uint32 result = huffman_table.table[i].value;
+        uint32 result = value;
 
         if (result >= 2) {
             result = 1 << (result - 1);
             if ((packed_data + 2) < packed_data_end)
-                result |= bitRead(bit_stream, result - 1,
-                        huffman_table.table[i].value - 1, packed_data);
+                result |= bitRead(bit_stream, result - 1, value - 1,
+                        packed_data);
             else
-                result |= bitRead8(bit_stream, result - 1,
-                        huffman_table.table[i].value - 1, packed_data,
-                        packed_data_end);
+                result |= bitRead8(bit_stream, result - 1, value - 1,
+                        packed_data, packed_data_end);
         }
 
         return result;
@@ -183,6 +222,31 @@ namespace RNC_INTERNAL {
         bit_stream.bit_count += 16;
     }
 
+    // Copies length bytes found position bytes before in the output.
+    // The source overlaps the destination when position < length : the
+    // output then repeats with a period of position bytes, so blocks are
+    // copied from further back each time, doubling their size.
+    void copyMatch(uint8 *output, int position, int length) {
+        if (position == 1) {
+            memset(output, output[-1], length);
+            return;
+        }
+        if (length <= 8) {
+            while (length--) {
+                *output = output[-position];
+                output++;
+            }
+            return;
+        }
+        while (length > position) {
+            memcpy(output, output - position, position);
+            output += position;
+            length -= position;
+            position *= 2;
+        }
+        memcpy(output, output - position, length);
+    }
+
     void bitReadFix8(BitStream &bit_stream, uint8 *&packed_data) {
         bit_stream.bit_count -= 16;
         // Remove the top 16 bits
@@ -225,9 +289,6 @@ int rnc::unpackedLength(uint8 *packed_data) {
 
 uint16 rnc::crc(uint8 *data, int data_length) {
     using namespace RNC_INTERNAL;
-    if (!is_crc_setup)
-        setupCRCTable();
-
     uint16 result = 0;
     do {
         result ^= *data++;
@@ -237,7 +298,14 @@ uint16 rnc::crc(uint8 *data, int data_length) {
     return result;
 }
 
-int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data) {
+/*!
+ * \param packed_data Content of a RNC file
+ * \param unpacked_data Buffer of unpackedLength() bytes
+ * \param check_crc False to skip the CRC checks, when the file content
+ * is known to be good
+ * \return The unpacked size or an error code
+ */
+int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data, bool check_crc) {
     using namespace RNC_INTERNAL;
 
     if (READ_BE_UINT32(packed_data) != RNC_SIGNATURE)
@@ -256,7 +324,7 @@ int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data) {
     uint8 *output_end = output + output_length;
 
     // Check the packed data's CRC
-    if (crc(input, input_end - input) != packed_crc)
+    if (check_crc && crc(input, input_end - input) != packed_crc)
         return PACKED_CRC_ERROR;
 
     BitStream bit_stream;
@@ -266,6 +334,10 @@ int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data) {
 
     // Process compressed chunks
     HuffmanTable raw_huff_tbl, dist_huff_tbl, len_huff_tbl;
+    // A chunk may keep the tables of the previous one : start empty
+    memset(&raw_huff_tbl, 0, sizeof(raw_huff_tbl));
+    memset(&dist_huff_tbl, 0, sizeof(dist_huff_tbl));
+    memset(&len_huff_tbl, 0, sizeof(len_huff_tbl));
     int length, position;
     uint32 ch_count;
     while (output < output_end) {
@@ -282,8 +354,12 @@ int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data) {
                 return HUF_DECODE_ERROR;
 
             if (length) {
-                while (length--)
-                    *output++ = *input++;
+                if (length > output_end - output
+                    || length > input_end - input)
+                    return FILE_SIZE_MISMATCH;
+                memcpy(output, input, length);
+                output += length;
+                input += length;
                 if ((input + 1) < input_end)
                     bitReadFix(bit_stream, input);
                 else
@@ -306,10 +382,11 @@ int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data) {
             position += 1;
             length += 2;
 
-            while (length--) {
-                *output = output[-position];
-                output++;
-            }
+            if (length > output_end - output
+                || position > output - unpacked_data)
+                return FILE_SIZE_MISMATCH;
+            copyMatch(output, position, length);
+            output += length;
         }
     }
 
@@ -318,7 +395,8 @@ int rnc::unpack(uint8 *packed_data, uint8 *unpacked_data) {
         return FILE_SIZE_MISMATCH;
 
     // Finally check our unpacked data's CRC
-    if (crc(output_end - output_length, output_length) != unpacked_crc)
+    if (check_crc
+        && crc(output_end - output_length, output_length) != unpacked_crc)
         return UNPACKED_CRC_ERROR;
 
     return output_length;
@@ -42,7 +42,8 @@ namespace rnc {
     const char *const errorString(int error_code);
     int unpackedLength(uint8 *packed_data);
     uint16 crc(uint8 *packed_data, int packed_length);
-    int unpack(uint8 *packed_data, uint8 *unpacked_data);
+    int unpack(uint8 *packed_data, uint8 *unpacked_data,
+            bool check_crc = true);
 
 }
 
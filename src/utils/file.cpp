@@ -48,6 +48,7 @@
 std::string File::dataPath_ = "./data/";
 std::string File::ourDataPath_ = "./data/";
 std::string File::homePath_ = "./";
+bool File::dataVerified_ = false;
 
 /*!
  * The methods returns a string composed of the root path and given file name.
@@ -75,6 +76,19 @@ std::string File::dataFullPath(const std::string& filename) {
     return ourDataPath_ + filename;
 }
 
+/*!
+ * \param filename Name of a file to put in the home directory.
+ */
+std::string File::homeFullPath(const std::string& filename) {
+    std::string path(homePath_);
+    if (!path.empty()) {
+        char c = path[path.size() - 1];
+        if (c != '\\' && c != '/')
+            path.append("/");
+    }
+    return path + filename;
+}
+
 void File::getFullPathForSaveSlot(int slot, std::string &path) {
     path.erase();
 
@@ -148,25 +162,37 @@ void File::setHomePath(const std::string& path) {
 
 uint8 *File::loadOriginalFile(const std::string& filename, int &filesize) {
     uint8 *data = loadOriginalFileToMem(filename, filesize);
+    return unpackOriginalFile(filename, data, filesize);
+}
+
+/*!
+ * \param filename Name of the file the data was read from
+ * \param data Content of the file, deleted if it is compressed
+ * \param filesize Size of data, then size of the returned buffer
+ * \return Uncompressed content of the file
+ */
+uint8 *File::unpackOriginalFile(const std::string& filename, uint8 *data, int &filesize) {
     if (data) {
         if (READ_BE_UINT32(data) == RNC_SIGNATURE) {    //File is RNC compressed
             filesize = rnc::unpackedLength(data);
             assert(filesize > 0);
             uint8 *buffer = new uint8[filesize + 1];
             buffer[filesize] = '\0';
-            int result = rnc::unpack(data, buffer);
+            int result = rnc::unpack(data, buffer, !dataVerified_);
             delete[] data;
 
             if (result < 0) {
                 FSERR(Log::k_FLG_IO, "File", "loadFile", ("Error loading file: %s!", rnc::errorString(result)));
                 filesize = 0;
                 delete[] buffer;
+                return NULL;
             }
 
             if (result != filesize) {
                 FSERR(Log::k_FLG_IO, "File", "loadFile", ("Uncompressed size mismatch for file %s!\n", filename.c_str()));
                 filesize = 0;
                 delete[] buffer;
+                return NULL;
             }
 
             return buffer;
@@ -260,3 +286,43 @@ void File::getGameSavedNames(std::vector<std::string> &files) {
     closedir(rep);
 #endif
 }
+
+/*!
+ * Names are returned without the directory. Nothing is returned if the
+ * directory does not exist.
+ * \param dir Path of the directory
+ * \param ext Extension of the files, with its dot
+ * \param files Names of the files found
+ */
+void File::listFiles(const std::string& dir, const std::string& ext,
+        std::vector<std::string> &files) {
+#ifdef _WIN32
+    WIN32_FIND_DATA File;
+    std::string pattern(dir);
+    pattern.append("/*");
+    pattern.append(ext);
+    HANDLE hSearch = FindFirstFile(pattern.c_str(), &File);
+    if (hSearch == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    do {
+        files.push_back(File.cFileName);
+    } while (FindNextFile(hSearch, &File));
+    FindClose(hSearch);
+#else
+    DIR *rep = opendir(dir.c_str());
+    if (rep == NULL) {
+        return;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(rep)) != NULL) {
+        std::string name(ent->d_name);
+        if (name.size() > ext.size()
+            && name.compare(name.size() - ext.size(), ext.size(), ext) == 0) {
+            files.push_back(name);
+        }
+    }
+    closedir(rep);
+#endif
+}
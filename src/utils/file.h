@@ -42,6 +42,8 @@ public:
     static void setOurDataPath(const std::string& path);
     //! Sets the path to the home of freesynd where freesynd.ini is.*/
     static void setHomePath(const std::string& path);
+    //! Tells whether original files are known to be good.*/
+    static void setDataVerified(bool verified) { dataVerified_ = verified; }
 
     static uint8 *loadOriginalFile(const std::string& filename, int &filesize);
     static FILE *openOriginalFile(const std::string& filename);
@@ -50,12 +52,19 @@ public:
     static std::string originalDataFullPath(const std::string& filename, bool uppercase);
     //! Returns the full path of the given resource using the current root path.
     static std::string dataFullPath(const std::string& filename);
+    //! Returns the full path of the given file in the home directory.
+    static std::string homeFullPath(const std::string& filename);
 
     //! Sets the filename fullpath for the given slot (from 0 to 9)
     static void getFullPathForSaveSlot(int slot, std::string &path);
     //! Returns the list of game saved names
     static void getGameSavedNames(std::vector<std::string> &files);
+    //! Returns the names of the files of a directory with the given extension
+    static void listFiles(const std::string& dir, const std::string& ext,
+            std::vector<std::string> &files);
     static uint8 *loadOriginalFileToMem(const std::string& filename, int &filesize);
+    //! Uncompresses the content of an original file if needed
+    static uint8 *unpackOriginalFile(const std::string& filename, uint8 *data, int &filesize);
 
 private:
     static void processSaveFile(const std::string& filename, std::vector<std::string> &files);
@@ -65,6 +74,11 @@ private:
     static std::string ourDataPath_;
     /*! The path to the freesynd.ini file and save directory.*/
     static std::string homePath_;
+    /*!
+     * True when original files have been checked against their reference
+     * checksums : the CRC of compressed files is then not computed.
+     */
+    static bool dataVerified_;
 };
 
 #endif
@@ -0,0 +1,239 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include "utils/profiler.h"
+#include "utils/log.h"
+
+bool Profiler::enabled_ = false;
+FILE *Profiler::p_trace_ = NULL;
+uint32 Profiler::trace_frames_ = 0;
+uint64 Profiler::frame_start_ = 0;
+uint32 Profiler::current_[kNbRows];
+uint32 Profiler::history_[kNbRows][kHistorySize];
+int Profiler::history_pos_ = 0;
+int Profiler::history_size_ = 0;
+Profiler::Entry Profiler::stack_[kMaxDepth];
+int Profiler::depth_ = 0;
+
+uint64 Profiler::now() {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // split to avoid an overflow on long uptimes
+    uint64 seconds = counter.QuadPart / frequency.QuadPart;
+    uint64 rest = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000 + rest * 1000000 / frequency.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64) tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+/*!
+ * Starts a new frame with an empty history.
+ */
+void Profiler::reset() {
+    frame_start_ = now();
+    memset(current_, 0, sizeof(current_));
+    history_pos_ = 0;
+    history_size_ = 0;
+}
+
+void Profiler::setEnabled(bool enabled) {
+    if (enabled && !isActive()) {
+        reset();
+    }
+    enabled_ = enabled;
+}
+
+/*!
+ * The file starts with a header line, then each frame is written on a
+ * line with the time of each row in microseconds.
+ * \param filename Path of the file, replaced if it exists
+ * \return False if the file could not be opened
+ */
+bool Profiler::startTrace(const char *filename) {
+    stopTrace();
+    FILE *pFile = fopen(filename, "w");
+    if (pFile == NULL) {
+        FSERR(Log::k_FLG_IO, "Profiler", "startTrace",
+            ("Cannot open trace file %s\n", filename));
+        return false;
+    }
+
+    if (!isActive()) {
+        reset();
+    }
+    fprintf(pFile, "index");
+    for (int row = 0; row < kNbRows; row++) {
+        fprintf(pFile, ",%s", rowName(row));
+    }
+    fprintf(pFile, "\n");
+    p_trace_ = pFile;
+    trace_frames_ = 0;
+    LOG(Log::k_FLG_IO, "Profiler", "startTrace", ("Writing frames to %s", filename));
+    return true;
+}
+
+void Profiler::stopTrace() {
+    if (p_trace_ != NULL) {
+        fclose(p_trace_);
+        p_trace_ = NULL;
+        LOG(Log::k_FLG_IO, "Profiler", "stopTrace", ("%u frames written", trace_frames_));
+    }
+}
+
+void Profiler::start(Section section) {
+    if (depth_ < kMaxDepth) {
+        Entry &entry = stack_[depth_];
+        entry.section = section;
+        entry.start = now();
+        entry.children = 0;
+    }
+    // sections too deep are not measured but still counted
+    // to match calls to stop()
+    depth_++;
+}
+
+void Profiler::stop() {
+    if (depth_ == 0) {
+        return;
+    }
+    depth_--;
+    if (depth_ >= kMaxDepth) {
+        return;
+    }
+
+    Entry &entry = stack_[depth_];
+    uint64 elapsed = now() - entry.start;
+    current_[entry.section] += (uint32) (elapsed - entry.children);
+    if (depth_ > 0) {
+        stack_[depth_ - 1].children += elapsed;
+    }
+}
+
+void Profiler::endFrame() {
+    if (!isActive()) {
+        return;
+    }
+
+    uint64 time = now();
+    uint32 work = 0;
+    for (int section = 0; section < kNbSections; section++) {
+        work += current_[section];
+    }
+    current_[kRowWork] = work;
+    current_[kRowFrame] = (uint32) (time - frame_start_);
+    frame_start_ = time;
+
+    for (int row = 0; row < kNbRows; row++) {
+        history_[row][history_pos_] = current_[row];
+    }
+    history_pos_ = (history_pos_ + 1) % kHistorySize;
+    if (history_size_ < kHistorySize) {
+        history_size_++;
+    }
+
+    if (p_trace_ != NULL) {
+        writeTraceFrame();
+    }
+    memset(current_, 0, sizeof(current_));
+}
+
+void Profiler::writeTraceFrame() {
+    fprintf(p_trace_, "%u", trace_frames_);
+    for (int row = 0; row < kNbRows; row++) {
+        fprintf(p_trace_, ",%u", current_[row]);
+    }
+    fprintf(p_trace_, "\n");
+    trace_frames_++;
+}
+
+/*!
+ * \param row A section or a value of Row
+ * \param pStats Statistics, all zero if no frame was recorded
+ */
+void Profiler::stats(int row, Stats *pStats) {
+    memset(pStats, 0, sizeof(Stats));
+    if (history_size_ == 0) {
+        return;
+    }
+
+    uint32 sorted[kHistorySize];
+    uint64 total = 0;
+    for (int i = 0; i < history_size_; i++) {
+        sorted[i] = history_[row][i];
+        total += sorted[i];
+    }
+    std::sort(sorted, sorted + history_size_);
+
+    pStats->min = sorted[0];
+    pStats->max = sorted[history_size_ - 1];
+    pStats->avg = (uint32) (total / history_size_);
+    // nearest rank
+    pStats->p99 = sorted[(history_size_ * 99 + 99) / 100 - 1];
+}
+
+/*!
+ * \param row A section or a value of Row
+ * \param bucketSize Duration covered by each bucket, in microseconds
+ * \param counts Number of frames in each bucket ; the last bucket
+ * also counts longer frames
+ * \param nbBuckets Size of counts
+ * \return The number of frames in the fullest bucket
+ */
+int Profiler::histogram(int row, uint32 bucketSize, int *counts, int nbBuckets) {
+    memset(counts, 0, nbBuckets * sizeof(int));
+    int maxCount = 0;
+    for (int i = 0; i < history_size_; i++) {
+        uint32 bucket = history_[row][i] / bucketSize;
+        if (bucket >= (uint32) nbBuckets) {
+            bucket = nbBuckets - 1;
+        }
+        counts[bucket]++;
+        if (counts[bucket] > maxCount) {
+            maxCount = counts[bucket];
+        }
+    }
+    return maxCount;
+}
+
+const char *Profiler::rowName(int row) {
+    static const char *names[kNbRows] = {
+        "events", "tick", "peds", "vehicles", "shots", "statics",
+        "map", "ui", "present", "work", "frame"
+    };
+    return names[row];
+}
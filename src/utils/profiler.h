@@ -0,0 +1,174 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef UTILS_PROFILER_H_
+#define UTILS_PROFILER_H_
+
+#include <stdio.h>
+
+#include "common.h"
+
+/*!
+ * Measures the time spent in each part of a frame.
+ * Code to measure is put in sections with a ProfileScope. Sections can
+ * be nested : the time of a section does not include the time of the
+ * sections run inside it, so the times of all sections add up to the
+ * time of the frame.
+ * The times of the last kHistorySize frames are kept to compute
+ * statistics, and each frame can be written to a CSV file.
+ * When the profiler is not active, a section costs only a test.
+ * Profiler must only be used from the main thread.
+ */
+class Profiler {
+public:
+    /*!
+     * Measured parts of a frame.
+     */
+    enum Section {
+        kSectionEvents = 0,
+        /*! Game tick, without the objects animation.*/
+        kSectionTick,
+        kSectionPeds,
+        kSectionVehicles,
+        kSectionShots,
+        /*! Statics, weapons on the ground and sfx objects.*/
+        kSectionStatics,
+        kSectionMapRender,
+        /*! Menu rendering, without the map.*/
+        kSectionUiRender,
+        kSectionPresent,
+        kNbSections
+    };
+
+    /*!
+     * Rows of statistics : one for each section plus those below.
+     */
+    enum Row {
+        /*! Sum of all sections.*/
+        kRowWork = kNbSections,
+        /*! Time between two frames, waits included.*/
+        kRowFrame,
+        kNbRows
+    };
+
+    /*!
+     * Statistics of a row over the history, in microseconds.
+     */
+    struct Stats {
+        uint32 min;
+        uint32 avg;
+        uint32 p99;
+        uint32 max;
+    };
+
+    /*! Number of frames kept for statistics.*/
+    static const int kHistorySize = 128;
+    /*! Maximum number of nested sections.*/
+    static const int kMaxDepth = 8;
+
+    //! Returns the current time in microseconds
+    static uint64 now();
+
+    //! Returns true if sections must be measured
+    static bool isActive() { return enabled_ || p_trace_ != NULL; }
+    //! Returns true if statistics are collected for display
+    static bool isEnabled() { return enabled_; }
+    //! Starts or stops collecting statistics
+    static void setEnabled(bool enabled);
+
+    //! Starts writing frames to the given file
+    static bool startTrace(const char *filename);
+    //! Stops writing frames and closes the file
+    static void stopTrace();
+    //! Returns true if frames are written to a file
+    static bool isTracing() { return p_trace_ != NULL; }
+
+    //! Enters a section
+    static void start(Section section);
+    //! Leaves the last section entered
+    static void stop();
+    //! Records the current frame and starts a new one
+    static void endFrame();
+
+    //! Returns the statistics of a row over the history
+    static void stats(int row, Stats *pStats);
+    //! Counts frames of the history by duration
+    static int histogram(int row, uint32 bucketSize, int *counts, int nbBuckets);
+    //! Returns a short name for the row
+    static const char *rowName(int row);
+
+private:
+    static void reset();
+    static void writeTraceFrame();
+
+    static bool enabled_;
+    /*! Trace file or NULL.*/
+    static FILE *p_trace_;
+    /*! Number of frames written to the trace file.*/
+    static uint32 trace_frames_;
+    /*! Start of the current frame.*/
+    static uint64 frame_start_;
+    /*! Time spent in each section during the current frame.*/
+    static uint32 current_[kNbRows];
+    /*! Times of the last frames, for each row.*/
+    static uint32 history_[kNbRows][kHistorySize];
+    /*! Next entry of history_ to write.*/
+    static int history_pos_;
+    /*! Number of valid entries in history_.*/
+    static int history_size_;
+
+    /*!
+     * An entered section.
+     */
+    struct Entry {
+        Section section;
+        uint64 start;
+        /*! Time spent in sections entered from this one.*/
+        uint64 children;
+    };
+
+    static Entry stack_[kMaxDepth];
+    static int depth_;
+};
+
+/*!
+ * Measures a section from its construction to its destruction.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(Profiler::Section section) {
+        active_ = Profiler::isActive();
+        if (active_) {
+            Profiler::start(section);
+        }
+    }
+
+    ~ProfileScope() {
+        if (active_) {
+            Profiler::stop();
+        }
+    }
+
+private:
+    bool active_;
+};
+
+#endif  // UTILS_PROFILER_H_
@@ -0,0 +1,194 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <math.h>
+
+#include "visibilitycache.h"
+#include "mission.h"
+
+VisibilityCache::VisibilityCache() {
+    hits_ = 0;
+    misses_ = 0;
+    clear();
+}
+
+void VisibilityCache::clear() {
+    for (int i = 0; i < kNbEntries; i++) {
+        entries_[i].used = false;
+    }
+}
+
+/*!
+ * Slot depends only on the tiles of both ends.
+ */
+int VisibilityCache::slotOf(const int originTile[3], const int targetTile[3]) {
+    uint32 h = (uint32) originTile[0] * 73856093u;
+    h ^= (uint32) originTile[1] * 19349663u;
+    h ^= (uint32) originTile[2] * 83492791u;
+    h ^= (uint32) targetTile[0] * 2654435761u;
+    h ^= (uint32) targetTile[1] * 40503u;
+    h ^= (uint32) targetTile[2] * 3266489917u;
+    h ^= h >> 15;
+    return h & (kNbEntries - 1);
+}
+
+/*!
+ * \return False if the position is out of the map
+ */
+bool VisibilityCache::tileOf(Mission *pMission, const WorldPoint &pos, int tile[3]) {
+    if (pos.x < 0 || pos.y < 0 || pos.z < 0
+        || pos.x >= pMission->mmax_x_ * 256 || pos.y >= pMission->mmax_y_ * 256
+        || pos.z > (pMission->mmax_z_ - 1) * 128) {
+        return false;
+    }
+    tile[0] = pos.x / 256;
+    tile[1] = pos.y / 256;
+    tile[2] = pos.z / 128;
+    return true;
+}
+
+/*!
+ * A line between two points of the tiles stays inside the box joining
+ * them, so it crosses only tiles of the box.
+ * \return True if no tile of the box can block a line
+ */
+bool VisibilityCache::isBoxClear(Mission *pMission, const int originTile[3],
+        const int targetTile[3]) {
+    int low[3], high[3];
+    for (int a = 0; a < 3; a++) {
+        low[a] = originTile[a] < targetTile[a] ? originTile[a] : targetTile[a];
+        high[a] = originTile[a] < targetTile[a] ? targetTile[a] : originTile[a];
+    }
+
+    for (int z = low[2]; z <= high[2]; z++) {
+        for (int y = low[1]; y <= high[1]; y++) {
+            const uint8 *row = pMission->mtsurfaces_ + y * pMission->mmax_x_
+                + z * pMission->mmax_m_xy;
+            for (int x = low[0]; x <= high[0]; x++) {
+                // same tiles as the ones Mission::checkBlockedByTile()
+                // lets lines through
+                if (row[x] != 0x00 && row[x] != 0x0C && row[x] != 0x10) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+ * Gives the result of Mission::checkBlockedByTile() for a line that
+ * no tile blocks : only the range limits it.
+ */
+uint8 VisibilityCache::checkClearLine(const WorldPoint &originPosW,
+        WorldPoint *pTargetPosW, double distanceMax, double *pInitialDistance) {
+    int dx = pTargetPosW->x - originPosW.x;
+    int dy = pTargetPosW->y - originPosW.y;
+    int dz = pTargetPosW->z - originPosW.z;
+    double distanceToTarget = sqrt((double) (dx * dx + dy * dy + dz * dz));
+    if (pInitialDistance) {
+        *pInitialDistance = distanceToTarget;
+    }
+    if (distanceToTarget == 0 || distanceToTarget < distanceMax) {
+        return 1;
+    }
+
+    double dist_k = distanceMax / distanceToTarget;
+    pTargetPosW->x = originPosW.x + (int) (dx * dist_k);
+    pTargetPosW->y = originPosW.y + (int) (dy * dist_k);
+    pTargetPosW->z = originPosW.z + (int) (dz * dist_k);
+    return 8;
+}
+
+/*!
+ * \param pMission Mission whose tiles are checked
+ * \param originPosW Line starting point
+ * \param pTargetPosW Line end point, updated if a tile blocks the line or
+ *  if distanceMax is reached
+ * \param distanceMax Maximum distance to cross
+ * \param pInitialDistance If not null, receives the distance between
+ *  origin and initial target position
+ * \return same bitmask as Mission::checkBlockedByTile()
+ */
+uint8 VisibilityCache::checkBlockedByTile(Mission *pMission, const WorldPoint &originPosW,
+        WorldPoint *pTargetPosW, double distanceMax, double *pInitialDistance) {
+    int originTile[3], targetTile[3];
+    if (!tileOf(pMission, originPosW, originTile)
+        || !tileOf(pMission, *pTargetPosW, targetTile)) {
+        misses_++;
+        return pMission->checkBlockedByTile(originPosW, pTargetPosW, true,
+            distanceMax, pInitialDistance);
+    }
+
+    Entry &entry = entries_[slotOf(originTile, targetTile)];
+    bool found = entry.used && entry.version == pMission->surfacesVersion();
+    for (int a = 0; found && a < 3; a++) {
+        found = entry.originTile[a] == originTile[a]
+            && entry.targetTile[a] == targetTile[a];
+    }
+    if (!found) {
+        entry.used = true;
+        entry.version = pMission->surfacesVersion();
+        for (int a = 0; a < 3; a++) {
+            entry.originTile[a] = originTile[a];
+            entry.targetTile[a] = targetTile[a];
+        }
+        entry.clear = isBoxClear(pMission, originTile, targetTile);
+        entry.hasLine = false;
+    }
+
+    if (entry.clear) {
+        if (found) {
+            hits_++;
+        } else {
+            misses_++;
+        }
+        return checkClearLine(originPosW, pTargetPosW, distanceMax, pInitialDistance);
+    }
+
+    if (entry.hasLine && entry.distanceMax == distanceMax
+        && entry.origin.x == originPosW.x && entry.origin.y == originPosW.y
+        && entry.origin.z == originPosW.z
+        && entry.target.x == pTargetPosW->x && entry.target.y == pTargetPosW->y
+        && entry.target.z == pTargetPosW->z) {
+        hits_++;
+        *pTargetPosW = entry.reached;
+        if (pInitialDistance) {
+            *pInitialDistance = entry.initialDistance;
+        }
+        return entry.mask;
+    }
+
+    misses_++;
+    entry.hasLine = true;
+    entry.origin = originPosW;
+    entry.target = *pTargetPosW;
+    entry.distanceMax = distanceMax;
+    entry.initialDistance = 0;
+    entry.mask = pMission->checkBlockedByTile(originPosW, pTargetPosW, true,
+        distanceMax, &entry.initialDistance);
+    entry.reached = *pTargetPosW;
+    if (pInitialDistance) {
+        *pInitialDistance = entry.initialDistance;
+    }
+
+    return entry.mask;
+}
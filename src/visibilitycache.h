@@ -0,0 +1,102 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef VISIBILITYCACHE_H
+#define VISIBILITYCACHE_H
+
+#include "common.h"
+#include "model/position.h"
+
+class Mission;
+
+/*!
+ * Cache of tile checks on lines of sight.
+ * Hostile detection checks the same lines again and again while peds
+ * stand still, and only walls and floors are involved so the result
+ * stays the same as long as both ends don't move.
+ * Entries are keyed by the pair of tiles of both ends. When all tiles in
+ * the box joining the two tiles let lines through, every line between
+ * them is free and the entry answers whatever the ends inside the tiles
+ * and the range : moving peds keep finding it until one of them changes
+ * tile. Otherwise the line may be blocked depending on where the ends
+ * are, and the entry answers only a check with the exact same ends and
+ * range. All entries are dropped when the surfaces of the mission change.
+ * Objects (doors, windows, cars, peds) are not part of the cache : they
+ * are still checked each time with Mission::checkBlockedByObject().
+ */
+class VisibilityCache {
+public:
+    /*! Number of entries, must be a power of 2.*/
+    static const int kNbEntries = 1024;
+
+    VisibilityCache();
+
+    //! Same as Mission::checkBlockedByTile() with updateLoc set to true
+    uint8 checkBlockedByTile(Mission *pMission, const WorldPoint &originPosW,
+            WorldPoint *pTargetPosW, double distanceMax, double *pInitialDistance);
+    //! Forgets all lines
+    void clear();
+
+    //! Returns the number of checks answered by the cache
+    uint32 hits() { return hits_; }
+    //! Returns the number of checks computed
+    uint32 misses() { return misses_; }
+
+protected:
+    /*!
+     * A line checked against tiles.
+     */
+    struct Entry {
+        /*! True if entry holds a result.*/
+        bool used;
+        /*! Surfaces version when entry was stored.*/
+        uint32 version;
+        /*! Tiles of both ends.*/
+        int originTile[3];
+        int targetTile[3];
+        /*! True if no tile of the box joining both tiles blocks lines.*/
+        bool clear;
+        /*! True if the fields below hold the check of a line.*/
+        bool hasLine;
+        WorldPoint origin;
+        WorldPoint target;
+        double distanceMax;
+        /*! Result of Mission::checkBlockedByTile().*/
+        uint8 mask;
+        /*! Target position updated by the check.*/
+        WorldPoint reached;
+        double initialDistance;
+    };
+
+    int slotOf(const int originTile[3], const int targetTile[3]);
+    static bool tileOf(Mission *pMission, const WorldPoint &pos, int tile[3]);
+    static bool isBoxClear(Mission *pMission, const int originTile[3],
+            const int targetTile[3]);
+    static uint8 checkClearLine(const WorldPoint &originPosW,
+            WorldPoint *pTargetPosW, double distanceMax, double *pInitialDistance);
+
+protected:
+    Entry entries_[kNbEntries];
+    uint32 hits_;
+    uint32 misses_;
+};
+
+#endif  // VISIBILITYCACHE_H